@@ -3,6 +3,7 @@
 
 using System;
 using System.Runtime.InteropServices;
+using NewRelic.Agent.Core.ThreadProfiling;
 
 namespace NewRelic.Agent.Core;
 
@@ -11,10 +12,21 @@ public interface INativeMethods
     void ReleaseProfile();
     int RequestFunctionNames(UIntPtr[] functionIds, int length, [Out] out IntPtr functionInfo);
     int RequestProfile([Out] out IntPtr snapshots, [Out] out int length);
+    int RequestCompactProfile(int version, [Out] out IntPtr profile, [Out] out int length);
+    int GetProfileTimings(out ProfileTimings timings);
     void ShutdownNativeThreadProfiler();
 
+    int StartContinuousProfiling(int samplesPerSecond);
+    int StopContinuousProfiling();
+    int SwapCallTree([Out] out IntPtr nodes, [Out] out int length);
+    int GetCallTreeTimings(out ProfileTimings timings);
+    int SetCurrentThreadTag(ulong tag);
+    int ClearCurrentThreadTag();
+    void SetTaggedThreadsOnly(bool taggedThreadsOnly);
+
     int InstrumentationRefresh();
     int ReloadConfiguration();
     int AddCustomInstrumentation(string fileName, string xml);
     int ApplyCustomInstrumentation();
+    int GetInstrumentationRefreshStatus(out ulong requestedGeneration, out ulong completedGeneration);
 }
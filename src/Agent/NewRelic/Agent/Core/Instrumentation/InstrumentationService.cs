@@ -1,6 +1,8 @@
 // Copyright 2020 New Relic, Inc. All rights reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+using System;
+using System.Threading;
 using NewRelic.Agent.Extensions.Logging;
 
 namespace NewRelic.Agent.Core.Instrumentation;
@@ -11,6 +13,7 @@ public interface IInstrumentationService
     bool ClearLiveInstrumentation();
     void ApplyInstrumentation();
     int InstrumentationRefresh();
+    bool WaitForInstrumentationRefresh(TimeSpan timeout, out int result);
 }
 
 public class InstrumentationService : IInstrumentationService
@@ -18,6 +21,7 @@ public class InstrumentationService : IInstrumentationService
     private readonly INativeMethods _nativeMethods;
     private readonly IInstrumentationStore _liveInstrumentationStore = new InstrumentationStore();
     private readonly object _nativeMethodsLock = new object();
+    private static readonly TimeSpan RefreshStatusPollInterval = TimeSpan.FromMilliseconds(100);
 
     public InstrumentationService(INativeMethods nativeMethods)
     {
@@ -52,6 +56,27 @@ public class InstrumentationService : IInstrumentationService
         }
     }
 
+    // The profiler applies refreshes on its own thread, this waits until every refresh requested so far has finished.
+    // Returns false if they haven't by the timeout. result is the outcome of the most recent refresh to finish, or the
+    // error from asking the profiler for it.
+    public bool WaitForInstrumentationRefresh(TimeSpan timeout, out int result)
+    {
+        result = _nativeMethods.GetInstrumentationRefreshStatus(out var requestedGeneration, out var completedGeneration);
+        var deadline = DateTime.UtcNow + timeout;
+        while (result >= 0 && completedGeneration < requestedGeneration)
+        {
+            if (DateTime.UtcNow >= deadline)
+            {
+                return false;
+            }
+
+            Thread.Sleep(RefreshStatusPollInterval);
+            result = _nativeMethods.GetInstrumentationRefreshStatus(out _, out completedGeneration);
+        }
+
+        return true;
+    }
+
     public void AddOrUpdateLiveInstrumentation(string name, string xml)
     {
         _liveInstrumentationStore.AddOrUpdateInstrumentation(name, xml);
@@ -14,6 +14,7 @@ namespace NewRelic.Agent.Core.Instrumentation;
 public class InstrumentationWatcher : IDisposable
 {
     private const int RequestRejitDelayMilliseconds = 15000;
+    private static readonly TimeSpan RefreshTimeout = TimeSpan.FromMinutes(1);
 
     private readonly IInstrumentationService _instrumentationService;
     private readonly IWrapperService _wrapperService;
@@ -69,9 +70,18 @@ public class InstrumentationWatcher : IDisposable
     private void RequestRejit()
     {
         Log.Info("Starting instrumentation refresh from InstrumentationWatcher");
-        var result = _instrumentationService.InstrumentationRefresh();
+        // the profiler only queues the refresh, its result is reported once it has run
+        _instrumentationService.InstrumentationRefresh();
+        var finished = _instrumentationService.WaitForInstrumentationRefresh(RefreshTimeout, out var result);
         _wrapperService.ClearCaches();
-        Log.Info("Completed instrumentation refresh from InstrumentationWatcher: {0}", result);
+        if (finished)
+        {
+            Log.Info("Completed instrumentation refresh from InstrumentationWatcher: {0}", result);
+        }
+        else
+        {
+            Log.Warn("Instrumentation refresh from InstrumentationWatcher did not finish within {0}", RefreshTimeout);
+        }
     }
 
     private void OnChanged(object sender, FileSystemEventArgs e)
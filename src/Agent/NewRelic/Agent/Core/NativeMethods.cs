@@ -3,6 +3,7 @@
 
 using System;
 using System.Runtime.InteropServices;
+using NewRelic.Agent.Core.ThreadProfiling;
 using NewRelic.Agent.Extensions.Logging;
 
 namespace NewRelic.Agent.Core;
@@ -23,6 +24,9 @@ public class LinuxNativeMethods : INativeMethods
     [DllImport(DllName, EntryPoint = "ApplyCustomInstrumentation", CallingConvention = CallingConvention.Cdecl)]
     private static extern int ExternApplyCustomInstrumentation();
 
+    [DllImport(DllName, EntryPoint = "GetInstrumentationRefreshStatus", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternGetInstrumentationRefreshStatus(out ulong requestedGeneration, out ulong completedGeneration);
+
     public int InstrumentationRefresh()
     {
         try
@@ -59,6 +63,21 @@ public class LinuxNativeMethods : INativeMethods
         return ExternApplyCustomInstrumentation();
     }
 
+    public int GetInstrumentationRefreshStatus(out ulong requestedGeneration, out ulong completedGeneration)
+    {
+        try
+        {
+            return ExternGetInstrumentationRefreshStatus(out requestedGeneration, out completedGeneration);
+        }
+        catch (Exception ex)
+        {
+            Log.Error(ex, "LinuxNativeMethods.GetInstrumentationRefreshStatus() exception");
+            requestedGeneration = 0;
+            completedGeneration = 0;
+            return -1;
+        }
+    }
+
     [DllImport(DllName, EntryPoint = "ShutdownThreadProfiler", CallingConvention = CallingConvention.Cdecl)]
     private static extern void ExternShutdownThreadProfiler();
 
@@ -68,9 +87,36 @@ public class LinuxNativeMethods : INativeMethods
     [DllImport(DllName, EntryPoint = "RequestProfile", CallingConvention = CallingConvention.Cdecl)]
     private static extern int ExternRequestProfile([Out] out IntPtr snapshots, [Out] out int length);
 
+    [DllImport(DllName, EntryPoint = "RequestCompactProfile", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternRequestCompactProfile(int version, [Out] out IntPtr profile, [Out] out int length);
+
     [DllImport(DllName, EntryPoint = "RequestFunctionNames", CallingConvention = CallingConvention.Cdecl)]
     private static extern int ExternRequestFunctionNames(UIntPtr[] functionIds, int length, [Out] out IntPtr functionInfo);
 
+    [DllImport(DllName, EntryPoint = "StartContinuousProfiling", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternStartContinuousProfiling(int samplesPerSecond);
+
+    [DllImport(DllName, EntryPoint = "StopContinuousProfiling", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternStopContinuousProfiling();
+
+    [DllImport(DllName, EntryPoint = "SwapCallTree", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternSwapCallTree([Out] out IntPtr nodes, [Out] out int length);
+
+    [DllImport(DllName, EntryPoint = "GetProfileTimings", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternGetProfileTimings(out ProfileTimings timings);
+
+    [DllImport(DllName, EntryPoint = "GetCallTreeTimings", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternGetCallTreeTimings(out ProfileTimings timings);
+
+    [DllImport(DllName, EntryPoint = "SetCurrentThreadTag", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternSetCurrentThreadTag(ulong tag);
+
+    [DllImport(DllName, EntryPoint = "ClearCurrentThreadTag", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternClearCurrentThreadTag();
+
+    [DllImport(DllName, EntryPoint = "SetTaggedThreadsOnly", CallingConvention = CallingConvention.Cdecl)]
+    private static extern void ExternSetTaggedThreadsOnly([MarshalAs(UnmanagedType.U1)] bool taggedThreadsOnly);
+
     public void ReleaseProfile()
     {
         ExternReleaseProfile();
@@ -86,10 +132,55 @@ public class LinuxNativeMethods : INativeMethods
         return ExternRequestProfile(out snapshots, out length);
     }
 
+    public int RequestCompactProfile(int version, [Out] out IntPtr profile, [Out] out int length)
+    {
+        return ExternRequestCompactProfile(version, out profile, out length);
+    }
+
     public void ShutdownNativeThreadProfiler()
     {
         ExternShutdownThreadProfiler();
     }
+
+    public int StartContinuousProfiling(int samplesPerSecond)
+    {
+        return ExternStartContinuousProfiling(samplesPerSecond);
+    }
+
+    public int StopContinuousProfiling()
+    {
+        return ExternStopContinuousProfiling();
+    }
+
+    public int SwapCallTree([Out] out IntPtr nodes, [Out] out int length)
+    {
+        return ExternSwapCallTree(out nodes, out length);
+    }
+
+    public int GetProfileTimings(out ProfileTimings timings)
+    {
+        return ExternGetProfileTimings(out timings);
+    }
+
+    public int GetCallTreeTimings(out ProfileTimings timings)
+    {
+        return ExternGetCallTreeTimings(out timings);
+    }
+
+    public int SetCurrentThreadTag(ulong tag)
+    {
+        return ExternSetCurrentThreadTag(tag);
+    }
+
+    public int ClearCurrentThreadTag()
+    {
+        return ExternClearCurrentThreadTag();
+    }
+
+    public void SetTaggedThreadsOnly(bool taggedThreadsOnly)
+    {
+        ExternSetTaggedThreadsOnly(taggedThreadsOnly);
+    }
 }
 
 public class WindowsNativeMethods : INativeMethods
@@ -108,6 +199,9 @@ public class WindowsNativeMethods : INativeMethods
     [DllImport(DllName, EntryPoint = "ApplyCustomInstrumentation", CallingConvention = CallingConvention.Cdecl)]
     private static extern int ExternApplyCustomInstrumentation();
 
+    [DllImport(DllName, EntryPoint = "GetInstrumentationRefreshStatus", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternGetInstrumentationRefreshStatus(out ulong requestedGeneration, out ulong completedGeneration);
+
     public int InstrumentationRefresh()
     {
         try
@@ -144,6 +238,21 @@ public class WindowsNativeMethods : INativeMethods
         return ExternApplyCustomInstrumentation();
     }
 
+    public int GetInstrumentationRefreshStatus(out ulong requestedGeneration, out ulong completedGeneration)
+    {
+        try
+        {
+            return ExternGetInstrumentationRefreshStatus(out requestedGeneration, out completedGeneration);
+        }
+        catch (Exception ex)
+        {
+            Log.Error(ex, "WindowsNativeMethods.GetInstrumentationRefreshStatus() exception");
+            requestedGeneration = 0;
+            completedGeneration = 0;
+            return -1;
+        }
+    }
+
 
     [DllImport(DllName, EntryPoint = "ShutdownThreadProfiler", CallingConvention = CallingConvention.Cdecl)]
     private static extern void ExternShutdownThreadProfiler();
@@ -154,9 +263,36 @@ public class WindowsNativeMethods : INativeMethods
     [DllImport(DllName, EntryPoint = "RequestProfile", CallingConvention = CallingConvention.Cdecl)]
     private static extern int ExternRequestProfile([Out] out IntPtr snapshots, [Out] out int length);
 
+    [DllImport(DllName, EntryPoint = "RequestCompactProfile", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternRequestCompactProfile(int version, [Out] out IntPtr profile, [Out] out int length);
+
     [DllImport(DllName, EntryPoint = "RequestFunctionNames", CallingConvention = CallingConvention.Cdecl)]
     private static extern int ExternRequestFunctionNames(UIntPtr[] functionIds, int length, [Out] out IntPtr functionInfo);
 
+    [DllImport(DllName, EntryPoint = "StartContinuousProfiling", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternStartContinuousProfiling(int samplesPerSecond);
+
+    [DllImport(DllName, EntryPoint = "StopContinuousProfiling", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternStopContinuousProfiling();
+
+    [DllImport(DllName, EntryPoint = "SwapCallTree", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternSwapCallTree([Out] out IntPtr nodes, [Out] out int length);
+
+    [DllImport(DllName, EntryPoint = "GetProfileTimings", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternGetProfileTimings(out ProfileTimings timings);
+
+    [DllImport(DllName, EntryPoint = "GetCallTreeTimings", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternGetCallTreeTimings(out ProfileTimings timings);
+
+    [DllImport(DllName, EntryPoint = "SetCurrentThreadTag", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternSetCurrentThreadTag(ulong tag);
+
+    [DllImport(DllName, EntryPoint = "ClearCurrentThreadTag", CallingConvention = CallingConvention.Cdecl)]
+    private static extern int ExternClearCurrentThreadTag();
+
+    [DllImport(DllName, EntryPoint = "SetTaggedThreadsOnly", CallingConvention = CallingConvention.Cdecl)]
+    private static extern void ExternSetTaggedThreadsOnly([MarshalAs(UnmanagedType.U1)] bool taggedThreadsOnly);
+
     public void ReleaseProfile()
     {
         ExternReleaseProfile();
@@ -172,8 +308,53 @@ public class WindowsNativeMethods : INativeMethods
         return ExternRequestProfile(out snapshots, out length);
     }
 
+    public int RequestCompactProfile(int version, [Out] out IntPtr profile, [Out] out int length)
+    {
+        return ExternRequestCompactProfile(version, out profile, out length);
+    }
+
     public void ShutdownNativeThreadProfiler()
     {
         ExternShutdownThreadProfiler();
     }
+
+    public int StartContinuousProfiling(int samplesPerSecond)
+    {
+        return ExternStartContinuousProfiling(samplesPerSecond);
+    }
+
+    public int StopContinuousProfiling()
+    {
+        return ExternStopContinuousProfiling();
+    }
+
+    public int SwapCallTree([Out] out IntPtr nodes, [Out] out int length)
+    {
+        return ExternSwapCallTree(out nodes, out length);
+    }
+
+    public int GetProfileTimings(out ProfileTimings timings)
+    {
+        return ExternGetProfileTimings(out timings);
+    }
+
+    public int GetCallTreeTimings(out ProfileTimings timings)
+    {
+        return ExternGetCallTreeTimings(out timings);
+    }
+
+    public int SetCurrentThreadTag(ulong tag)
+    {
+        return ExternSetCurrentThreadTag(tag);
+    }
+
+    public int ClearCurrentThreadTag()
+    {
+        return ExternClearCurrentThreadTag();
+    }
+
+    public void SetTaggedThreadsOnly(bool taggedThreadsOnly)
+    {
+        ExternSetTaggedThreadsOnly(taggedThreadsOnly);
+    }
 }
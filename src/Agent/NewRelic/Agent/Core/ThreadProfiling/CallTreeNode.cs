@@ -0,0 +1,27 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+using System;
+
+namespace NewRelic.Agent.Core.ThreadProfiling;
+
+/// <summary>
+/// One node of the call tree returned by the profiler's SwapCallTree.  Matches MarshaledCallTreeNode in the profiler's
+/// CallTree.h.  Node 0 is the root, its children are one node per thread tag, and a node's parent always comes before it.
+/// </summary>
+public struct CallTreeNode
+{
+    /// <summary>The size of a MarshaledCallTreeNode, the same on 32 and 64 bit.  The function id is written as 8 bytes.</summary>
+    public const int NativeSize = 48;
+
+    /// <summary>Zero for the root and the tag nodes.</summary>
+    public UIntPtr FunctionId;
+    public ulong Tag;
+    public ulong CpuTimeNanoseconds;
+    public ulong SelfCpuTimeNanoseconds;
+    /// <summary>-1 for the root.</summary>
+    public int ParentIndex;
+    public int HitCount;
+    public int SelfHitCount;
+    public int RunningHitCount;
+}
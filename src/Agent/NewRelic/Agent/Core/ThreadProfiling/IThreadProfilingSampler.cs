@@ -7,4 +7,5 @@ public interface IThreadProfilingSampler
 {
     bool Start(uint frequencyInMsec, uint durationInMsec, ISampleSink sampleSink, INativeMethods nativeMethods);
     void Stop();
+    CallTreeNode[] SwapCallTree(out int hresult);
 }
\ No newline at end of file
@@ -0,0 +1,25 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+using System.Runtime.InteropServices;
+
+namespace NewRelic.Agent.Core.ThreadProfiling;
+
+/// <summary>
+/// How long a thread profile, or the samples merged into a call tree, kept the runtime suspended and how long the
+/// profiler spent resolving function names afterwards.  Matches ProfileTimings in the profiler's ThreadProfiler.h.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct ProfileTimings
+{
+    /// <summary>1 for a profile, the number of samples for a call tree.</summary>
+    public ulong SnapshotCount;
+    public ulong ThreadCount;
+    public ulong PauseCount;
+    public ulong TotalPauseMicroseconds;
+    public ulong LongestPauseMicroseconds;
+    /// <summary>From the first suspend to the last resume, including the time between pauses.</summary>
+    public ulong SnapshotMicroseconds;
+    public ulong ResolvedFunctionCount;
+    public ulong ResolveMicroseconds;
+}
@@ -127,6 +127,8 @@ public class ThreadProfilingSampler : IThreadProfilingSampler
         {
             threadSnapshots = GetProfile(out hresult);
             //hresult is passed to caller to know if there was an error
+            if (hresult >= 0)
+                LogProfileTimings();
         }
         finally
         {
@@ -136,6 +138,41 @@ public class ThreadProfilingSampler : IThreadProfilingSampler
     }
 
 
+    private void LogProfileTimings()
+    {
+        if (!Log.IsFinestEnabled || _nativeMethods.GetProfileTimings(out var timings) < 0)
+            return;
+
+        Log.Finest($"Thread profile of {timings.ThreadCount} threads paused the runtime {timings.PauseCount} times for {timings.TotalPauseMicroseconds}us, the longest {timings.LongestPauseMicroseconds}us. Snapshot took {timings.SnapshotMicroseconds}us, resolving {timings.ResolvedFunctionCount} new function names {timings.ResolveMicroseconds}us.");
+    }
+
+    /// <summary>
+    /// Takes the call tree the profiler has merged its samples into since the last call.
+    /// </summary>
+    public CallTreeNode[] SwapCallTree(out int hresult)
+    {
+        hresult = _nativeMethods.SwapCallTree(out IntPtr nativeNodes, out int nodeLength);
+        if (hresult < 0 || IntPtr.Zero == nativeNodes || nodeLength <= 0)
+            return new CallTreeNode[0];
+
+        // the native nodes stay valid until the next swap, so they're copied out straight away
+        var nodes = new CallTreeNode[nodeLength];
+        for (int indx = 0; indx != nodeLength; ++indx, nativeNodes += CallTreeNode.NativeSize)
+        {
+            var node = new CallTreeNode();
+            node.FunctionId = new UIntPtr(unchecked((ulong)Marshal.ReadInt64(nativeNodes)));
+            node.Tag = unchecked((ulong)Marshal.ReadInt64(nativeNodes, 8));
+            node.CpuTimeNanoseconds = unchecked((ulong)Marshal.ReadInt64(nativeNodes, 16));
+            node.SelfCpuTimeNanoseconds = unchecked((ulong)Marshal.ReadInt64(nativeNodes, 24));
+            node.ParentIndex = Marshal.ReadInt32(nativeNodes, 32);
+            node.HitCount = Marshal.ReadInt32(nativeNodes, 36);
+            node.SelfHitCount = Marshal.ReadInt32(nativeNodes, 40);
+            node.RunningHitCount = Marshal.ReadInt32(nativeNodes, 44);
+            nodes[indx] = node;
+        }
+        return nodes;
+    }
+
     private static UIntPtr ReadUIntPtr(IntPtr address)
     {
         return (UIntPtr.Size == sizeof(uint)) ?
@@ -0,0 +1,168 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace NewRelic { namespace Profiler
+{
+    // Epoch-based reclamation.  Code that may add state for something that can go away (a module, say) runs inside
+    // a Guard.  When that something goes away, the work that removes its state is retired rather than run, and it
+    // only runs once every guard that was open at that point has closed, so nothing can add the state back after
+    // it has been removed.
+    //
+    // Guards are counted per epoch.  The epoch only moves forward once nobody is left in the one before it, so by
+    // the time it is two past the epoch something was retired in, everyone who could have seen it is gone.
+    class EpochReclaimer
+    {
+    public:
+        class Guard
+        {
+        public:
+            Guard(EpochReclaimer* reclaimer, uint64_t epoch) :
+                _reclaimer(reclaimer),
+                _epoch(epoch)
+            {}
+
+            Guard(Guard&& other) :
+                _reclaimer(other._reclaimer),
+                _epoch(other._epoch)
+            {
+                other._reclaimer = nullptr;
+            }
+
+            ~Guard()
+            {
+                if (_reclaimer != nullptr)
+                    _reclaimer->Leave(_epoch);
+            }
+
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+            Guard& operator=(Guard&&) = delete;
+
+        private:
+            EpochReclaimer* _reclaimer;
+            uint64_t _epoch;
+        };
+
+        EpochReclaimer() :
+            _epoch(0),
+            _pendingCount(0)
+        {
+            for (auto& readers : _readers)
+                readers = 0;
+        }
+
+        Guard Enter()
+        {
+            while (true)
+            {
+                auto epoch = _epoch.load();
+                ++_readers[epoch % EpochCount];
+
+                // if the epoch moved on before we were counted, the count may have landed in a slot that is
+                // already being reused for a newer epoch
+                if (_epoch.load() == epoch)
+                    return Guard(this, epoch);
+
+                --_readers[epoch % EpochCount];
+            }
+        }
+
+        // reclaim runs once every guard that is open right now has closed, possibly on the thread that closes the last one
+        void Retire(std::function<void()> reclaim)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _retired.emplace_back(_epoch.load(), std::move(reclaim));
+            ++_pendingCount;
+            Collect(lock);
+        }
+
+        // runs whatever can be reclaimed now, returns how many were run
+        size_t Collect()
+        {
+            std::unique_lock<std::mutex> lock(_mutex, std::try_to_lock);
+            if (!lock.owns_lock())
+                return 0;
+
+            return Collect(lock);
+        }
+
+        size_t GetPendingCount()
+        {
+            return _pendingCount.load();
+        }
+
+        uint64_t GetEpoch()
+        {
+            return _epoch.load();
+        }
+
+    private:
+        static const size_t EpochCount = 3;
+
+        void Leave(uint64_t epoch)
+        {
+            --_readers[epoch % EpochCount];
+
+            if (_pendingCount.load() != 0)
+                Collect();
+        }
+
+        size_t Collect(std::unique_lock<std::mutex>& lock)
+        {
+            // moving forward twice is enough for anything retired in the current epoch
+            for (int i = 0; i < 2; i++)
+            {
+                auto epoch = _epoch.load();
+                if (_readers[(epoch + EpochCount - 1) % EpochCount].load() != 0)
+                    break;
+                _epoch.compare_exchange_strong(epoch, epoch + 1);
+            }
+
+            auto epoch = _epoch.load();
+            std::vector<std::function<void()>> ready;
+            for (auto retired = _retired.begin(); retired != _retired.end();)
+            {
+                if (retired->first + 2 <= epoch)
+                {
+                    ready.push_back(std::move(retired->second));
+                    retired = _retired.erase(retired);
+                }
+                else
+                {
+                    ++retired;
+                }
+            }
+            _pendingCount -= ready.size();
+
+            // run outside the lock, reclaiming can take locks of its own
+            lock.unlock();
+            for (auto& reclaim : ready)
+            {
+                try
+                {
+                    reclaim();
+                }
+                catch (...)
+                {
+                }
+            }
+            return ready.size();
+        }
+
+        std::atomic<uint64_t> _epoch;
+        std::atomic<uint64_t> _readers[EpochCount];
+        std::atomic<size_t> _pendingCount;
+
+        std::mutex _mutex;
+        std::vector<std::pair<uint64_t, std::function<void()>>> _retired;
+    };
+}}
@@ -0,0 +1,182 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace NewRelic { namespace Profiler
+{
+    // A hash map kept in one flat array of slots, resolving collisions by probing the slots that follow.  Lookups
+    // never allocate, lock or move anything, so they can be made where the heap must not be touched, such as a
+    // stack snapshot callback while the runtime is suspended.  The table only grows inside Insert and Reserve, so
+    // code that needs lookups to stay allocation free just doesn't call them at the same time.
+    //
+    // Not thread safe.  Entries can only be removed all at once or through EraseIf, both of which rebuild the table.
+    template <typename Key, typename Value, typename Hash = std::hash<Key>>
+    class OpenAddressingMap
+    {
+    public:
+        static const size_t DefaultCapacity = 1024;
+
+        // linear probing slows down quickly past half full, so the table doubles before it gets there
+        static constexpr double MaxLoadFactor = 0.5;
+
+        // capacity is rounded up to a power of two
+        explicit OpenAddressingMap(size_t capacity = DefaultCapacity) :
+            _shift(ShiftFor(capacity)),
+            _slots(size_t(1) << _shift),
+            _size(0)
+        {}
+
+        // returns nullptr if key isn't present.  The pointer stays valid until the table next changes.
+        const Value* Find(const Key& key) const noexcept
+        {
+            for (auto index = IndexFor(key); ; index = (index + 1) & Mask())
+            {
+                auto& slot = _slots[index];
+                if (!slot._occupied)
+                    return nullptr;
+                if (slot._key == key)
+                    return &slot._value;
+            }
+        }
+
+        bool Contains(const Key& key) const noexcept
+        {
+            return Find(key) != nullptr;
+        }
+
+        // adds the value for key unless key is already present, returns true if it was added
+        bool Insert(const Key& key, const Value& value)
+        {
+            if (Contains(key))
+                return false;
+
+            Reserve(1);
+            Place(_slots, key, value);
+            ++_size;
+            return true;
+        }
+
+        // grows the table now, if needed, so that count more entries can be inserted without it growing
+        void Reserve(size_t count)
+        {
+            auto shift = _shift;
+            while (double(_size + count) > MaxLoadFactor * double(size_t(1) << shift))
+                ++shift;
+
+            if (shift != _shift)
+                Rebuild(shift, [](const Key&, const Value&) { return false; });
+        }
+
+        // removes every entry the predicate returns true for, returns how many were removed
+        template <typename Predicate>
+        size_t EraseIf(Predicate predicate)
+        {
+            auto sizeBefore = _size;
+            Rebuild(_shift, predicate);
+            return sizeBefore - _size;
+        }
+
+        // empties the table without giving back its slots
+        void Clear()
+        {
+            for (auto& slot : _slots)
+                slot = Slot();
+            _size = 0;
+        }
+
+        template <typename Function>
+        void ForEach(Function function) const
+        {
+            for (auto& slot : _slots)
+            {
+                if (slot._occupied)
+                    function(slot._key, slot._value);
+            }
+        }
+
+        size_t GetSize() const noexcept
+        {
+            return _size;
+        }
+
+        size_t GetCapacity() const noexcept
+        {
+            return _slots.size();
+        }
+
+        double GetLoadFactor() const noexcept
+        {
+            return double(_size) / double(_slots.size());
+        }
+
+    private:
+        struct Slot
+        {
+            bool _occupied = false;
+            Key _key = Key();
+            Value _value = Value();
+        };
+
+        typedef std::vector<Slot> Slots;
+
+        static unsigned ShiftFor(size_t capacity)
+        {
+            unsigned shift = 1;
+            while ((size_t(1) << shift) < capacity)
+                ++shift;
+            return shift;
+        }
+
+        size_t Mask() const noexcept
+        {
+            return _slots.size() - 1;
+        }
+
+        // hashes such as std::hash of a pointer are often the value itself, whose low bits are mostly zero, so the
+        // slot comes from the top bits of the hash multiplied by 2^64 / golden ratio
+        size_t IndexFor(const Key& key) const noexcept
+        {
+            return size_t((uint64_t(Hash()(key)) * 0x9E3779B97F4A7C15ull) >> (64 - _shift));
+        }
+
+        void Place(Slots& slots, const Key& key, const Value& value) const
+        {
+            auto index = IndexFor(key);
+            while (slots[index]._occupied)
+                index = (index + 1) & Mask();
+
+            auto& slot = slots[index];
+            slot._occupied = true;
+            slot._key = key;
+            slot._value = value;
+        }
+
+        template <typename Predicate>
+        void Rebuild(unsigned shift, Predicate erase)
+        {
+            Slots slots(size_t(1) << shift);
+            std::swap(_slots, slots);
+            _shift = shift;
+            _size = 0;
+
+            for (auto& slot : slots)
+            {
+                if (!slot._occupied || erase(slot._key, slot._value))
+                    continue;
+
+                Place(_slots, slot._key, slot._value);
+                ++_size;
+            }
+        }
+
+        unsigned _shift;
+        Slots _slots;
+        size_t _size;
+    };
+}}
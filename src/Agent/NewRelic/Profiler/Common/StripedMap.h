@@ -0,0 +1,158 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <stddef.h>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace NewRelic { namespace Profiler
+{
+    // A hash map split into stripes that each have their own lock, so threads working on different keys
+    // almost never wait on each other.  Every operation except EraseIf and GetSize touches exactly one
+    // stripe; there is no way to iterate or lock the whole map.
+    template <typename Key, typename Value, typename Hash = std::hash<Key>, size_t StripeCount = 32>
+    class StripedMap
+    {
+    public:
+        // adds or replaces the value for key
+        void Set(const Key& key, const Value& value)
+        {
+            auto& stripe = GetStripe(key);
+            std::lock_guard<std::mutex> lock(stripe._mutex);
+            stripe._map[key] = value;
+        }
+
+        // adds the value for key unless key is already present, returns true if it was added
+        bool Insert(const Key& key, const Value& value)
+        {
+            auto& stripe = GetStripe(key);
+            std::lock_guard<std::mutex> lock(stripe._mutex);
+            return stripe._map.emplace(key, value).second;
+        }
+
+        bool TryGet(const Key& key, Value& value)
+        {
+            auto& stripe = GetStripe(key);
+            std::lock_guard<std::mutex> lock(stripe._mutex);
+            auto found = stripe._map.find(key);
+            if (found == stripe._map.end())
+                return false;
+
+            value = found->second;
+            return true;
+        }
+
+        // removes key and hands back its value, returns false if key wasn't present
+        bool TryTake(const Key& key, Value& value)
+        {
+            auto& stripe = GetStripe(key);
+            std::lock_guard<std::mutex> lock(stripe._mutex);
+            auto found = stripe._map.find(key);
+            if (found == stripe._map.end())
+                return false;
+
+            value = found->second;
+            stripe._map.erase(found);
+            return true;
+        }
+
+        bool Erase(const Key& key)
+        {
+            auto& stripe = GetStripe(key);
+            std::lock_guard<std::mutex> lock(stripe._mutex);
+            return stripe._map.erase(key) > 0;
+        }
+
+        // removes every entry the predicate returns true for, locking each stripe in turn.  returns how many were removed
+        template <typename Predicate>
+        size_t EraseIf(Predicate predicate)
+        {
+            size_t erased = 0;
+            for (auto& stripe : _stripes)
+            {
+                std::lock_guard<std::mutex> lock(stripe._mutex);
+                for (auto entry = stripe._map.begin(); entry != stripe._map.end();)
+                {
+                    if (predicate(entry->first, entry->second))
+                    {
+                        entry = stripe._map.erase(entry);
+                        ++erased;
+                    }
+                    else
+                    {
+                        ++entry;
+                    }
+                }
+            }
+            return erased;
+        }
+
+        // locks each stripe in turn, so the total is only exact when nothing else is writing
+        size_t GetSize()
+        {
+            size_t size = 0;
+            for (auto& stripe : _stripes)
+            {
+                std::lock_guard<std::mutex> lock(stripe._mutex);
+                size += stripe._map.size();
+            }
+            return size;
+        }
+
+    private:
+        struct Stripe
+        {
+            std::mutex _mutex;
+            std::unordered_map<Key, Value, Hash> _map;
+            // keeps neighbouring stripes' locks off the same cache line
+            char _padding[64];
+        };
+
+        Stripe& GetStripe(const Key& key)
+        {
+            return _stripes[Hash()(key) % StripeCount];
+        }
+
+        Stripe _stripes[StripeCount];
+    };
+
+    // A set with the same striping as StripedMap.
+    template <typename Key, typename Hash = std::hash<Key>, size_t StripeCount = 32>
+    class StripedSet
+    {
+    public:
+        // returns true if key was added
+        bool Insert(const Key& key)
+        {
+            return _map.Insert(key, true);
+        }
+
+        bool Contains(const Key& key)
+        {
+            bool present;
+            return _map.TryGet(key, present);
+        }
+
+        // returns true if key was present
+        bool Erase(const Key& key)
+        {
+            return _map.Erase(key);
+        }
+
+        template <typename Predicate>
+        size_t EraseIf(Predicate predicate)
+        {
+            return _map.EraseIf([&](const Key& key, bool) { return predicate(key); });
+        }
+
+        size_t GetSize()
+        {
+            return _map.GetSize();
+        }
+
+    private:
+        StripedMap<Key, bool, Hash, StripeCount> _map;
+    };
+}}
@@ -0,0 +1,105 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stdafx.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "../Common/EpochReclaimer.h"
+#include "../Common/StripedMap.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace NewRelic {
+    namespace Profiler {
+        namespace Common
+        {
+            TEST_CLASS(EpochReclaimerTest)
+            {
+            public:
+                TEST_METHOD(retire_runs_straight_away_without_guards)
+                {
+                    EpochReclaimer reclaimer;
+                    bool reclaimed = false;
+
+                    reclaimer.Retire([&] { reclaimed = true; });
+
+                    Assert::IsTrue(reclaimed);
+                    Assert::AreEqual(size_t(0), reclaimer.GetPendingCount());
+                }
+
+                TEST_METHOD(retire_waits_for_guards_that_were_open)
+                {
+                    EpochReclaimer reclaimer;
+                    bool reclaimed = false;
+
+                    {
+                        auto guard = reclaimer.Enter();
+                        reclaimer.Retire([&] { reclaimed = true; });
+                        Assert::IsFalse(reclaimed);
+                        Assert::AreEqual(size_t(1), reclaimer.GetPendingCount());
+                    }
+
+                    Assert::IsTrue(reclaimed);
+                    Assert::AreEqual(size_t(0), reclaimer.GetPendingCount());
+                }
+
+                TEST_METHOD(guards_opened_after_retire_do_not_hold_it_back)
+                {
+                    EpochReclaimer reclaimer;
+                    bool reclaimed = false;
+
+                    auto before = std::unique_ptr<EpochReclaimer::Guard>(new EpochReclaimer::Guard(reclaimer.Enter()));
+                    reclaimer.Retire([&] { reclaimed = true; });
+                    auto after = reclaimer.Enter();
+
+                    before.reset();
+                    Assert::IsTrue(reclaimed);
+                }
+
+                TEST_METHOD(soak_keeps_state_bounded_while_readers_race_with_unloads)
+                {
+                    // readers keep adding state for whichever "module" is current while another thread unloads
+                    // modules one after another, as a plugin host loading and unloading collectible contexts would
+                    EpochReclaimer reclaimer;
+                    StripedMap<int, int> state;
+                    std::atomic<int> currentModule(0);
+                    std::atomic<bool> stop(false);
+
+                    std::vector<std::thread> readers;
+                    for (int t = 0; t < 4; ++t)
+                    {
+                        readers.emplace_back([&, t]() {
+                            for (int i = 0; !stop.load(); ++i)
+                            {
+                                auto guard = reclaimer.Enter();
+                                state.Set((i % 1000) * 4 + t, currentModule.load());
+                            }
+                        });
+                    }
+
+                    const int moduleCount = 2000;
+                    for (int module = 0; module < moduleCount; ++module)
+                    {
+                        currentModule.store(module + 1);
+                        reclaimer.Retire([&state, module] {
+                            state.EraseIf([module](int, int owner) { return owner == module; });
+                        });
+                    }
+
+                    stop.store(true);
+                    for (auto& reader : readers)
+                    {
+                        reader.join();
+                    }
+                    reclaimer.Collect();
+
+                    // everything left belongs to the module that never unloaded
+                    Assert::AreEqual(size_t(0), reclaimer.GetPendingCount());
+                    Assert::AreEqual(size_t(0), state.EraseIf([moduleCount](int, int owner) { return owner != moduleCount; }));
+                }
+            };
+        }
+    }
+}
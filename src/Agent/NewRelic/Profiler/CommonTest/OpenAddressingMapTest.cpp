@@ -0,0 +1,94 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stdafx.h"
+#include <stdint.h>
+#include "CppUnitTest.h"
+#include "../Common/OpenAddressingMap.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace NewRelic {
+    namespace Profiler {
+        namespace Common
+        {
+            TEST_CLASS(OpenAddressingMapTest)
+            {
+            public:
+                TEST_METHOD(insert_does_not_replace)
+                {
+                    OpenAddressingMap<uintptr_t, int> map;
+                    Assert::IsTrue(map.Insert(1, 10));
+                    Assert::IsFalse(map.Insert(1, 11));
+                    Assert::IsTrue(map.Insert(2, 20));
+
+                    Assert::AreEqual(10, *map.Find(1));
+                    Assert::AreEqual(20, *map.Find(2));
+                    Assert::IsNull(map.Find(3));
+                    Assert::AreEqual(size_t(2), map.GetSize());
+                }
+
+                TEST_METHOD(grows_before_passing_the_max_load_factor)
+                {
+                    // aligned pointers are the keys the profiler uses, their low bits are always zero
+                    OpenAddressingMap<uintptr_t, uintptr_t> map(16);
+                    for (uintptr_t i = 1; i <= 10000; ++i)
+                    {
+                        map.Insert(i * 16, i);
+                        Assert::IsTrue(map.GetLoadFactor() <= OpenAddressingMap<uintptr_t, uintptr_t>::MaxLoadFactor);
+                    }
+
+                    for (uintptr_t i = 1; i <= 10000; ++i)
+                    {
+                        Assert::AreEqual(i, *map.Find(i * 16));
+                    }
+                    Assert::IsNull(map.Find(8));
+                }
+
+                TEST_METHOD(reserve_leaves_room_for_inserts_without_growing)
+                {
+                    OpenAddressingMap<uintptr_t, int> map(16);
+                    map.Reserve(1000);
+                    auto capacity = map.GetCapacity();
+
+                    for (uintptr_t i = 1; i <= 1000; ++i)
+                    {
+                        map.Insert(i, 0);
+                    }
+                    Assert::AreEqual(capacity, map.GetCapacity());
+                }
+
+                TEST_METHOD(erase_if_keeps_the_rest_findable)
+                {
+                    OpenAddressingMap<uintptr_t, uintptr_t> map(16);
+                    for (uintptr_t i = 1; i <= 1000; ++i)
+                    {
+                        map.Insert(i, i % 3);
+                    }
+
+                    Assert::AreEqual(size_t(333), map.EraseIf([](uintptr_t, uintptr_t value) { return value == 0; }));
+                    Assert::AreEqual(size_t(667), map.GetSize());
+                    for (uintptr_t i = 1; i <= 1000; ++i)
+                    {
+                        Assert::AreEqual(i % 3 != 0, map.Contains(i));
+                    }
+                }
+
+                TEST_METHOD(clear_keeps_capacity)
+                {
+                    OpenAddressingMap<uintptr_t, int> map(16);
+                    for (uintptr_t i = 1; i <= 100; ++i)
+                    {
+                        map.Insert(i, 0);
+                    }
+                    auto capacity = map.GetCapacity();
+
+                    map.Clear();
+                    Assert::AreEqual(size_t(0), map.GetSize());
+                    Assert::AreEqual(capacity, map.GetCapacity());
+                    Assert::IsFalse(map.Contains(1));
+                }
+            };
+        }
+    }
+}
@@ -0,0 +1,108 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stdafx.h"
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "../Common/StripedMap.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace NewRelic {
+    namespace Profiler {
+        namespace Common
+        {
+            TEST_CLASS(StripedMapTest)
+            {
+            public:
+                TEST_METHOD(set_replaces_and_insert_does_not)
+                {
+                    StripedMap<int, int> map;
+                    map.Set(1, 10);
+                    map.Set(1, 11);
+                    Assert::IsFalse(map.Insert(1, 12));
+                    Assert::IsTrue(map.Insert(2, 20));
+
+                    int value = 0;
+                    Assert::IsTrue(map.TryGet(1, value));
+                    Assert::AreEqual(11, value);
+                    Assert::AreEqual(size_t(2), map.GetSize());
+                }
+
+                TEST_METHOD(try_take_removes_the_key)
+                {
+                    StripedMap<int, int> map;
+                    map.Set(1, 10);
+
+                    int value = 0;
+                    Assert::IsTrue(map.TryTake(1, value));
+                    Assert::AreEqual(10, value);
+                    Assert::IsFalse(map.TryTake(1, value));
+                    Assert::IsFalse(map.TryGet(1, value));
+                }
+
+                TEST_METHOD(set_insert_and_erase)
+                {
+                    StripedSet<int> set;
+                    Assert::IsTrue(set.Insert(1));
+                    Assert::IsFalse(set.Insert(1));
+                    Assert::IsTrue(set.Contains(1));
+                    Assert::IsTrue(set.Erase(1));
+                    Assert::IsFalse(set.Erase(1));
+                    Assert::IsFalse(set.Contains(1));
+                }
+
+                TEST_METHOD(erase_if_removes_only_matching_entries)
+                {
+                    StripedMap<int, int> map;
+                    for (int i = 0; i < 100; ++i)
+                    {
+                        map.Set(i, i % 3);
+                    }
+
+                    Assert::AreEqual(size_t(34), map.EraseIf([](int, int value) { return value == 0; }));
+                    Assert::AreEqual(size_t(66), map.GetSize());
+
+                    int value = -1;
+                    Assert::IsFalse(map.TryGet(3, value));
+                    Assert::IsTrue(map.TryGet(4, value));
+
+                    StripedSet<int> set;
+                    set.Insert(1);
+                    set.Insert(2);
+                    Assert::AreEqual(size_t(1), set.EraseIf([](int key) { return key == 2; }));
+                    Assert::IsTrue(set.Contains(1));
+                    Assert::IsFalse(set.Contains(2));
+                }
+
+                TEST_METHOD(concurrent_writers_do_not_lose_keys)
+                {
+                    StripedMap<int, int> map;
+                    const int threadCount = 8;
+                    const int keysPerThread = 10000;
+
+                    std::vector<std::thread> threads;
+                    for (int t = 0; t < threadCount; ++t)
+                    {
+                        threads.emplace_back([&map, t, keysPerThread]() {
+                            for (int i = 0; i < keysPerThread; ++i)
+                            {
+                                map.Set(t * keysPerThread + i, t);
+                            }
+                        });
+                    }
+                    for (auto& thread : threads)
+                    {
+                        thread.join();
+                    }
+
+                    Assert::AreEqual(size_t(threadCount * keysPerThread), map.GetSize());
+                    int value = -1;
+                    Assert::IsTrue(map.TryGet(3 * keysPerThread + 17, value));
+                    Assert::AreEqual(3, value);
+                }
+            };
+        }
+    }
+}
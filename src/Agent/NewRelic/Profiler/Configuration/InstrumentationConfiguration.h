@@ -6,6 +6,7 @@
 #include <memory>
 #include <string>
 #include <map>
+#include <set>
 #include "../Logging/Logger.h"
 #include "InstrumentationPoint.h"
 #include "TracerFlags.h"
@@ -85,6 +86,28 @@ namespace NewRelic { namespace Profiler { namespace Configuration
             return _ignoreList;
         }
 
+        // upper-cased names of the assemblies whose instrumentation points differ between this configuration and other
+        std::set<xstring_t> GetChangedAssemblies(const InstrumentationConfiguration& other) const
+        {
+            std::set<xstring_t> changedAssemblies;
+            for (auto& assembly : _fingerprintsByAssembly)
+            {
+                auto otherAssembly = other._fingerprintsByAssembly.find(assembly.first);
+                if (otherAssembly == other._fingerprintsByAssembly.end() || otherAssembly->second != assembly.second)
+                {
+                    changedAssemblies.insert(assembly.first);
+                }
+            }
+            for (auto& otherAssembly : other._fingerprintsByAssembly)
+            {
+                if (_fingerprintsByAssembly.find(otherAssembly.first) == _fingerprintsByAssembly.end())
+                {
+                    changedAssemblies.insert(otherAssembly.first);
+                }
+            }
+            return changedAssemblies;
+        }
+
         InstrumentationPointPtr TryGetInstrumentationPoint(const MethodRewriter::IFunctionPtr function) const
         {
             const auto methodSignature = SignatureParser::SignatureParser::ParseMethodSignature(function->GetSignature()->begin(), function->GetSignature()->end());
@@ -171,8 +194,7 @@ namespace NewRelic { namespace Profiler { namespace Configuration
             instrumentationPoint->Parameters = nullptr;
             instrumentationPoint->TracerFactoryArgs = 0;
 
-            (*_instrumentationPointsMap)[instrumentationPoint->GetMatchKey()].insert(instrumentationPoint);
-            _instrumentationPointsSet->insert(instrumentationPoint);
+            AddInstrumentationPointToCollections(instrumentationPoint);
 
             return true;
         }
@@ -417,8 +439,7 @@ namespace NewRelic { namespace Profiler { namespace Configuration
         {
             if (!IgnoreInstrumentation::Matches(_ignoreList, instrumentationPoint->AssemblyName, instrumentationPoint->ClassName))
             {
-                (*_instrumentationPointsMap)[instrumentationPoint->GetMatchKey()].insert(instrumentationPoint);
-                _instrumentationPointsSet->insert(instrumentationPoint);
+                AddInstrumentationPointToCollections(instrumentationPoint);
             }
             else
             {
@@ -426,6 +447,13 @@ namespace NewRelic { namespace Profiler { namespace Configuration
             }
         }
 
+        void AddInstrumentationPointToCollections(InstrumentationPointPtr instrumentationPoint)
+        {
+            (*_instrumentationPointsMap)[instrumentationPoint->GetMatchKey()].insert(instrumentationPoint);
+            _instrumentationPointsSet->insert(instrumentationPoint);
+            _fingerprintsByAssembly[NewRelic::Profiler::Strings::ToUpper(instrumentationPoint->AssemblyName)].insert(instrumentationPoint->GetFingerprint());
+        }
+
         // the class name field of an instrumentation point may have multiple classes listed (comma separated), we have to build instrumentation points for each
         static std::set<InstrumentationPointPtr> SplitInstrumentationPointsOnClassNames(InstrumentationPointPtr instrumentationPoint)
         {
@@ -523,6 +551,7 @@ namespace NewRelic { namespace Profiler { namespace Configuration
         IgnoreInstrumentationListPtr _ignoreList;
         std::shared_ptr<NewRelic::Profiler::Logger::IFileDestinationSystemCalls> _systemCalls;
         bool _foundServerlessInstrumentationPoint;
+        std::map<xstring_t, std::multiset<xstring_t>> _fingerprintsByAssembly;
     };
     typedef std::shared_ptr<InstrumentationConfiguration> InstrumentationConfigurationPtr;
 }}}
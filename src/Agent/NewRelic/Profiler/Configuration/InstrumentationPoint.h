@@ -70,6 +70,28 @@ namespace NewRelic { namespace Profiler { namespace Configuration
                 : GetMatchKey(AssemblyName, ClassName, MethodName, *Parameters);
         }
 
+        // everything about this point that ends up in the injected IL; taken before the method rewriter folds
+        // per-function tracer flags into TracerFactoryArgs
+        xstring_t GetFingerprint()
+        {
+            return GetMatchKey() + _X("|") + TracerFactoryName + _X("|") + MetricType + _X("|") + MetricName + _X("|") + to_xstring(TracerFactoryArgs)
+                + _X("|") + (MinVersion == nullptr ? xstring_t() : MinVersion->ToString())
+                + _X("|") + (MaxVersion == nullptr ? xstring_t() : MaxVersion->ToString());
+        }
+
+        // the same test the JIT path gets from looking up match keys: without parameters every overload matches,
+        // otherwise the method's parameters have to print exactly as configured
+        bool MatchesParameters(const xstring_t& parameters) const
+        {
+            return Parameters == nullptr || *Parameters == parameters;
+        }
+
+        // minimum version is inclusive, maximum version is exclusive
+        bool IsInVersionRange(const AssemblyVersion& version) const
+        {
+            return (MinVersion == nullptr || !(version < *MinVersion)) && (MaxVersion == nullptr || !(version >= *MaxVersion));
+        }
+
         static xstring_t GetMatchKey(const xstring_t& assemblyName, const xstring_t& className, const xstring_t& methodName)
         {
             return xstring_t(_X("[")) + assemblyName + _X("]") + className + _X(".") + methodName;
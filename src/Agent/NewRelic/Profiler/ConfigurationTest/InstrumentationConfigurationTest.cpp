@@ -987,5 +987,63 @@ namespace NewRelic { namespace Profiler { namespace Configuration { namespace Te
             auto instrumentationPoint = instrumentation.TryGetInstrumentationPoint(std::make_shared<MethodRewriter::Test::MockFunction>());
             Assert::IsFalse(instrumentationPoint == nullptr);
         }
+
+        TEST_METHOD(changed_assemblies_only_include_assemblies_whose_points_differ)
+        {
+            auto xml = [](const std::wstring& metricName) {
+                return L"\
+                <?xml version=\"1.0\" encoding=\"utf-8\"?>\
+                <extension>\
+                    <instrumentation>\
+                        <tracerFactory metricName=\"" + metricName + L"\">\
+                            <match assemblyName=\"MyAssembly\" className=\"MyNamespace.MyClass\">\
+                                <exactMethodMatcher methodName=\"MyMethod\"/>\
+                            </match>\
+                        </tracerFactory>\
+                        <tracerFactory>\
+                            <match assemblyName=\"OtherAssembly\" className=\"MyNamespace.MyClass\">\
+                                <exactMethodMatcher methodName=\"MyMethod\"/>\
+                            </match>\
+                        </tracerFactory>\
+                    </instrumentation>\
+                </extension>\
+                ";
+            };
+            InstrumentationXmlSetPtr oldXmlSet(new InstrumentationXmlSet());
+            oldXmlSet->emplace(L"filename", xml(L"OldMetric"));
+            InstrumentationXmlSetPtr newXmlSet(new InstrumentationXmlSet());
+            newXmlSet->emplace(L"filename", xml(L"NewMetric"));
+            InstrumentationConfiguration oldInstrumentation(oldXmlSet, nullptr);
+            InstrumentationConfiguration newInstrumentation(newXmlSet, nullptr);
+
+            auto changedAssemblies = oldInstrumentation.GetChangedAssemblies(newInstrumentation);
+
+            Assert::AreEqual(size_t(1), changedAssemblies.size());
+            Assert::AreEqual(std::wstring(L"MYASSEMBLY"), *changedAssemblies.begin());
+            Assert::IsTrue(oldInstrumentation.GetChangedAssemblies(oldInstrumentation).empty());
+        }
+
+        TEST_METHOD(changed_assemblies_include_added_and_removed_assemblies)
+        {
+            InstrumentationXmlSetPtr emptyXmlSet(new InstrumentationXmlSet());
+            InstrumentationXmlSetPtr xmlSet(new InstrumentationXmlSet());
+            xmlSet->emplace(L"filename", L"\
+                <?xml version=\"1.0\" encoding=\"utf-8\"?>\
+                <extension>\
+                    <instrumentation>\
+                        <tracerFactory>\
+                            <match assemblyName=\"MyAssembly\" className=\"MyNamespace.MyClass\">\
+                                <exactMethodMatcher methodName=\"MyMethod\"/>\
+                            </match>\
+                        </tracerFactory>\
+                    </instrumentation>\
+                </extension>\
+                ");
+            InstrumentationConfiguration emptyInstrumentation(emptyXmlSet, nullptr);
+            InstrumentationConfiguration instrumentation(xmlSet, nullptr);
+
+            Assert::AreEqual(size_t(1), emptyInstrumentation.GetChangedAssemblies(instrumentation).size());
+            Assert::AreEqual(size_t(1), instrumentation.GetChangedAssemblies(emptyInstrumentation).size());
+        }
     };
 }}}}
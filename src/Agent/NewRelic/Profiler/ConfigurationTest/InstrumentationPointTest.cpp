@@ -198,6 +198,38 @@ namespace NewRelic { namespace Profiler { namespace Configuration { namespace Te
             Assert::IsFalse(*p1 == *p2);
         }
 
+        TEST_METHOD(point_without_parameters_matches_every_overload)
+        {
+            InstrumentationPoint point;
+
+            Assert::IsTrue(point.MatchesParameters(L""));
+            Assert::IsTrue(point.MatchesParameters(L"System.String,System.Int32"));
+        }
+
+        TEST_METHOD(point_with_parameters_only_matches_the_same_parameters)
+        {
+            InstrumentationPoint point;
+            point.Parameters = std::unique_ptr<std::wstring>(new std::wstring(L"System.String"));
+
+            Assert::IsTrue(point.MatchesParameters(L"System.String"));
+            Assert::IsFalse(point.MatchesParameters(L"System.String,System.Int32"));
+            Assert::IsFalse(point.MatchesParameters(L""));
+        }
+
+        TEST_METHOD(version_range_includes_minimum_and_excludes_maximum)
+        {
+            InstrumentationPoint point;
+            Assert::IsTrue(point.IsInVersionRange(AssemblyVersion(1)));
+
+            point.MinVersion.reset(new AssemblyVersion(2));
+            point.MaxVersion.reset(new AssemblyVersion(3));
+
+            Assert::IsFalse(point.IsInVersionRange(AssemblyVersion(1, 9)));
+            Assert::IsTrue(point.IsInVersionRange(AssemblyVersion(2)));
+            Assert::IsTrue(point.IsInVersionRange(AssemblyVersion(2, 9, 9, 9)));
+            Assert::IsFalse(point.IsInVersionRange(AssemblyVersion(3)));
+        }
+
         //TEST_METHOD(verify_equality_operator_compares_assembly_and_class_name_only_everything_else_unset)
         //{
         //    Assert::Fail(L"Test not implemented.");
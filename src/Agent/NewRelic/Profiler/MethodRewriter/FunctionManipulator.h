@@ -19,6 +19,7 @@
 #include "../Logging/Logger.h"
 #include "../Configuration/InstrumentationPoint.h"
 #include "../Sicily/codegen/ByteCodeGenerator.h"
+#include "../Sicily/CompiledSignatureCache.h"
 #include "../SignatureParser/SignatureParser.h"
 #include "IFunctionHeaderInfo.h"
 
@@ -433,9 +434,9 @@ namespace NewRelic { namespace Profiler { namespace MethodRewriter
         // appends the given token to the new locals signature and returns the index to it
         static uint16_t AppendToLocalsSignature(xstring_t typeString, sicily::codegen::ITokenizerPtr tokenizer, ByteVector& localsSignature)
         {
-            // turn the type string into a type token
-            auto typeBytes = TypeStringToToken(typeString, tokenizer);
-            return AppendToLocalsSignature(typeBytes, localsSignature);
+            // turn the type string into a type token, straight onto the end of the locals signature
+            sicily::CompiledSignatureCache::GetBytes(typeString)->ResolveBytes(*tokenizer, localsSignature);
+            return IncrementLocalCount(localsSignature);
         }
 
         // append some bytes representing a type to the locals signature and return the index to it
@@ -470,15 +471,6 @@ namespace NewRelic { namespace Profiler { namespace MethodRewriter
             return uint16_t(localCount - 1);
         }
 
-        static ByteVector TypeStringToToken(xstring_t typeString, sicily::codegen::ITokenizerPtr tokenizer)
-        {
-            sicily::Scanner scanner(typeString);
-            sicily::Parser parser;
-            auto type = parser.Parse(scanner);
-            sicily::codegen::ByteCodeGenerator bytecodeGenerator(tokenizer);
-            return bytecodeGenerator.TypeToBytes(type);
-        }
-
         ByteVector CombineHeaderInstructionsAndExtraSections()
         {
             LogTrace(_function->ToString(), L": Building the byte array for this method.");
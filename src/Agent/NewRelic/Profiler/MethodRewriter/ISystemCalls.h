@@ -3,10 +3,14 @@
 * SPDX-License-Identifier: Apache-2.0
 */
 #pragma once
+#include <stdint.h>
 #include <memory>
 #include <string>
 #include <set>
 #include <list>
+#include <unordered_map>
+#include <codecvt>
+#include <locale>
 #include "../Common/xplat.h"
 #include "../Logging/DefaultFileLogLocation.h"
 #include "../Common/Strings.h"
@@ -66,6 +70,41 @@ namespace NewRelic { namespace Profiler { namespace MethodRewriter {
             return GetEnvironmentBool(_X("NEW_RELIC_DISABLE_APPDOMAIN_CACHING"), false);
         }
 
+        virtual bool GetIsTieredCompilationDisabled()
+        {
+            return GetEnvironmentBool(_X("NEW_RELIC_DISABLE_TIERED_COMPILATION"), false);
+        }
+
+        virtual bool GetUsePrecompiledCode()
+        {
+            return GetEnvironmentBool(_X("NEW_RELIC_USE_PRECOMPILED_CODE"), false);
+        }
+
+        virtual bool GetInstrumentWithReJITOnly()
+        {
+            return GetEnvironmentBool(_X("NEW_RELIC_INSTRUMENT_WITH_REJIT_ONLY"), false);
+        }
+
+        virtual bool GetThreadProfilingEventsAtStartup()
+        {
+            return GetEnvironmentBool(_X("NEW_RELIC_THREAD_PROFILING_EVENTS_AT_STARTUP"), false);
+        }
+
+        virtual uint32_t GetReJITCoalescingWindowInMilliseconds(uint32_t fallback)
+        {
+            return GetEnvironmentUInt32(_X("NEW_RELIC_REJIT_COALESCING_WINDOW_MS"), fallback);
+        }
+
+        virtual uint32_t GetReJITMaxBatchSize(uint32_t fallback)
+        {
+            return GetEnvironmentUInt32(_X("NEW_RELIC_REJIT_MAX_BATCH_SIZE"), fallback);
+        }
+
+        virtual uint32_t GetThreadProfilerMaxPauseInMicroseconds(uint32_t fallback)
+        {
+            return GetEnvironmentUInt32(_X("NEW_RELIC_THREAD_PROFILER_MAX_PAUSE_US"), fallback);
+        }
+
         virtual std::unique_ptr<xstring_t> GetProfilerDelay()
         {
             return GetEnvironmentVariableWithFallback(_X("NEW_RELIC_PROFILER_DELAY_IN_SEC"), _X("NEWRELIC_PROFILER_DELAY_IN_SEC"));
@@ -122,8 +161,60 @@ namespace NewRelic { namespace Profiler { namespace MethodRewriter {
             return GetEnvironmentVariableAsList(_X("NEW_RELIC_EXCLUDED_APPLICATION_NAMES"));
         }
 
+        // .NET Framework doesn't allow ReJIT for a profiler that attaches to a running process, and without it the
+        // methods that have already been jitted can't be instrumented
+        virtual bool IsAttachSupported()
+        {
+            return _isCoreClr;
+        }
+
+        // A process that is already running can't be given environment variables, so a client attaching the profiler
+        // passes them as client data instead: UTF-8 NAME=VALUE pairs separated by null characters.  They are kept as
+        // overrides that TryGetEnvironmentVariable checks first rather than set on the process, where setenv would race
+        // with the runtime's threads reading the environment.  Returns the number of overrides that were parsed.
+        int SetEnvironmentOverridesFromClientData(const char* data, size_t size)
+        {
+            int count = 0;
+            for (size_t start = 0; start < size;)
+            {
+                auto end = start;
+                while (end < size && data[end] != '\0')
+                    ++end;
+
+                std::string assignment(data + start, end - start);
+                start = end + 1;
+
+                auto separator = assignment.find('=');
+                if (separator == 0 || separator == std::string::npos)
+                    continue;
+
+                try
+                {
+                    std::wstring_convert<std::codecvt_utf8_utf16<xchar_t>, xchar_t> converter;
+                    _environmentOverrides[converter.from_bytes(assignment.substr(0, separator))] = converter.from_bytes(assignment.substr(separator + 1));
+                    ++count;
+                }
+                catch (...)
+                {
+                    // not valid UTF-8
+                }
+            }
+            return count;
+        }
+
+    protected:
+        // The overrides are only added while the profiler initializes, before any other thread reads them.
+        std::unique_ptr<xstring_t> TryGetEnvironmentOverride(const xstring_t& variableName)
+        {
+            auto found = _environmentOverrides.find(variableName);
+            if (found == _environmentOverrides.end()) return nullptr;
+
+            return std::unique_ptr<xstring_t>(new xstring_t(found->second));
+        }
+
     private:
         bool _isCoreClr = false;
+        std::unordered_map<xstring_t, xstring_t> _environmentOverrides;
         /// <summary>
         /// Gets an environment variable that should be a boolean
         /// </summary>
@@ -153,6 +244,26 @@ namespace NewRelic { namespace Profiler { namespace MethodRewriter {
             return fallback;
         }
 
+        // returns the fallback if the variable doesn't exist or isn't a non-negative integer
+        uint32_t GetEnvironmentUInt32(const xstring_t& variableName, uint32_t fallback)
+        {
+            auto value = TryGetEnvironmentVariable(variableName);
+            if (value == nullptr)
+            {
+                return fallback;
+            }
+
+            try
+            {
+                auto parsed = xstoi(*value);
+                return parsed < 0 ? fallback : uint32_t(parsed);
+            }
+            catch (...)
+            {
+                return fallback;
+            }
+        }
+
         std::unique_ptr<xstring_t> GetEnvironmentVariableWithFallback(const xstring_t& newVariable, const xstring_t& oldVariable)
         {
             auto variableValue = TryGetEnvironmentVariable(newVariable);
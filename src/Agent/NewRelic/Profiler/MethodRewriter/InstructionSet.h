@@ -703,19 +703,16 @@ namespace NewRelic { namespace Profiler { namespace MethodRewriter
             _userCodeOffset = (uint32_t)(_bytes.size());
         }
 
-        // Parse a string using sicily, turn it into bytecode using sicily, then append it onto the instruction set
+        // Parse a string using sicily (once per process, see CompiledSignatureCache), tokenize it for this module, then append it onto the instruction set
         void ParseTokenizeAndAppend(xstring_t details)
         {
             // parse
             try
             {
-                sicily::Scanner scanner(details);
-                sicily::Parser parser;
-                sicily::ast::TypePtr type = parser.Parse(scanner);
+                auto compiled = sicily::CompiledSignatureCache::GetToken(details);
 
                 // tokenize
-                sicily::codegen::ByteCodeGenerator generator(_tokenizer);
-                auto token = generator.TypeToToken(type);
+                auto token = compiled->ResolveToken(*_tokenizer);
 
                 // append
                 AppendOperand(token);
@@ -0,0 +1,170 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <stdint.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include "../Common/Strings.h"
+#include "../Common/xplat.h"
+
+namespace NewRelic { namespace Profiler { namespace MethodRewriter
+{
+    typedef std::shared_ptr<const std::vector<uint8_t>> RewrittenMethodPtr;
+
+    // Finished method bodies (header, IL and extra sections) keyed by module, methodDef and whether they came
+    // from the JIT or the ReJIT path.  Every instantiation of a generic method and every refresh that doesn't
+    // touch a method's assembly produces the same bytes, so those can be replayed instead of rewritten.
+    //
+    // Entries for an assembly are dropped when its instrumentation changes.  A rewrite that started before
+    // such an invalidation could have used the old instrumentation, so Put ignores any result computed
+    // against an older generation than the current one.
+    class RewrittenMethodCache
+    {
+    public:
+        static const size_t DefaultMaxEntries = 2048;
+
+        RewrittenMethodCache(size_t maxEntries = DefaultMaxEntries) :
+            _maxEntries(maxEntries),
+            _generation(0)
+        {}
+
+        // read before choosing the instrumentation a rewrite will use and pass the value on to Put
+        uint64_t GetGeneration()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _generation;
+        }
+
+        RewrittenMethodPtr Get(uintptr_t moduleId, uint32_t methodToken, bool rejit)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto found = _index.find(Key(moduleId, methodToken, rejit));
+            if (found == _index.end())
+                return nullptr;
+
+            // most recently used entries live at the front
+            _entries.splice(_entries.begin(), _entries, found->second);
+            return found->second->_method;
+        }
+
+        void Put(uintptr_t moduleId, uint32_t methodToken, bool rejit, const xstring_t& assemblyName, uint64_t generation, const std::vector<uint8_t>& method)
+        {
+            auto entry = Entry(Key(moduleId, methodToken, rejit), Strings::ToUpper(assemblyName), std::make_shared<const std::vector<uint8_t>>(method));
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (generation != _generation || _maxEntries == 0)
+                return;
+
+            auto found = _index.find(entry._key);
+            if (found != _index.end())
+            {
+                _entries.erase(found->second);
+                _index.erase(found);
+            }
+            else if (_entries.size() >= _maxEntries)
+            {
+                _index.erase(_entries.back()._key);
+                _entries.pop_back();
+            }
+
+            _entries.push_front(std::move(entry));
+            _index[_entries.front()._key] = _entries.begin();
+        }
+
+        // assembly names are compared case-insensitively
+        void InvalidateAssemblies(const std::set<xstring_t>& assemblyNames)
+        {
+            std::set<xstring_t> upperCaseNames;
+            for (auto& assemblyName : assemblyNames)
+                upperCaseNames.insert(Strings::ToUpper(assemblyName));
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_generation;
+            RemoveIf([&](const Entry& entry) { return upperCaseNames.find(entry._assemblyName) != upperCaseNames.end(); });
+        }
+
+        // module ids may be handed out again once a module has unloaded
+        void InvalidateModule(uintptr_t moduleId)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_generation;
+            RemoveIf([&](const Entry& entry) { return entry._key._moduleId == moduleId; });
+        }
+
+        size_t GetSize()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _entries.size();
+        }
+
+    private:
+        struct Key
+        {
+            Key(uintptr_t moduleId, uint32_t methodToken, bool rejit) :
+                _moduleId(moduleId),
+                _methodToken(methodToken),
+                _rejit(rejit)
+            {}
+
+            bool operator==(const Key& other) const
+            {
+                return _moduleId == other._moduleId && _methodToken == other._methodToken && _rejit == other._rejit;
+            }
+
+            uintptr_t _moduleId;
+            uint32_t _methodToken;
+            bool _rejit;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const
+            {
+                return std::hash<uintptr_t>()(key._moduleId) ^ (std::hash<uint32_t>()(key._methodToken) * 31) ^ (key._rejit ? 1 : 0);
+            }
+        };
+
+        struct Entry
+        {
+            Entry(const Key& key, const xstring_t& assemblyName, RewrittenMethodPtr method) :
+                _key(key),
+                _assemblyName(assemblyName),
+                _method(method)
+            {}
+
+            Key _key;
+            xstring_t _assemblyName;
+            RewrittenMethodPtr _method;
+        };
+
+        typedef std::list<Entry> EntryList;
+
+        template <typename Predicate>
+        void RemoveIf(Predicate predicate)
+        {
+            for (auto entry = _entries.begin(); entry != _entries.end();)
+            {
+                if (predicate(*entry))
+                {
+                    _index.erase(entry->_key);
+                    entry = _entries.erase(entry);
+                }
+                else
+                {
+                    ++entry;
+                }
+            }
+        }
+
+        std::mutex _mutex;
+        size_t _maxEntries;
+        uint64_t _generation;
+        EntryList _entries;
+        std::unordered_map<Key, EntryList::iterator, KeyHash> _index;
+    };
+}}}
@@ -20,6 +20,9 @@ namespace NewRelic { namespace Profiler { namespace MethodRewriter { namespace T
 
         std::unique_ptr<xstring_t> TryGetEnvironmentVariable(const xstring_t& variableName) override
         {
+            auto overrideValue = TryGetEnvironmentOverride(variableName);
+            if (overrideValue != nullptr) return overrideValue;
+
             // return nullptr if variableName isn't in the collection
             if (environmentVariables.find(variableName) == environmentVariables.end())
             {
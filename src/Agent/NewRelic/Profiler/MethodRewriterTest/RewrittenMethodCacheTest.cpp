@@ -0,0 +1,90 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdint.h>
+#include <vector>
+#include "CppUnitTest.h"
+#include "../MethodRewriter/RewrittenMethodCache.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace NewRelic { namespace Profiler { namespace MethodRewriter { namespace Test
+{
+    TEST_CLASS(RewrittenMethodCacheTest)
+    {
+    public:
+        TEST_METHOD(get_returns_what_was_put)
+        {
+            RewrittenMethodCache cache;
+            std::vector<uint8_t> method = { 0x1b, 0x30, 0x02, 0x2a };
+
+            cache.Put(1, 0x06000001, true, _X("MyAssembly"), cache.GetGeneration(), method);
+
+            auto cached = cache.Get(1, 0x06000001, true);
+            Assert::IsTrue(cached != nullptr);
+            Assert::IsTrue(method == *cached);
+        }
+
+        TEST_METHOD(keys_include_module_method_and_path)
+        {
+            RewrittenMethodCache cache;
+            cache.Put(1, 0x06000001, true, _X("MyAssembly"), cache.GetGeneration(), std::vector<uint8_t>(1, 0x2a));
+
+            Assert::IsTrue(cache.Get(2, 0x06000001, true) == nullptr);
+            Assert::IsTrue(cache.Get(1, 0x06000002, true) == nullptr);
+            Assert::IsTrue(cache.Get(1, 0x06000001, false) == nullptr);
+        }
+
+        TEST_METHOD(least_recently_used_entry_is_evicted)
+        {
+            RewrittenMethodCache cache(2);
+            cache.Put(1, 0x06000001, true, _X("MyAssembly"), cache.GetGeneration(), std::vector<uint8_t>(1, 0x01));
+            cache.Put(1, 0x06000002, true, _X("MyAssembly"), cache.GetGeneration(), std::vector<uint8_t>(1, 0x02));
+            cache.Get(1, 0x06000001, true);
+
+            cache.Put(1, 0x06000003, true, _X("MyAssembly"), cache.GetGeneration(), std::vector<uint8_t>(1, 0x03));
+
+            Assert::AreEqual(size_t(2), cache.GetSize());
+            Assert::IsTrue(cache.Get(1, 0x06000001, true) != nullptr);
+            Assert::IsTrue(cache.Get(1, 0x06000002, true) == nullptr);
+            Assert::IsTrue(cache.Get(1, 0x06000003, true) != nullptr);
+        }
+
+        TEST_METHOD(invalidating_an_assembly_only_drops_its_entries)
+        {
+            RewrittenMethodCache cache;
+            cache.Put(1, 0x06000001, true, _X("MyAssembly"), cache.GetGeneration(), std::vector<uint8_t>(1, 0x2a));
+            cache.Put(2, 0x06000001, true, _X("OtherAssembly"), cache.GetGeneration(), std::vector<uint8_t>(1, 0x2a));
+
+            std::set<xstring_t> changed = { _X("MYASSEMBLY") };
+            cache.InvalidateAssemblies(changed);
+
+            Assert::IsTrue(cache.Get(1, 0x06000001, true) == nullptr);
+            Assert::IsTrue(cache.Get(2, 0x06000001, true) != nullptr);
+        }
+
+        TEST_METHOD(invalidating_a_module_drops_its_entries)
+        {
+            RewrittenMethodCache cache;
+            cache.Put(1, 0x06000001, false, _X("MyAssembly"), cache.GetGeneration(), std::vector<uint8_t>(1, 0x2a));
+            cache.Put(2, 0x06000001, false, _X("MyAssembly"), cache.GetGeneration(), std::vector<uint8_t>(1, 0x2a));
+
+            cache.InvalidateModule(1);
+
+            Assert::IsTrue(cache.Get(1, 0x06000001, false) == nullptr);
+            Assert::IsTrue(cache.Get(2, 0x06000001, false) != nullptr);
+        }
+
+        TEST_METHOD(rewrite_started_before_an_invalidation_is_not_cached)
+        {
+            RewrittenMethodCache cache;
+            auto generation = cache.GetGeneration();
+
+            cache.InvalidateAssemblies(std::set<xstring_t>());
+            cache.Put(1, 0x06000001, true, _X("MyAssembly"), generation, std::vector<uint8_t>(1, 0x2a));
+
+            Assert::IsTrue(cache.Get(1, 0x06000001, true) == nullptr);
+            Assert::AreEqual(size_t(0), cache.GetSize());
+        }
+    };
+}}}}
@@ -309,6 +309,110 @@ namespace NewRelic { namespace Profiler { namespace MethodRewriter { namespace T
             Assert::IsFalse(_systemCalls.IsAzureFunctionLogLevelOverrideEnabled());
         }
 
+        TEST_METHOD(GetThreadProfilingEventsAtStartup_DefaultsToFalse)
+        {
+            Assert::IsFalse(_systemCalls.GetThreadProfilingEventsAtStartup());
+
+            _systemCalls.environmentVariables[_X("NEW_RELIC_THREAD_PROFILING_EVENTS_AT_STARTUP")] = _X("true");
+            Assert::IsTrue(_systemCalls.GetThreadProfilingEventsAtStartup());
+        }
+
+        TEST_METHOD(GetReJITCoalescingWindowInMilliseconds_ReturnsFallback_WhenEnvironmentVariableIsNotSet)
+        {
+            Assert::AreEqual(100u, _systemCalls.GetReJITCoalescingWindowInMilliseconds(100));
+        }
+
+        TEST_METHOD(GetReJITCoalescingWindowInMilliseconds_ReturnsEnvironmentVariable)
+        {
+            _systemCalls.environmentVariables[_X("NEW_RELIC_REJIT_COALESCING_WINDOW_MS")] = _X("250");
+
+            Assert::AreEqual(250u, _systemCalls.GetReJITCoalescingWindowInMilliseconds(100));
+        }
+
+        TEST_METHOD(GetReJITMaxBatchSize_ReturnsFallback_WhenEnvironmentVariableIsInvalid)
+        {
+            _systemCalls.environmentVariables[_X("NEW_RELIC_REJIT_MAX_BATCH_SIZE")] = _X("lots");
+            Assert::AreEqual(4096u, _systemCalls.GetReJITMaxBatchSize(4096));
+
+            _systemCalls.environmentVariables[_X("NEW_RELIC_REJIT_MAX_BATCH_SIZE")] = _X("-5");
+            Assert::AreEqual(4096u, _systemCalls.GetReJITMaxBatchSize(4096));
+        }
+
+        TEST_METHOD(GetThreadProfilerMaxPauseInMicroseconds_ReturnsEnvironmentVariable)
+        {
+            Assert::AreEqual(0u, _systemCalls.GetThreadProfilerMaxPauseInMicroseconds(0));
+
+            _systemCalls.environmentVariables[_X("NEW_RELIC_THREAD_PROFILER_MAX_PAUSE_US")] = _X("2000");
+            Assert::AreEqual(2000u, _systemCalls.GetThreadProfilerMaxPauseInMicroseconds(0));
+        }
+
+        TEST_METHOD(SetEnvironmentOverridesFromClientData_ParsesEachAssignment)
+        {
+            MockSystemCalls systemCalls;
+            const char data[] = "CORECLR_NEW_RELIC_HOME=/usr/local/newrelic-dotnet-agent\0NEW_RELIC_LOG_LEVEL=debug=verbose";
+
+            Assert::AreEqual(2, systemCalls.SetEnvironmentOverridesFromClientData(data, sizeof(data) - 1));
+            Assert::AreEqual(L"/usr/local/newrelic-dotnet-agent", systemCalls.TryGetEnvironmentVariable(_X("CORECLR_NEW_RELIC_HOME"))->c_str());
+            Assert::AreEqual(L"debug=verbose", systemCalls.TryGetEnvironmentVariable(_X("NEW_RELIC_LOG_LEVEL"))->c_str());
+        }
+
+        TEST_METHOD(SetEnvironmentOverridesFromClientData_SkipsEntriesWithoutAName)
+        {
+            MockSystemCalls systemCalls;
+            const char data[] = "\0=value\0novalue\0\0NEW_RELIC_FORCE_PROFILING=\0";
+
+            Assert::AreEqual(1, systemCalls.SetEnvironmentOverridesFromClientData(data, sizeof(data)));
+            Assert::IsTrue(systemCalls.TryGetEnvironmentVariable(_X("NEW_RELIC_FORCE_PROFILING"))->empty());
+            Assert::IsTrue(systemCalls.TryGetEnvironmentVariable(_X("novalue")) == nullptr);
+            Assert::IsTrue(systemCalls.TryGetEnvironmentVariable(_X("")) == nullptr);
+        }
+
+        TEST_METHOD(SetEnvironmentOverridesFromClientData_SkipsInvalidUtf8)
+        {
+            MockSystemCalls systemCalls;
+            const char data[] = "NEW_RELIC_LOG_LEVEL=\xff\xfe\0NEW_RELIC_LOG_DIRECTORY=/tmp/\xc3\xa9";
+
+            Assert::AreEqual(1, systemCalls.SetEnvironmentOverridesFromClientData(data, sizeof(data) - 1));
+            Assert::IsTrue(systemCalls.GetNewRelicLogLevel() == nullptr);
+            Assert::AreEqual(L"/tmp/\u00e9", systemCalls.GetNewRelicLogDirectory()->c_str());
+        }
+
+        TEST_METHOD(SetEnvironmentOverridesFromClientData_OverridesButDoesNotChangeTheEnvironment)
+        {
+            MockSystemCalls systemCalls;
+            systemCalls.SetCoreAgent(true);
+            systemCalls.environmentVariables[L"CORECLR_NEW_RELIC_HOME"] = L"/opt/environment";
+            systemCalls.environmentVariables[L"NEW_RELIC_LOG_LEVEL"] = L"info";
+            const char data[] = "CORECLR_NEW_RELIC_HOME=/opt/client-data\0NEW_RELIC_LOG_LEVEL=debug\0NEW_RELIC_LOG_LEVEL=finest";
+
+            Assert::AreEqual(3, systemCalls.SetEnvironmentOverridesFromClientData(data, sizeof(data) - 1));
+            Assert::AreEqual(L"/opt/client-data", systemCalls.GetNewRelicHomePath()->c_str());
+            // the last assignment of a name wins
+            Assert::AreEqual(L"finest", systemCalls.GetNewRelicLogLevel()->c_str());
+
+            Assert::AreEqual(L"/opt/environment", systemCalls.environmentVariables[L"CORECLR_NEW_RELIC_HOME"].c_str());
+            Assert::AreEqual(L"info", systemCalls.environmentVariables[L"NEW_RELIC_LOG_LEVEL"].c_str());
+        }
+
+        TEST_METHOD(IsAttachSupported_IsFalse_OnFramework)
+        {
+            MockSystemCalls systemCalls;
+            systemCalls.SetCoreAgent(false);
+            Assert::IsFalse(systemCalls.IsAttachSupported());
+
+            // client data doesn't change that
+            const char data[] = "NEW_RELIC_FORCE_PROFILING=1";
+            systemCalls.SetEnvironmentOverridesFromClientData(data, sizeof(data) - 1);
+            Assert::IsFalse(systemCalls.IsAttachSupported());
+        }
+
+        TEST_METHOD(IsAttachSupported_IsTrue_OnCoreClr)
+        {
+            MockSystemCalls systemCalls;
+            systemCalls.SetCoreAgent(true);
+            Assert::IsTrue(systemCalls.IsAttachSupported());
+        }
+
     private:
         MockSystemCalls _systemCalls;
     };
@@ -111,11 +111,7 @@ namespace NewRelic { namespace Profiler { namespace ModuleInjector
     private:
         static ByteVector ToSignature(const std::wstring& signature, const sicily::codegen::ITokenizerPtr& tokenizer)
         {
-            sicily::Scanner scanner(signature);
-            sicily::Parser parser;
-            sicily::ast::TypePtr type = parser.Parse(scanner);
-            sicily::codegen::ByteCodeGenerator generator(tokenizer);
-            return generator.TypeToBytes(type);
+            return sicily::CompiledSignatureCache::GetBytes(signature)->ResolveBytes(*tokenizer);
         }
 
         static bool EnsureReferenceToMscorlib(IModule& module)
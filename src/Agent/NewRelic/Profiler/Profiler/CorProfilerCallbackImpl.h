@@ -11,16 +11,23 @@
 #include "../Logging/Logger.h"
 #include "../MethodRewriter/CustomInstrumentation.h"
 #include "../MethodRewriter/MethodRewriter.h"
+#include "../MethodRewriter/RewrittenMethodCache.h"
 #include "../SignatureParser/Exceptions.h"
 #include "../ThreadProfiler/ThreadProfiler.h"
+#include "../Common/EpochReclaimer.h"
 #include "../Common/FileUtils.h"
+#include "../Common/StripedMap.h"
 #include "Function.h"
 #include "FunctionResolver.h"
+#include "InstrumentationRefreshQueue.h"
+#include "ModuleRegistry.h"
+#include "ReJITScheduler.h"
 #include "Win32Helpers.h"
 #include "guids.h"
 #include <fstream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <utility>
@@ -40,8 +47,12 @@ namespace NewRelic { namespace Profiler {
 #pragma warning(push)
 #pragma warning(disable : 4100)
 
-    const ULONG METHOD_ENUM_BATCH_SIZE = 5;
     const ULONG MODULE_ENUM_BATCH_SIZE = 100;
+    const ULONG METHOD_ENUM_BATCH_SIZE = 100;
+    const ULONG ATTRIBUTE_ENUM_BATCH_SIZE = 100;
+
+    // only the thread profiler needs these, and both can be turned on after initialization
+    const DWORD THREAD_PROFILING_EVENTS = COR_PRF_MONITOR_THREADS | COR_PRF_ENABLE_STACK_SNAPSHOT;
     using NewRelic::Profiler::MethodRewriter::FilePaths;
 
     class ClassAndMethodName {
@@ -67,7 +78,7 @@ namespace NewRelic { namespace Profiler {
 
     typedef std::set<xstring_t> FilePaths;
 
-    class CorProfilerCallbackImpl : public ICorProfilerCallback4 {
+    class CorProfilerCallbackImpl : public ICorProfilerCallback9 {
 
     private:
         std::atomic<int> _referenceCount;
@@ -100,7 +111,27 @@ namespace NewRelic { namespace Profiler {
         virtual HRESULT __stdcall AssemblyUnloadStarted(AssemblyID assemblyId) override { return S_OK; }
         virtual HRESULT __stdcall AssemblyUnloadFinished(AssemblyID assemblyId, HRESULT hrStatus) override { return S_OK; }
         virtual HRESULT __stdcall ModuleLoadStarted(ModuleID moduleId) override { return S_OK; }
-        virtual HRESULT __stdcall ModuleUnloadStarted(ModuleID moduleId) override { return S_OK; }
+        virtual HRESULT __stdcall ModuleUnloadStarted(ModuleID moduleId) override
+        {
+            LogTrace(__func__, L". ", moduleId);
+            _modules.Remove(moduleId);
+            _rewrittenMethods.InvalidateModule(moduleId);
+            _threadProfiler.ModuleUnloaded(moduleId);
+            if (_rejitScheduler != nullptr) {
+                _rejitScheduler->DropModule(moduleId);
+            }
+            ForgetModule(moduleId);
+
+            // callbacks that are already running may still add state for the module, so it is cleared again once
+            // they have all returned
+            _moduleStateReclaimer.Retire([this, moduleId] {
+                ForgetModule(moduleId);
+                if (_rejitScheduler != nullptr) {
+                    _rejitScheduler->ReleaseDroppedModule(moduleId);
+                }
+            });
+            return S_OK;
+        }
         virtual HRESULT __stdcall ModuleUnloadFinished(ModuleID moduleId, HRESULT hrStatus) override { return S_OK; }
         virtual HRESULT __stdcall ModuleAttachedToAssembly(ModuleID moduleId, AssemblyID AssemblyId) override { return S_OK; }
         virtual HRESULT __stdcall ClassLoadStarted(ClassID classId) override { return S_OK; }
@@ -113,8 +144,6 @@ namespace NewRelic { namespace Profiler {
         virtual HRESULT __stdcall JITCachedFunctionSearchFinished(FunctionID functionId, COR_PRF_JIT_CACHE result) override { return S_OK; }
         virtual HRESULT __stdcall JITFunctionPitched(FunctionID functionId) override { return S_OK; }
         virtual HRESULT __stdcall JITInlining(FunctionID callerId, FunctionID calleeId, BOOL* pfShouldInline) override { return S_OK; }
-        virtual HRESULT __stdcall ThreadCreated(ThreadID threadId) override { return S_OK; }
-        virtual HRESULT __stdcall ThreadAssignedToOSThread(ThreadID managedThreadId, DWORD osThreadId) override { return S_OK; }
         virtual HRESULT __stdcall RemotingClientInvocationStarted() override { return S_OK; }
         virtual HRESULT __stdcall RemotingClientSendingMessage(GUID* pCookie, BOOL fIsAsync) override { return S_OK; }
         virtual HRESULT __stdcall RemotingClientReceivingReply(GUID* pCookie, BOOL fIsAsync) override { return S_OK; }
@@ -167,8 +196,6 @@ namespace NewRelic { namespace Profiler {
         virtual HRESULT __stdcall ThreadNameChanged(ThreadID threadId, ULONG cchName, _In_reads_opt_(cchName) WCHAR name[]) override { return S_OK; }
 
         // Unimplemented ICorProfilerCallback3
-        virtual HRESULT __stdcall InitializeForAttach(IUnknown* pCorProfilerInfoUnk, void* pvClientData, UINT cbClientData) override { return S_OK; }
-        virtual HRESULT __stdcall ProfilerAttachComplete(void) override { return S_OK; }
         virtual HRESULT __stdcall ProfilerDetachSucceeded(void) override { return S_OK; }
 
         // Unimplemented ICorProfilerCallback4
@@ -177,6 +204,22 @@ namespace NewRelic { namespace Profiler {
         virtual HRESULT __stdcall MovedReferences2(ULONG cMovedObjectIDRanges, ObjectID oldObjectIDRangeStart[], ObjectID newObjectIDRangeStart[], SIZE_T cObjectIDRangeLength[]) override { return S_OK; }
         virtual HRESULT __stdcall SurvivingReferences2(ULONG cSurvivingObjectIDRanges, ObjectID objectIDRangeStart[], SIZE_T cObjectIDRangeLength[]) override { return S_OK; }
 
+        // Unimplemented ICorProfilerCallback5
+        virtual HRESULT __stdcall ConditionalWeakTableElementReferences(ULONG cRootRefs, ObjectID keyRefIds[], ObjectID valueRefIds[], GCHandleID rootIds[]) override { return S_OK; }
+
+        // Unimplemented ICorProfilerCallback6
+        virtual HRESULT __stdcall GetAssemblyReferences(const WCHAR* wszAssemblyPath, ICorProfilerAssemblyReferenceProvider* pAsmRefProvider) override { return S_OK; }
+
+        // Unimplemented ICorProfilerCallback7
+        virtual HRESULT __stdcall ModuleInMemorySymbolsUpdated(ModuleID moduleId) override { return S_OK; }
+
+        // Unimplemented ICorProfilerCallback8
+        virtual HRESULT __stdcall DynamicMethodJITCompilationStarted(FunctionID functionId, BOOL fIsSafeToBlock, LPCBYTE pILHeader, ULONG cbILHeader) override { return S_OK; }
+        virtual HRESULT __stdcall DynamicMethodJITCompilationFinished(FunctionID functionId, HRESULT hrStatus, BOOL fIsSafeToBlock) override { return S_OK; }
+
+        // Unimplemented ICorProfilerCallback9
+        virtual HRESULT __stdcall DynamicMethodUnloaded(FunctionID functionId) override { return S_OK; }
+
         // Base profiler initialization method
         virtual HRESULT __stdcall Initialize(IUnknown* pICorProfilerInfoUnk) override
         {
@@ -184,6 +227,44 @@ namespace NewRelic { namespace Profiler {
             DelayProfilerAttach();
 #endif
 
+            return InitializeProfiler(pICorProfilerInfoUnk, false);
+        }
+
+        // ICorProfilerCallback3
+        // Called instead of Initialize when a diagnostics client attaches the profiler to a process that is already running
+        virtual HRESULT __stdcall InitializeForAttach(IUnknown* pCorProfilerInfoUnk, void* pvClientData, UINT cbClientData) override
+        {
+            if (pvClientData != nullptr && cbClientData > 0) {
+                // nothing can be logged yet, the environment decides where the log goes
+                _systemCalls->SetEnvironmentOverridesFromClientData(static_cast<const char*>(pvClientData), cbClientData);
+            }
+
+            return InitializeProfiler(pCorProfilerInfoUnk, true);
+        }
+
+        // ICorProfilerCallback3
+        // Methods that ran before the profiler attached have already been jitted, so everything in the modules that are
+        // loaded by now gets instrumented through ReJIT.  Modules that load from here on go through ModuleLoadFinished.
+        virtual HRESULT __stdcall ProfilerAttachComplete(void) override
+        {
+            if (!_attached) {
+                return S_OK;
+            }
+
+            auto moduleStateGuard = _moduleStateReclaimer.Enter();
+            try {
+                auto moduleCount = InstrumentLoadedModules();
+                _rejitScheduler->Flush();
+                LogInfo(L"Instrumented ", moduleCount, L" modules that were loaded before the profiler attached");
+            }
+            catch (...) {
+                LogError(L"An exception was thrown while instrumenting the modules loaded before the profiler attached.");
+            }
+            return S_OK;
+        }
+
+        HRESULT InitializeProfiler(IUnknown* pICorProfilerInfoUnk, bool attaching)
+        {
             // initialization stuff, they should be logging their own errors and only throwing up if they want to cancel activation
             try
             {
@@ -241,8 +322,18 @@ namespace NewRelic { namespace Profiler {
                     return CORPROF_E_PROFILER_CANCEL_ACTIVATION;
                 }
 
+                if (attaching) {
+                    if (!_systemCalls->IsAttachSupported()) {
+                        LogError(L"Attaching to a running process is only supported on .NET Core. Profiler not attaching.");
+                        return CORPROF_E_PROFILER_CANCEL_ACTIVATION;
+                    }
+                    LogInfo(L"Profiler attaching to a running process");
+                    _attached = true;
+                }
+
                 //Init does not start threads or requires cleanup. RequestProfile will create the threads for the TP.
                 _threadProfiler.Init(_corProfilerInfo4);
+                _threadProfiler.SetMaxPauseInMicroseconds(_systemCalls->GetThreadProfilerMaxPauseInMicroseconds(0));
 
 
                 HRESULT corePathInitResult = InitializeAndSetAgentCoreDllPath(_productName);
@@ -266,7 +357,14 @@ namespace NewRelic { namespace Profiler {
                     return CORPROF_E_PROFILER_CANCEL_ACTIVATION;
                 }
 
-                _functionResolver = std::make_shared<FunctionResolver>(_corProfilerInfo4);
+                _rejitScheduler = std::make_shared<ReJITScheduler>(
+                    [this](ULONG count, ModuleID* moduleIds, mdMethodDef* methodIds) { return _corProfilerInfo4->RequestReJIT(count, moduleIds, methodIds); },
+                    [this](ULONG count, ModuleID* moduleIds, mdMethodDef* methodIds) { return _corProfilerInfo4->RequestRevert(count, moduleIds, methodIds, nullptr); },
+                    _systemCalls->GetReJITCoalescingWindowInMilliseconds(ReJITScheduler::DefaultCoalescingWindowInMilliseconds),
+                    _systemCalls->GetReJITMaxBatchSize(ReJITScheduler::DefaultMaxBatchSize));
+                _functionResolver = std::make_shared<FunctionResolver>(_corProfilerInfo4, _rejitScheduler);
+                _instrumentationRefreshQueue = std::make_shared<InstrumentationRefreshQueue>(
+                    [this](Configuration::IgnoreInstrumentationListPtr ignoreList) { return RefreshInstrumentation(ignoreList); });
 
                 ConfigureEventMask(pICorProfilerInfoUnk);
 
@@ -288,19 +386,9 @@ namespace NewRelic { namespace Profiler {
             if (_isCoreClr)
             {
                 if (SUCCEEDED(hrStatus)) {
+                    auto moduleStateGuard = _moduleStateReclaimer.Enter();
                     try {
-                        auto assemblyName = GetAssemblyName(moduleId);
-
-                        if (GetMethodRewriter()->ShouldInstrumentAssembly(assemblyName)) {
-                            LogTrace("Assembly module loaded: ", assemblyName);
-
-                            auto instrumentationPoints = std::make_shared<Configuration::InstrumentationPointSet>(GetMethodRewriter()->GetAssemblyInstrumentation(assemblyName));
-                            auto methodDefs = GetMethodDefs(moduleId, instrumentationPoints);
-
-                            if (methodDefs != nullptr) {
-                                RejitModuleFunctions(moduleId, methodDefs);
-                            }
-                        }
+                        InstrumentModule(moduleId);
                     }
                     catch (...) {
                     }
@@ -317,6 +405,14 @@ namespace NewRelic { namespace Profiler {
                     return hrStatus;
                 }
 
+                try
+                {
+                    _modules.Add(moduleId, GetAssemblyName(moduleId));
+                }
+                catch (...)
+                {
+                }
+
                 LogTrace("Module Injection Started. ", moduleId);
 
                 ModuleInjector::IModulePtr module;
@@ -352,6 +448,68 @@ namespace NewRelic { namespace Profiler {
         }
 
 
+        // Drops the state kept for a module.  Its id, and the ids of its functions, can be handed out again once it has unloaded.
+        void ForgetModule(ModuleID moduleId)
+        {
+            if (_functionResolver != nullptr) {
+                _functionResolver->ForgetModule(moduleId);
+            }
+            _functionsHandledOnJit.EraseIf([moduleId](FunctionID, ModuleID owner) { return owner == moduleId; });
+        }
+
+        // Registers a CoreCLR module and queues a ReJIT for every method in it that should be instrumented
+        void InstrumentModule(ModuleID moduleId)
+        {
+            auto assemblyName = GetAssemblyName(moduleId);
+            _modules.Add(moduleId, assemblyName);
+            std::shared_ptr<std::set<mdMethodDef>> methodDefs;
+
+            if (GetMethodRewriter()->ShouldInstrumentAssembly(assemblyName)) {
+                LogTrace("Assembly module loaded: ", assemblyName);
+
+                auto instrumentationPoints = std::make_shared<Configuration::InstrumentationPointSet>(GetMethodRewriter()->GetAssemblyInstrumentation(assemblyName));
+                methodDefs = GetMethodDefs(moduleId, instrumentationPoints);
+            }
+
+            if (_usePrecompiledCode || _instrumentWithReJITOnly) {
+                // JITCompilationStarted won't see precompiled methods, or any method at all in ReJIT-only mode,
+                // so find the ones it would have instrumented now
+                auto jitInstrumentedMethodDefs = GetMethodDefsInstrumentedWithoutPoints(moduleId, assemblyName);
+                if (methodDefs == nullptr) {
+                    methodDefs = jitInstrumentedMethodDefs;
+                } else if (jitInstrumentedMethodDefs != nullptr) {
+                    methodDefs->insert(jitInstrumentedMethodDefs->begin(), jitInstrumentedMethodDefs->end());
+                }
+            }
+
+            if (methodDefs != nullptr) {
+                RejitModuleFunctions(moduleId, methodDefs);
+            }
+        }
+
+        // Instruments every module the runtime has loaded so far and returns how many were instrumented.  A module that
+        // finishes loading while this runs can be instrumented twice, which only costs a duplicate ReJIT request.
+        ULONG InstrumentLoadedModules()
+        {
+            CComPtr<ICorProfilerModuleEnum> moduleEnum;
+            ThrowOnError(_corProfilerInfo4->EnumModules, &moduleEnum);
+
+            ULONG instrumented = 0;
+            ModuleID moduleIds[MODULE_ENUM_BATCH_SIZE];
+            for (ULONG fetchSize = 0; SUCCEEDED(moduleEnum->Next(MODULE_ENUM_BATCH_SIZE, moduleIds, &fetchSize)) && fetchSize;) {
+                for (ULONG i = 0; i < fetchSize; i++) {
+                    try {
+                        InstrumentModule(moduleIds[i]);
+                        instrumented++;
+                    }
+                    catch (...) {
+                        // still loading or already unloading, ModuleLoadFinished covers the former
+                    }
+                }
+            }
+            return instrumented;
+        }
+
         virtual DWORD OverrideEventMask(DWORD eventMask)
         {
 #ifndef PAL_STDCPP_COMPAT
@@ -365,17 +523,50 @@ namespace NewRelic { namespace Profiler {
 
         virtual void ConfigureEventMask(IUnknown* pICorProfilerInfoUnk)
         {
+            if (_systemCalls->GetThreadProfilingEventsAtStartup()) {
+                LogInfo(L"Thread profiling events enabled at startup by NEW_RELIC_THREAD_PROFILING_EVENTS_AT_STARTUP.");
+                _eventMask |= THREAD_PROFILING_EVENTS;
+                _threadProfilingEventsEnabled = true;
+            }
+
             if (_isCoreClr)
             {
-                // register for events that we are interested in getting callbacks for
-// SetEventMask2 requires ICorProfilerInfo5. It allows setting the high-order bits of the profiler event mask.
-// 0x8 = COR_PRF_HIGH_DISABLE_TIERED_COMPILATION <- this was introduced in ICorProfilerCallback9 which we're not currently implementing
-// see this PR: https://github.com/dotnet/coreclr/pull/14643/files#diff-e7d550d94de30cdf5e7f3a25647a2ae1R626
-// Just passing in the hardcoded 0x8 seems to actually disable tiered compilation,
-// but we should see about actually referencing and implementing ICorProfilerCallback9
+                if (_attached) {
+                    // images that are already loaded can't be swapped out, so the precompiled code stays in use and
+                    // only the flags a profiler may set after attaching are kept
+                    _usePrecompiledCode = true;
+                    _eventMask &= COR_PRF_ALLOWABLE_AFTER_ATTACH;
+                }
+                else if (_systemCalls->GetUsePrecompiledCode()) {
+                    // leave ReadyToRun code in use; the methods we instrument are replaced through ReJIT instead
+                    LogInfo(L"Precompiled code enabled by NEW_RELIC_USE_PRECOMPILED_CODE.");
+                    _usePrecompiledCode = true;
+                    _eventMask &= ~(COR_PRF_USE_PROFILE_IMAGES | (DWORD)COR_PRF_DISABLE_ALL_NGEN_IMAGES);
+                }
+
+                if (_systemCalls->GetInstrumentWithReJITOnly()) {
+                    // module loads and instrumentation refreshes request every ReJIT, so JITCompilationStarted returns at once.
+                    // COR_PRF_MONITOR_JIT_COMPILATION stays set: without it the runtime doesn't raise ReJITCompilationStarted,
+                    // which is where each instantiation of an instrumented generic method gets its own ReJIT.
+                    LogInfo(L"ReJIT-only instrumentation enabled by NEW_RELIC_INSTRUMENT_WITH_REJIT_ONLY.");
+                    _instrumentWithReJITOnly = true;
+                }
 
+                // register for events that we are interested in getting callbacks for
+                // SetEventMask2 requires ICorProfilerInfo5. It allows setting the high-order bits of the profiler event mask.
+                // Tiered compilation stays on unless it has been turned off explicitly: instrumented methods get their IL
+                // through ReJIT, and every tier of a ReJIT-ed method is compiled from that IL.
                 CComPtr<ICorProfilerInfo5> _corProfilerInfo5;
-                const DWORD COR_PRF_HIGH_DISABLE_TIERED_COMPILATION = 0x8;
+                DWORD highEventMask = COR_PRF_HIGH_MONITOR_NONE;
+                if (_systemCalls->GetIsTieredCompilationDisabled()) {
+                    if (_attached) {
+                        LogWarn(L"NEW_RELIC_DISABLE_TIERED_COMPILATION can't be applied after attaching and will be ignored.");
+                    }
+                    else {
+                        LogInfo(L"Tiered compilation disabled by NEW_RELIC_DISABLE_TIERED_COMPILATION.");
+                        highEventMask |= COR_PRF_HIGH_DISABLE_TIERED_COMPILATION;
+                    }
+                }
 
                 if (FAILED(pICorProfilerInfoUnk->QueryInterface(__uuidof(ICorProfilerInfo5), (void**)&_corProfilerInfo5))) {
                     LogDebug(L"Calling SetEventMask().");
@@ -383,11 +574,18 @@ namespace NewRelic { namespace Profiler {
                 }
                 else {
                     LogDebug(L"Calling SetEventMask2().");
-                    ThrowOnError(_corProfilerInfo5->SetEventMask2, _eventMask, COR_PRF_HIGH_DISABLE_TIERED_COMPILATION);
+                    ThrowOnError(_corProfilerInfo5->SetEventMask2, _eventMask, highEventMask);
                 }
             }
             else
             {
+                if (_systemCalls->GetUsePrecompiledCode()) {
+                    LogWarn(L"NEW_RELIC_USE_PRECOMPILED_CODE is only supported on .NET Core and will be ignored.");
+                }
+                if (_systemCalls->GetInstrumentWithReJITOnly()) {
+                    LogWarn(L"NEW_RELIC_INSTRUMENT_WITH_REJIT_ONLY is only supported on .NET Core and will be ignored.");
+                }
+
                 // register for events that we are interested in getting callbacks for
                 LogDebug(L"Calling SetEventMask().");
                 ThrowOnError(_corProfilerInfo4->SetEventMask, _eventMask);
@@ -434,7 +632,8 @@ namespace NewRelic { namespace Profiler {
         virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
         {
             if (
-                riid == __uuidof(ICorProfilerCallback4) || riid == __uuidof(ICorProfilerCallback3) || riid == __uuidof(ICorProfilerCallback2) || riid == __uuidof(ICorProfilerCallback) || riid == IID_IUnknown) {
+                riid == __uuidof(ICorProfilerCallback9) || riid == __uuidof(ICorProfilerCallback8) || riid == __uuidof(ICorProfilerCallback7) ||
+                riid == __uuidof(ICorProfilerCallback6) || riid == __uuidof(ICorProfilerCallback5) || riid == __uuidof(ICorProfilerCallback4) || riid == __uuidof(ICorProfilerCallback3) || riid == __uuidof(ICorProfilerCallback2) || riid == __uuidof(ICorProfilerCallback) || riid == IID_IUnknown) {
                 *ppvObject = this;
                 this->AddRef();
                 return S_OK;
@@ -463,7 +662,33 @@ namespace NewRelic { namespace Profiler {
         // ICorProfilerCallback
         virtual HRESULT __stdcall JITCompilationStarted(FunctionID functionId, BOOL /*fIsSafeToBlock*/) override
         {
+            if (_instrumentWithReJITOnly) {
+                return S_OK;
+            }
+
             LogTrace(__func__, L". ", functionId);
+            auto moduleStateGuard = _moduleStateReclaimer.Enter();
+
+            // with tiered compilation the runtime jits a function again for each tier.  Whatever its first JIT did here,
+            // replacing its IL or asking for a ReJIT whose IL every later tier uses, must not be repeated.
+            ModuleID handledModuleId;
+            if (_functionsHandledOnJit.TryGet(functionId, handledModuleId)) {
+                LogTrace(__func__, L" already handled on an earlier tier. ", functionId);
+                return S_OK;
+            }
+
+            ModuleID moduleId;
+            mdToken methodToken;
+            if (_rewrittenMethods.GetSize() > 0 && SUCCEEDED(_corProfilerInfo4->GetFunctionInfo(functionId, nullptr, &moduleId, &methodToken))) {
+                auto method = _rewrittenMethods.Get(moduleId, methodToken, false);
+                if (method != nullptr) {
+                    LogTrace(L"Using cached method body for ", functionId);
+                    _functionsHandledOnJit.Insert(functionId, moduleId);
+                    return WriteRewrittenMethod(moduleId, *method, [&](LPCBYTE pHeader, ULONG) {
+                        return _corProfilerInfo4->SetILFunctionBody(moduleId, methodToken, pHeader);
+                    });
+                }
+            }
 
             auto setILFunctionBody = [&](Function& function, LPCBYTE pHeader, ULONG) {
                 return _corProfilerInfo4->SetILFunctionBody(function.GetModuleID(), function.GetMethodToken(), pHeader);
@@ -477,20 +702,21 @@ namespace NewRelic { namespace Profiler {
             return hr;
         }
 
-        // Requests a function ReJIT.
+        // Queues a function ReJIT, the scheduler batches it with any others found around the same time.
         HRESULT RejitFunction(Function& function)
         {
             LogDebug(L"Request reJIT: [", function.GetFunctionId(), "] ", function.ToString());
             _functionResolver->AddFunctionIfGeneric(function);
+            _functionsHandledOnJit.Insert(function.GetFunctionId(), function.GetModuleID());
 
-            ModuleID moduleIds = { function.GetModuleID() };
-            mdMethodDef methodIds = { function.GetMethodToken() };
-            return _corProfilerInfo4->RequestReJIT(1, &moduleIds, &methodIds);
+            _rejitScheduler->ReJIT(function.GetModuleID(), function.GetMethodToken());
+            return S_OK;
         }
 
         virtual HRESULT __stdcall ReJITCompilationStarted(FunctionID functionId, ReJITID /*rejitId*/, BOOL /*fIsSafeToBlock*/) override
         {
             LogTrace(__func__, L". ", functionId);
+            auto moduleStateGuard = _moduleStateReclaimer.Enter();
             _functionResolver->RequestGenericMethodReJIT(functionId);
             LogTrace(__func__, L"Finished. ", functionId);
             return S_OK;
@@ -499,6 +725,16 @@ namespace NewRelic { namespace Profiler {
         virtual HRESULT __stdcall GetReJITParameters(ModuleID moduleId, mdMethodDef methodId, ICorProfilerFunctionControl* pFunctionControl) override
         {
             LogTrace(__func__, L" called");
+            auto moduleStateGuard = _moduleStateReclaimer.Enter();
+
+            // generic methods share one body across instantiations, so a cached one saves resolving the function too
+            auto method = _rewrittenMethods.Get(moduleId, methodId, true);
+            if (method != nullptr) {
+                LogTrace(L"ReJIT using cached method body for ", methodId);
+                return WriteRewrittenMethod(moduleId, *method, [&](LPCBYTE pHeader, ULONG size) {
+                    return pFunctionControl->SetILFunctionBody(size, pHeader);
+                });
+            }
 
             HRESULT hr = S_FALSE;
             auto functionId = _functionResolver->GetFunctionId(moduleId, methodId);
@@ -519,12 +755,27 @@ namespace NewRelic { namespace Profiler {
         HRESULT __stdcall ProcessMethodJit(FunctionID functionId, bool injectMethodInstrumentation,
             std::function<HRESULT(Function&, LPCBYTE, ULONG)> setILFunctionBody)
         {
+            // read before the method rewriter so a refresh that lands mid-rewrite keeps this result out of the cache
+            auto generation = _rewrittenMethods.GetGeneration();
             auto methodRewriter = GetMethodRewriter();
+
+            auto setAndCacheILFunctionBody = [&](Function& function, LPCBYTE pHeader, ULONG size) {
+                auto hr = setILFunctionBody(function, pHeader, size);
+                if (SUCCEEDED(hr)) {
+                    if (!injectMethodInstrumentation) {
+                        _functionsHandledOnJit.Insert(function.GetFunctionId(), function.GetModuleID());
+                    }
+                    _rewrittenMethods.Put(function.GetModuleID(), function.GetMethodToken(), injectMethodInstrumentation,
+                        function.GetAssemblyName(), generation, ByteVector(pHeader, pHeader + size));
+                }
+                return hr;
+            };
+
             MethodRewriter::IFunctionPtr function;
             try {
                 // create the Function object for this method
                 function = Function::Create(_corProfilerInfo4, functionId, methodRewriter, injectMethodInstrumentation,
-          setILFunctionBody,
+          setAndCacheILFunctionBody,
                     [&](Function& function) { return RejitFunction(function); });
                 if (function == nullptr) {
                     LogTrace("JITCompilationStarted Finished. Function Skipped. ", functionId);
@@ -557,9 +808,33 @@ namespace NewRelic { namespace Profiler {
             return S_OK;
         }
 
+        // replays a body produced by an earlier rewrite of the same method
+        HRESULT WriteRewrittenMethod(ModuleID moduleId, const ByteVector& method, std::function<HRESULT(LPCBYTE, ULONG)> setILFunctionBody)
+        {
+            CComPtr<IMethodMalloc> methodAllocator;
+            auto hr = _corProfilerInfo4->GetILFunctionBodyAllocator(moduleId, &methodAllocator);
+            if (FAILED(hr)) {
+                return hr;
+            }
+
+            auto size = ULONG(method.size());
+            auto allocatedSpace = (uint8_t*)methodAllocator->Alloc(size);
+            if (allocatedSpace == nullptr) {
+                return E_OUTOFMEMORY;
+            }
+            memcpy(allocatedSpace, method.data(), size);
+            return setILFunctionBody(allocatedSpace, size);
+        }
+
         virtual HRESULT __stdcall Shutdown() override
         {
             LogInfo(L"Profiler shutting down");
+            if (_instrumentationRefreshQueue != nullptr) {
+                _instrumentationRefreshQueue->Shutdown();
+            }
+            if (_rejitScheduler != nullptr) {
+                _rejitScheduler->Shutdown();
+            }
             _threadProfiler.Shutdown();
             LogInfo(L"Profiler shutdown");
             return S_OK;
@@ -571,6 +846,18 @@ namespace NewRelic { namespace Profiler {
             return _threadProfiler.ThreadDestroyed(threadId);
         }
 
+        // ICorProfilerCallback
+        virtual HRESULT __stdcall ThreadCreated(ThreadID threadId) override
+        {
+            return _threadProfiler.ThreadCreated(threadId);
+        }
+
+        // ICorProfilerCallback
+        virtual HRESULT __stdcall ThreadAssignedToOSThread(ThreadID managedThreadId, DWORD osThreadId) override
+        {
+            return _threadProfiler.ThreadAssignedToOSThread(managedThreadId, osThreadId);
+        }
+
         // Returns a map of assembly name to instrumentation points.
         std::shared_ptr<std::map<xstring_t, Configuration::InstrumentationPointSetPtr>> GroupByAssemblyName(Configuration::InstrumentationPointSetPtr allInstrumentationPoints)
         {
@@ -623,13 +910,29 @@ namespace NewRelic { namespace Profiler {
             return InstrumentationRefreshWithNewIgnoreList(nullptr);
         }
 
+        // Queues a refresh and returns without waiting for it.  GetInstrumentationRefreshStatus reports when it's done and
+        // what it returned.
         HRESULT InstrumentationRefreshWithNewIgnoreList(Configuration::IgnoreInstrumentationListPtr newIgnoreInstrumentationList)
         {
             LogTrace("Enter: ", __func__);
 
-            // We use a mutex in this function because an instrumentation refresh can be triggered for multiple reasons
-            // around the same time and we need the correct ignore list to be applied.
-            std::lock_guard<std::mutex> lock(_instrumentationRefreshMutex);
+            auto generation = _instrumentationRefreshQueue->Request(newIgnoreInstrumentationList);
+            LogTrace("Queued instrumentation refresh ", generation);
+
+            return S_OK;
+        }
+
+        HRESULT GetInstrumentationRefreshStatus(uint64_t& requestedGeneration, uint64_t& completedGeneration)
+        {
+            return _instrumentationRefreshQueue->GetStatus(requestedGeneration, completedGeneration);
+        }
+
+        // Runs on the refresh queue's thread.  That is never a managed thread, so it can ask the runtime for rejits
+        // directly, and it only runs one refresh at a time so the latest ignore list is always the one applied.
+        HRESULT RefreshInstrumentation(Configuration::IgnoreInstrumentationListPtr newIgnoreInstrumentationList)
+        {
+            LogTrace("Enter: ", __func__);
+            auto moduleStateGuard = _moduleStateReclaimer.Enter();
 
             auto instrumentationXmls = GetInstrumentationXmlsFromDisk(_systemCalls);
             auto customXml = _customInstrumentation.GetCustomInstrumentationXml();
@@ -653,15 +956,17 @@ namespace NewRelic { namespace Profiler {
 
             auto oldInstrumentationPoints = oldMethodRewriter->GetInstrumentationConfiguration()->GetInstrumentationPoints();
 
+            // cached bodies of assemblies whose instrumentation didn't change are still what a rewrite would produce
+            auto changedAssemblies = oldMethodRewriter->GetInstrumentationConfiguration()->GetChangedAssemblies(*instrumentationConfiguration);
+            LogTrace("Instrumentation changed for ", changedAssemblies.size(), " assemblies");
+            _rewrittenMethods.InvalidateAssemblies(changedAssemblies);
+
             SetMethodRewriter(std::make_shared<MethodRewriter::MethodRewriter>(instrumentationConfiguration, _agentCoreDllPath));
 
             auto oldInstrumentationByAssembly = GroupByAssemblyName(oldInstrumentationPoints);
             auto newInstrumentationByAssembly = GroupByAssemblyName(instrumentationConfiguration->GetInstrumentationPoints());
 
-            std::thread t1(&NewRelic::Profiler::CorProfilerCallbackImpl::RejitInstrumentationPoints, this, oldInstrumentationByAssembly, newInstrumentationByAssembly);
-
-            // block the calling managed thread until the worker thread has finished
-            t1.join();
+            RejitInstrumentationPoints(changedAssemblies, oldInstrumentationByAssembly, newInstrumentationByAssembly);
 
             LogTrace("Leave: ", __func__);
 
@@ -692,66 +997,84 @@ namespace NewRelic { namespace Profiler {
         }
 
         HRESULT RejitInstrumentationPoints(
+            std::set<xstring_t> changedAssemblies,
             std::shared_ptr<std::map<xstring_t, Configuration::InstrumentationPointSetPtr>> oldInstrumentationByAssembly,
             std::shared_ptr<std::map<xstring_t, Configuration::InstrumentationPointSetPtr>> newInstrumentationByAssembly)
         {
-            auto f = __func__;
-            auto TOE = [f](HRESULT hr) { if (FAILED(hr)) { LogError("Function '", f, "' failed.  HRESULT: ", hr); throw Win32Exception(hr); } };
+            // modules of assemblies whose instrumentation didn't change have nothing to revert or rejit
+            auto modules = _modules.GetModules(changedAssemblies);
+            LogTrace("Refreshing instrumentation in ", modules.size(), " of ", _modules.GetSize(), " modules");
 
-            CComPtr<ICorProfilerModuleEnum> moduleEnum;
-            TOE(_corProfilerInfo4->EnumModules(&moduleEnum));
-
-            ModuleID moduleIds[MODULE_ENUM_BATCH_SIZE];
-            for (ULONG elementsFetched; SUCCEEDED(moduleEnum->Next(MODULE_ENUM_BATCH_SIZE, moduleIds, &elementsFetched)) && elementsFetched;) {
-                for (ULONG i = 0; i < elementsFetched; i++) {
-                    try {
-                        auto assemblyName = GetAssemblyName(moduleIds[i]);
+            for (auto& module : modules) {
+                try {
+                    auto moduleId = module.first;
+                    auto& assemblyName = module.second;
 
-                        std::shared_ptr<std::set<mdMethodDef>> oldMethodDefs = GetMethodDefsForAssembly(moduleIds[i], assemblyName, oldInstrumentationByAssembly);
-                        std::shared_ptr<std::set<mdMethodDef>> newMethodDefs = GetMethodDefsForAssembly(moduleIds[i], assemblyName, newInstrumentationByAssembly);
+                    std::shared_ptr<std::set<mdMethodDef>> oldMethodDefs = GetMethodDefsForAssembly(moduleId, assemblyName, oldInstrumentationByAssembly);
+                    std::shared_ptr<std::set<mdMethodDef>> newMethodDefs = GetMethodDefsForAssembly(moduleId, assemblyName, newInstrumentationByAssembly);
 
-                        // remove new (to be instrumented) methods from old methods
-                        if (newMethodDefs != nullptr && oldMethodDefs != nullptr) {
-                            for (auto method : *newMethodDefs) {
-                                oldMethodDefs->erase(method);
-                            }
+                    // remove new (to be instrumented) methods from old methods
+                    if (newMethodDefs != nullptr && oldMethodDefs != nullptr) {
+                        for (auto method : *newMethodDefs) {
+                            oldMethodDefs->erase(method);
                         }
-
-                        RevertModuleFunctions(moduleIds[i], oldMethodDefs);
-                        RejitModuleFunctions(moduleIds[i], newMethodDefs);
-                    } catch (...) {
                     }
+
+                    RevertModuleFunctions(moduleId, oldMethodDefs);
+                    RejitModuleFunctions(moduleId, newMethodDefs);
+                } catch (...) {
                 }
             }
 
+            // the refresh isn't finished until the runtime has been told about every module
+            _rejitScheduler->Flush();
             return S_OK;
         }
 
+        // The methods in this module that the given points will instrument.  Overloads whose parameters don't match and
+        // points whose version range excludes this assembly are filtered out here, so the only methods queued for a
+        // rejit are ones the rewriter will accept.
         std::shared_ptr<std::set<mdMethodDef>> GetMethodDefs(ModuleID moduleId, NewRelic::Profiler::Configuration::InstrumentationPointSetPtr instrumentationPoints)
         {
-            CComPtr<IMetaDataImport> pImport = nullptr;
+            CComPtr<IMetaDataImport2> pImport = nullptr;
             CComPtr<IUnknown> pUnk = nullptr;
 
-            if (FAILED(_corProfilerInfo4->GetModuleMetaData(moduleId, ofRead, IID_IMetaDataImport, &pUnk)) || FAILED(pUnk->QueryInterface(IID_IMetaDataImport, (LPVOID*)&pImport))) {
+            if (FAILED(_corProfilerInfo4->GetModuleMetaData(moduleId, ofRead, IID_IMetaDataImport2, &pUnk)) || FAILED(pUnk->QueryInterface(IID_IMetaDataImport2, (LPVOID*)&pImport))) {
                 // Without a handle to the import api we can't do anything so just bail
                 return nullptr;
             }
 
+            std::unique_ptr<AssemblyVersion> assemblyVersion;
+            auto tokenResolver = std::make_shared<CorTokenResolver>(pImport);
+
             std::shared_ptr<std::set<mdMethodDef>> methodDefs = std::make_shared<std::set<mdMethodDef>>();
             for (const auto& instrumentationPoint : *instrumentationPoints) {
                 LogTrace("Fetching ", instrumentationPoint->ClassName, " methods");
 
+                if (instrumentationPoint->MinVersion != nullptr || instrumentationPoint->MaxVersion != nullptr) {
+                    if (assemblyVersion == nullptr) {
+                        assemblyVersion = GetAssemblyVersion(pUnk);
+                    }
+                    if (assemblyVersion != nullptr && !instrumentationPoint->IsInVersionRange(*assemblyVersion)) {
+                        LogDebug(instrumentationPoint->ToString(), " does not apply to version ", assemblyVersion->ToString());
+                        continue;
+                    }
+                }
+
                 mdTypeDef typeDef{};
-                HRESULT hr = pImport->FindTypeDefByName(instrumentationPoint->ClassName.c_str(), mdTypeDefNil, &typeDef);
+                HRESULT hr = FindTypeDefByNestedName(pImport, instrumentationPoint->ClassName, typeDef);
                 if (FAILED(hr)) {
                     LogInfo("Unable to find ", instrumentationPoint->ClassName, " for rejit. HR:", hr);
-                } else {
-                    HCORENUM enumerator = nullptr;
-                    OnDestruction Conan([&] {if (enumerator) pImport->CloseEnum(enumerator); });
-                    mdMethodDef methodIds[METHOD_ENUM_BATCH_SIZE];
-                    for (ULONG fetchSize = 0; SUCCEEDED(pImport->EnumMethodsWithName(&enumerator, typeDef, instrumentationPoint->MethodName.c_str(), methodIds, METHOD_ENUM_BATCH_SIZE, &fetchSize)) && fetchSize;) {
-                        LogDebug("Found ", fetchSize, " method(s) matching ", instrumentationPoint->MethodName);
-                        for (ULONG i = 0; i < fetchSize; i++) {
+                    continue;
+                }
+
+                HCORENUM enumerator = nullptr;
+                OnDestruction Conan([&] {if (enumerator) pImport->CloseEnum(enumerator); });
+                mdMethodDef methodIds[METHOD_ENUM_BATCH_SIZE];
+                for (ULONG fetchSize = 0; SUCCEEDED(pImport->EnumMethodsWithName(&enumerator, typeDef, instrumentationPoint->MethodName.c_str(), methodIds, METHOD_ENUM_BATCH_SIZE, &fetchSize)) && fetchSize;) {
+                    LogDebug("Found ", fetchSize, " method(s) matching ", instrumentationPoint->MethodName);
+                    for (ULONG i = 0; i < fetchSize; i++) {
+                        if (instrumentationPoint->Parameters == nullptr || MethodMatchesParameters(pImport, tokenResolver, methodIds[i], *instrumentationPoint)) {
                             methodDefs->emplace(methodIds[i]);
                         }
                     }
@@ -761,46 +1084,166 @@ namespace NewRelic { namespace Profiler {
             return methodDefs;
         }
 
-        void RejitModuleFunctions(ModuleID moduleId, std::shared_ptr<std::set<mdMethodDef>> methodsToRejit)
+        // Class names use '+' between a nested type and the type it's declared in, the same way Function builds them.
+        static HRESULT FindTypeDefByNestedName(IMetaDataImport2* pImport, const xstring_t& className, mdTypeDef& typeDef)
         {
-            auto rejit =
-                [&](ULONG numberMethods, ModuleID* moduleIds, mdMethodDef* methodIds) {
-                    HRESULT hr = _corProfilerInfo4->RequestReJIT(numberMethods, moduleIds, methodIds);
-                    LogDebug("ReJit ", (SUCCEEDED(hr) ? "success" : "failed"));
-                };
-            PerformOnMethods(moduleId, methodsToRejit, rejit);
+            mdTypeDef enclosingTypeDef = mdTypeDefNil;
+            for (size_t start = 0;;) {
+                auto end = className.find(_X('+'), start);
+                auto typeName = className.substr(start, end == xstring_t::npos ? xstring_t::npos : end - start);
+
+                HRESULT hr = pImport->FindTypeDefByName(typeName.c_str(), enclosingTypeDef, &typeDef);
+                if (FAILED(hr) || end == xstring_t::npos) {
+                    return hr;
+                }
+
+                enclosingTypeDef = typeDef;
+                start = end + 1;
+            }
         }
 
-        void RevertModuleFunctions(ModuleID moduleId, std::shared_ptr<std::set<mdMethodDef>> methodsToRevert)
+        static bool MethodMatchesParameters(IMetaDataImport2* pImport, SignatureParser::ITokenResolverPtr tokenResolver, mdMethodDef methodDef, const Configuration::InstrumentationPoint& instrumentationPoint)
         {
-            auto revert =
-                [&](ULONG numberMethods, ModuleID* moduleIds, mdMethodDef* methodIds) {
-                    HRESULT* success = nullptr;
-                    HRESULT hr = _corProfilerInfo4->RequestRevert(numberMethods, moduleIds, methodIds, success);
-                    LogDebug("Revert ", (SUCCEEDED(hr) ? "success" : "failed"));
-                };
-            PerformOnMethods(moduleId, methodsToRevert, revert);
+            PCCOR_SIGNATURE signature = nullptr;
+            ULONG signatureSize = 0;
+            if (FAILED(pImport->GetMethodProps(methodDef, nullptr, nullptr, 0, nullptr, nullptr, &signature, &signatureSize, nullptr, nullptr))) {
+                return true;
+            }
+
+            try {
+                ByteVector signatureBytes(signature, signature + signatureSize);
+                auto parsedSignature = SignatureParser::SignatureParser::ParseMethodSignature(signatureBytes.begin(), signatureBytes.end());
+                return instrumentationPoint.MatchesParameters(parsedSignature->ToString(tokenResolver));
+            } catch (...) {
+                // leave it to the rewriter to decide once the method is rejitted
+                return true;
+            }
+        }
+
+        static std::unique_ptr<AssemblyVersion> GetAssemblyVersion(IUnknown* pUnk)
+        {
+            CComPtr<IMetaDataAssemblyImport> pAssemblyImport = nullptr;
+            mdAssembly assembly = 0;
+            ASSEMBLYMETADATA assemblyMetaData = ASSEMBLYMETADATA();
+            if (FAILED(pUnk->QueryInterface(IID_IMetaDataAssemblyImport, (LPVOID*)&pAssemblyImport)) ||
+                FAILED(pAssemblyImport->GetAssemblyFromScope(&assembly)) ||
+                FAILED(pAssemblyImport->GetAssemblyProps(assembly, nullptr, nullptr, nullptr, nullptr, 0, nullptr, &assemblyMetaData, nullptr))) {
+                return nullptr;
+            }
+
+            return std::unique_ptr<AssemblyVersion>(new AssemblyVersion(assemblyMetaData));
         }
 
-        void PerformOnMethods(ModuleID moduleId, std::shared_ptr<std::set<mdMethodDef>> methodSet,
-            std::function<void(ULONG, ModuleID*, mdMethodDef*)> func)
+        // The methods in this module that JITCompilationStarted would instrument without an instrumentation point: the
+        // agent API and methods with a transaction or trace attribute.
+        std::shared_ptr<std::set<mdMethodDef>> GetMethodDefsInstrumentedWithoutPoints(ModuleID moduleId, const xstring_t& assemblyName)
         {
-            if (methodSet != nullptr && !methodSet->empty()) {
-                ULONG numberMethods = (ULONG)methodSet->size();
-                ModuleID* moduleIds = new ModuleID[numberMethods];
-                mdMethodDef* methodIds = new mdMethodDef[numberMethods];
+            CComPtr<IMetaDataImport> pImport = nullptr;
+            CComPtr<IUnknown> pUnk = nullptr;
+
+            if (FAILED(_corProfilerInfo4->GetModuleMetaData(moduleId, ofRead, IID_IMetaDataImport, &pUnk)) || FAILED(pUnk->QueryInterface(IID_IMetaDataImport, (LPVOID*)&pImport))) {
+                return nullptr;
+            }
+
+            if (assemblyName == _X("NewRelic.Api.Agent")) {
+                return GetAllMethodDefs(pImport, _X("NewRelic.Api.Agent.NewRelic"));
+            }
+
+            if (Function::ShouldSkipAssemblyAttributes(assemblyName)) {
+                return nullptr;
+            }
+
+            std::shared_ptr<std::set<mdMethodDef>> methodDefs = std::make_shared<std::set<mdMethodDef>>();
+            std::map<mdToken, bool> tracingAttributeConstructors;
+
+            HCORENUM enumerator = nullptr;
+            OnDestruction Conan([&] {if (enumerator) pImport->CloseEnum(enumerator); });
+            mdCustomAttribute attributes[ATTRIBUTE_ENUM_BATCH_SIZE];
+            for (ULONG fetchSize = 0; SUCCEEDED(pImport->EnumCustomAttributes(&enumerator, 0, 0, attributes, ATTRIBUTE_ENUM_BATCH_SIZE, &fetchSize)) && fetchSize;) {
+                for (ULONG i = 0; i < fetchSize; i++) {
+                    mdToken owner = mdTokenNil;
+                    mdToken constructor = mdTokenNil;
+                    if (FAILED(pImport->GetCustomAttributeProps(attributes[i], &owner, &constructor, nullptr, nullptr)) || TypeFromToken(owner) != mdtMethodDef) {
+                        continue;
+                    }
 
-                int i = 0;
-                for (auto methodDef : *methodSet) {
-                    moduleIds[i] = moduleId;
-                    methodIds[i] = methodDef;
-                    i++;
+                    auto known = tracingAttributeConstructors.find(constructor);
+                    if (known == tracingAttributeConstructors.end()) {
+                        known = tracingAttributeConstructors.emplace(constructor, IsTransactionOrTraceAttributeConstructor(pImport, constructor)).first;
+                    }
+                    if (known->second) {
+                        methodDefs->emplace(owner);
+                    }
                 }
+            }
 
-                func(numberMethods, moduleIds, methodIds);
+            if (!methodDefs->empty()) {
+                LogDebug("Found ", methodDefs->size(), " attribute instrumented method(s) in ", assemblyName);
+            }
+            return methodDefs;
+        }
 
-                delete[] moduleIds;
-                delete[] methodIds;
+        static bool IsTransactionOrTraceAttributeConstructor(CComPtr<IMetaDataImport> pImport, mdToken constructor)
+        {
+            // our attributes always live in NewRelic.Api.Agent, so their constructors are member refs on a type ref
+            mdToken attributeType = mdTokenNil;
+            if (TypeFromToken(constructor) != mdtMemberRef || FAILED(pImport->GetMemberRefProps(constructor, &attributeType, nullptr, 0, nullptr, nullptr, nullptr))) {
+                return false;
+            }
+            if (TypeFromToken(attributeType) != mdtTypeRef) {
+                return false;
+            }
+
+            ULONG typeNameLength = 0;
+            if (FAILED(pImport->GetTypeRefProps(attributeType, nullptr, nullptr, 0, &typeNameLength))) {
+                return false;
+            }
+            std::unique_ptr<WCHAR[]> typeName(new WCHAR[typeNameLength]);
+            if (FAILED(pImport->GetTypeRefProps(attributeType, nullptr, typeName.get(), typeNameLength, nullptr))) {
+                return false;
+            }
+
+            auto name = ToStdWString(typeName.get());
+            return name == _X("NewRelic.Api.Agent.TransactionAttribute") || name == _X("NewRelic.Api.Agent.TraceAttribute");
+        }
+
+        std::shared_ptr<std::set<mdMethodDef>> GetAllMethodDefs(CComPtr<IMetaDataImport> pImport, const xstring_t& className)
+        {
+            mdTypeDef typeDef{};
+            if (FAILED(pImport->FindTypeDefByName(className.c_str(), mdTypeDefNil, &typeDef))) {
+                LogInfo("Unable to find ", className, " for rejit.");
+                return nullptr;
+            }
+
+            std::shared_ptr<std::set<mdMethodDef>> methodDefs = std::make_shared<std::set<mdMethodDef>>();
+            HCORENUM enumerator = nullptr;
+            OnDestruction Conan([&] {if (enumerator) pImport->CloseEnum(enumerator); });
+            mdMethodDef methodIds[METHOD_ENUM_BATCH_SIZE];
+            for (ULONG fetchSize = 0; SUCCEEDED(pImport->EnumMethods(&enumerator, typeDef, methodIds, METHOD_ENUM_BATCH_SIZE, &fetchSize)) && fetchSize;) {
+                for (ULONG i = 0; i < fetchSize; i++) {
+                    methodDefs->emplace(methodIds[i]);
+                }
+            }
+            return methodDefs;
+        }
+
+        void RejitModuleFunctions(ModuleID moduleId, std::shared_ptr<std::set<mdMethodDef>> methodsToRejit)
+        {
+            if (methodsToRejit == nullptr)
+                return;
+
+            for (auto methodDef : *methodsToRejit) {
+                _rejitScheduler->ReJIT(moduleId, methodDef);
+            }
+        }
+
+        void RevertModuleFunctions(ModuleID moduleId, std::shared_ptr<std::set<mdMethodDef>> methodsToRevert)
+        {
+            if (methodsToRevert == nullptr)
+                return;
+
+            for (auto methodDef : *methodsToRevert) {
+                _rejitScheduler->Revert(moduleId, methodDef);
             }
         }
 
@@ -826,9 +1269,98 @@ namespace NewRelic { namespace Profiler {
 
         HRESULT RequestProfile(void** snapshot, int* length) noexcept
         {
+            auto result = EnableThreadProfilingEvents();
+            if (FAILED(result)) {
+                return result;
+            }
             return _threadProfiler.RequestProfile(snapshot, length);
         }
 
+        HRESULT RequestCompactProfile(int version, void** profile, int* length) noexcept
+        {
+            auto result = EnableThreadProfilingEvents();
+            if (FAILED(result)) {
+                return result;
+            }
+            return _threadProfiler.RequestCompactProfile(version, profile, length);
+        }
+
+        HRESULT StartContinuousProfiling(int samplesPerSecond) noexcept
+        {
+            auto result = EnableThreadProfilingEvents();
+            if (FAILED(result)) {
+                return result;
+            }
+            return _threadProfiler.StartContinuousProfiling(samplesPerSecond);
+        }
+
+        HRESULT StopContinuousProfiling() noexcept
+        {
+            return _threadProfiler.StopContinuousProfiling();
+        }
+
+        HRESULT SwapCallTree(void** nodes, int* length) noexcept
+        {
+            return _threadProfiler.SwapCallTree(nodes, length);
+        }
+
+        HRESULT GetProfileTimings(ThreadProfiler::ProfileTimings* timings) noexcept
+        {
+            return _threadProfiler.GetProfileTimings(timings);
+        }
+
+        HRESULT GetCallTreeTimings(ThreadProfiler::ProfileTimings* timings) noexcept
+        {
+            return _threadProfiler.GetCallTreeTimings(timings);
+        }
+
+        HRESULT SetCurrentThreadTag(uint64_t tag) noexcept
+        {
+            // a tag is only dropped by ThreadDestroyed, so the thread callbacks have to be on before the first one is set
+            if (!_threadProfilingEventsEnabled.load()) {
+                auto result = EnableThreadProfilingEvents();
+                if (FAILED(result)) {
+                    return result;
+                }
+            }
+            return _threadProfiler.SetCurrentThreadTag(tag);
+        }
+
+        void SetTaggedThreadsOnly(bool taggedThreadsOnly) noexcept
+        {
+            _threadProfiler.SetTaggedThreadsOnly(taggedThreadsOnly);
+        }
+
+        // Stack snapshot support makes the runtime keep extra bookkeeping and thread callbacks fire for every thread
+        // that starts or stops, so they are left off until the first thread profile is requested.
+        HRESULT EnableThreadProfilingEvents() noexcept
+        {
+            try {
+                std::lock_guard<std::mutex> lock(_eventMaskMutex);
+                if (_threadProfilingEventsEnabled) {
+                    return S_OK;
+                }
+
+                // SetEventMask keeps the high-order bits that SetEventMask2 set during initialization
+                DWORD eventMask = 0;
+                auto result = _corProfilerInfo4->GetEventMask(&eventMask);
+                if (SUCCEEDED(result)) {
+                    result = _corProfilerInfo4->SetEventMask(eventMask | THREAD_PROFILING_EVENTS);
+                }
+                if (FAILED(result)) {
+                    LogError(L"Unable to enable the events the thread profiler needs. HRESULT: ", result);
+                    return result;
+                }
+
+                LogInfo(L"Thread profiling events enabled");
+                _threadProfilingEventsEnabled = true;
+                return S_OK;
+            }
+            catch (...) {
+                return E_UNEXPECTED;
+            }
+        }
+
         // Fires up a new thread to fetch a number of functions.  This is called from a managed thread, and as a result direct calls to GetTokenAndMetaDataFromFunction
         // will result in a CORPROF_E_UNSUPPORTED_CALL_SEQUENCE.  Moving the work to another thread makes the profiler API happy.
         HRESULT RequestFunctionNames(const UINT_PTR* functionIds, int length, void** results) noexcept
@@ -868,12 +1400,25 @@ namespace NewRelic { namespace Profiler {
         ThreadProfiler::ThreadProfiler _threadProfiler;
         std::shared_ptr<SystemCalls> _systemCalls;
         std::shared_ptr<FunctionResolver> _functionResolver;
+        std::shared_ptr<ReJITScheduler> _rejitScheduler;
+        ModuleRegistry _modules;
         MethodRewriter::CustomInstrumentationBuilder _customInstrumentationBuilder;
         MethodRewriter::CustomInstrumentation _customInstrumentation;
-        std::mutex _instrumentationRefreshMutex;
+        std::shared_ptr<InstrumentationRefreshQueue> _instrumentationRefreshQueue;
+        MethodRewriter::RewrittenMethodCache _rewrittenMethods;
+        // the module each function belongs to, so the entries can be dropped when it unloads
+        StripedMap<FunctionID, ModuleID> _functionsHandledOnJit;
+        EpochReclaimer _moduleStateReclaimer;
+        bool _usePrecompiledCode = false;
+        bool _instrumentWithReJITOnly = false;
+        bool _attached = false;
+
+        std::mutex _eventMaskMutex;
+        // read without the mutex by SetCurrentThreadTag
+        std::atomic<bool> _threadProfilingEventsEnabled{ false };
 
         DWORD _eventMask = OverrideEventMask(
-            COR_PRF_MONITOR_JIT_COMPILATION | COR_PRF_MONITOR_MODULE_LOADS | COR_PRF_USE_PROFILE_IMAGES | COR_PRF_MONITOR_THREADS | COR_PRF_ENABLE_STACK_SNAPSHOT | COR_PRF_ENABLE_REJIT | (DWORD)COR_PRF_DISABLE_ALL_NGEN_IMAGES);
+            COR_PRF_MONITOR_JIT_COMPILATION | COR_PRF_MONITOR_MODULE_LOADS | COR_PRF_USE_PROFILE_IMAGES | COR_PRF_ENABLE_REJIT | (DWORD)COR_PRF_DISABLE_ALL_NGEN_IMAGES);
 
         xstring_t _productName = _X("");
         xstring_t _agentCoreDllPath = _X("");
@@ -1346,6 +1891,22 @@ namespace NewRelic { namespace Profiler {
         return profiler->ReloadConfiguration();
     }
 
+    // Called by managed code to find out whether the refreshes it asked for have been applied.  A refresh requested
+    // when requestedGeneration was N has finished once completedGeneration reaches N.  Returns the result of the
+    // most recently finished refresh.
+    extern "C" __declspec(dllexport) HRESULT __cdecl GetInstrumentationRefreshStatus(uint64_t* requestedGeneration, uint64_t* completedGeneration)
+    {
+        auto profiler = CorProfilerCallbackImpl::GetSingletonish();
+        if (profiler == nullptr) {
+            LogError("Unable to get the instrumentation refresh status because the profiler reference is invalid.");
+            return E_FAIL;
+        }
+        if (requestedGeneration == nullptr || completedGeneration == nullptr) {
+            return E_POINTER;
+        }
+        return profiler->GetInstrumentationRefreshStatus(*requestedGeneration, *completedGeneration);
+    }
+
     extern "C" __declspec(dllexport) HRESULT __cdecl AddCustomInstrumentation(const char* fileName, const char* xml)
     {
         LogTrace("Adding custom instrumentation");
@@ -1391,6 +1952,107 @@ namespace NewRelic { namespace Profiler {
         return profiler->RequestProfile(snapshots, length);
     }
 
+    // called by managed code to request a thread profile in one buffer, see ThreadProfiler/CompactProfile.h for its layout.  version is the
+    // layout the caller can read.  The buffer stays valid until ReleaseProfile is called.
+    extern "C" __declspec(dllexport) HRESULT __cdecl RequestCompactProfile(int version, void** profile, int* length) noexcept
+    {
+        auto profiler = CorProfilerCallbackImpl::GetSingletonish();
+        if (profiler == nullptr) {
+            LogError(L"RequestCompactProfile: entry point called before the profiler has been initialized");
+            return E_UNEXPECTED;
+        }
+        return profiler->RequestCompactProfile(version, profile, length);
+    }
+
+    // called by managed code to start sampling every managed thread samplesPerSecond times a second, or change the rate if it already is
+    extern "C" __declspec(dllexport) HRESULT __cdecl StartContinuousProfiling(int samplesPerSecond) noexcept
+    {
+        auto profiler = CorProfilerCallbackImpl::GetSingletonish();
+        if (profiler == nullptr) {
+            LogError(L"StartContinuousProfiling: entry point called before the profiler has been initialized");
+            return E_UNEXPECTED;
+        }
+        return profiler->StartContinuousProfiling(samplesPerSecond);
+    }
+
+    extern "C" __declspec(dllexport) HRESULT __cdecl StopContinuousProfiling() noexcept
+    {
+        auto profiler = CorProfilerCallbackImpl::GetSingletonish();
+        if (profiler == nullptr) {
+            LogError(L"StopContinuousProfiling: entry point called before the profiler has been initialized");
+            return E_UNEXPECTED;
+        }
+        return profiler->StopContinuousProfiling();
+    }
+
+    // called by managed code to take the call tree sampled since the last call.  The nodes stay valid until the next call.
+    extern "C" __declspec(dllexport) HRESULT __cdecl SwapCallTree(void** nodes, int* length) noexcept
+    {
+        auto profiler = CorProfilerCallbackImpl::GetSingletonish();
+        if (profiler == nullptr) {
+            LogError(L"SwapCallTree: entry point called before the profiler has been initialized");
+            return E_UNEXPECTED;
+        }
+        return profiler->SwapCallTree(nodes, length);
+    }
+
+    // called by managed code after RequestProfile or RequestCompactProfile to get how long the last profile kept the runtime suspended and
+    // spent resolving names.  See ProfileTimings in ThreadProfiler/ThreadProfiler.h for the layout.
+    extern "C" __declspec(dllexport) HRESULT __cdecl GetProfileTimings(void* timings) noexcept
+    {
+        auto profiler = CorProfilerCallbackImpl::GetSingletonish();
+        if (profiler == nullptr) {
+            LogError(L"GetProfileTimings: entry point called before the profiler has been initialized");
+            return E_UNEXPECTED;
+        }
+        return profiler->GetProfileTimings(static_cast<ThreadProfiler::ProfileTimings*>(timings));
+    }
+
+    // called by managed code after SwapCallTree to get the timings summed over the samples in the call tree it returned
+    extern "C" __declspec(dllexport) HRESULT __cdecl GetCallTreeTimings(void* timings) noexcept
+    {
+        auto profiler = CorProfilerCallbackImpl::GetSingletonish();
+        if (profiler == nullptr) {
+            LogError(L"GetCallTreeTimings: entry point called before the profiler has been initialized");
+            return E_UNEXPECTED;
+        }
+        return profiler->GetCallTreeTimings(static_cast<ThreadProfiler::ProfileTimings*>(timings));
+    }
+
+    // called by managed code to tag the current thread, with the id of the transaction it's working on for example.  Doesn't allocate
+    // once the thread profiling events are on, and only locks the first time a thread is tagged.
+    extern "C" __declspec(dllexport) HRESULT __cdecl SetCurrentThreadTag(uint64_t tag) noexcept
+    {
+        auto profiler = CorProfilerCallbackImpl::GetSingletonish();
+        if (profiler == nullptr) {
+            LogError(L"SetCurrentThreadTag: entry point called before the profiler has been initialized");
+            return E_UNEXPECTED;
+        }
+        return profiler->SetCurrentThreadTag(tag);
+    }
+
+    // called by managed code when the current thread is done with the work it was tagged for
+    extern "C" __declspec(dllexport) HRESULT __cdecl ClearCurrentThreadTag() noexcept
+    {
+        auto profiler = CorProfilerCallbackImpl::GetSingletonish();
+        if (profiler == nullptr) {
+            LogError(L"ClearCurrentThreadTag: entry point called before the profiler has been initialized");
+            return E_UNEXPECTED;
+        }
+        return profiler->SetCurrentThreadTag(0);
+    }
+
+    // called by managed code to profile and sample only tagged threads, or every thread again
+    extern "C" __declspec(dllexport) void __cdecl SetTaggedThreadsOnly(bool taggedThreadsOnly) noexcept
+    {
+        auto profiler = CorProfilerCallbackImpl::GetSingletonish();
+        if (profiler == nullptr) {
+            LogError(L"SetTaggedThreadsOnly: entry point called before the profiler has been initialized");
+            return;
+        }
+        profiler->SetTaggedThreadsOnly(taggedThreadsOnly);
+    }
+
     // called by managed code to get function information from function IDs
     extern "C" __declspec(dllexport) HRESULT __cdecl RequestFunctionNames(UINT_PTR* functionIds, int length, void** results) noexcept
     {
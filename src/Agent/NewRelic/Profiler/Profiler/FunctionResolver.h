@@ -3,9 +3,11 @@
 
 #pragma once
 
-#include <map>
+#include <stdint.h>
+#include "../Common/StripedMap.h"
 #include "../Logging/Logger.h"
 #include "Function.h"
+#include "ReJITScheduler.h"
 #include <cor.h>
 #include <corprof.h>
 
@@ -29,7 +31,21 @@ namespace NewRelic { namespace Profiler
 
         bool operator<(const ModuleAndMethodID& other) const
         {
-            return moduleID < other.moduleID || methodID < other.methodID;
+            return moduleID < other.moduleID || (moduleID == other.moduleID && methodID < other.methodID);
+        }
+    };
+
+    struct ModuleAndMethodIDHash
+    {
+        size_t operator()(const ModuleAndMethodID& id) const
+        {
+            // module ids are aligned pointers and method tokens only differ in their low bits, so mix
+            // both fully before the result is used to pick a stripe and a bucket
+            uint64_t hash = (uint64_t(id.moduleID) * 0x9E3779B97F4A7C15ull) ^ uint64_t(id.methodID);
+            hash ^= hash >> 31;
+            hash *= 0xBF58476D1CE4E5B9ull;
+            hash ^= hash >> 29;
+            return size_t(hash);
         }
     };
 
@@ -54,75 +70,37 @@ namespace NewRelic { namespace Profiler
     // for a function id we use the apis that don't return the type specifics of the generic method.  That means that while 
     // multiple function ids may map to a single generic method, the AgentShim will see invocations for all of those function ids 
     // use a single function id.  For our purposes, at least for the current agent functionality we support, this is fine.
+    //
+    // Both collections are striped by module/method id because they are hit from the reJIT callbacks on every JIT
+    // worker thread at once.
     class FunctionResolver
     {
     private:
         // We fall back on this map for generic methods when our calls to GetFunctionFromToken fail.
-        std::map<ModuleAndMethodID, FunctionID> _functionToMethod;
-        std::set<ModuleAndMethodID> _methodsToReJIT;
+        StripedMap<ModuleAndMethodID, FunctionID, ModuleAndMethodIDHash> _functionToMethod;
+        StripedSet<ModuleAndMethodID, ModuleAndMethodIDHash> _methodsToReJIT;
 
-        std::mutex _functionToMethodMutex;
-        std::mutex _methodsToReJITMutex;
         CComPtr<ICorProfilerInfo4> _corProfilerInfo;
+        std::shared_ptr<ReJITScheduler> _rejitScheduler;
 
         bool ShouldReJIT(FunctionID functionId, ModuleID moduleId, mdMethodDef methodId)
         {
             ModuleAndMethodID moduleAndMethodID(moduleId, methodId);
 
-            auto rejit = ShouldReJIT(moduleAndMethodID);
+            auto rejit = _methodsToReJIT.Erase(moduleAndMethodID);
             if (rejit)
             {
-                AddUnderLock(functionId, moduleAndMethodID);
+                _functionToMethod.Set(moduleAndMethodID, functionId);
             }
             
             return rejit;
         }
 
-        bool ShouldReJIT(ModuleAndMethodID moduleAndMethodID)
-        {
-            std::lock_guard<std::mutex> rejitMethodsLock(_methodsToReJITMutex);
-            auto it = _methodsToReJIT.find(moduleAndMethodID);
-            if (it == _methodsToReJIT.end())
-            {
-                return false;
-            }
-
-            _methodsToReJIT.erase(it);
-            return true;
-        }
-
-        void AddUnderLock(FunctionID functionId, ModuleAndMethodID moduleAndMethodID)
-        {
-            std::lock_guard<std::mutex> lock(_functionToMethodMutex);
-            _functionToMethod[moduleAndMethodID] = functionId;
-        }
-
-        FunctionID GetGenericFunctionIdUnderLock(ModuleAndMethodID moduleAndMethodID)
-        {
-            std::lock_guard<std::mutex> lock(_functionToMethodMutex);
-
-            auto it = _functionToMethod.find(moduleAndMethodID);
-            if (it != _functionToMethod.end())
-            {
-                auto id = it->second;
-
-                // cool.  we found the id, now remove it from our map.
-                _functionToMethod.erase(it);
-                return id;
-            }
-            return INVALID_FUNCTION_ID;
-        }
-
-        void AddToReJITSetUnderLock(ModuleAndMethodID moduleAndMethodID)
-        {
-            std::lock_guard<std::mutex> rejitMethodsLock(_methodsToReJITMutex);
-            _methodsToReJIT.emplace(moduleAndMethodID);
-        }
-
     public:
-        FunctionResolver(CComPtr<ICorProfilerInfo4> corProfilerInfo)
+        FunctionResolver(CComPtr<ICorProfilerInfo4> corProfilerInfo, std::shared_ptr<ReJITScheduler> rejitScheduler)
         {
             _corProfilerInfo = corProfilerInfo;
+            _rejitScheduler = rejitScheduler;
         }
 
         // This adds the functionId->moduleId/methodId to a map if a call to GetFunctionFromToken fails.
@@ -133,7 +111,7 @@ namespace NewRelic { namespace Profiler
             {
                 ModuleAndMethodID moduleAndMethodID(function.GetModuleID(), function.GetMethodToken());
 
-                AddUnderLock(function.GetFunctionId(), moduleAndMethodID);
+                _functionToMethod.Set(moduleAndMethodID, function.GetFunctionId());
             }
         }
 
@@ -178,19 +156,27 @@ namespace NewRelic { namespace Profiler
             if (ShouldReJIT(functionId, moduleId, methodId))
             {
                 LogDebug(L"Requesting a reJIT of a generic function");
-                _corProfilerInfo->RequestReJIT(1, &moduleId, &methodId);
+                _rejitScheduler->ReJIT(moduleId, methodId);
             }
         }
 
+        // module ids can be handed out again once a module has unloaded
+        void ForgetModule(ModuleID moduleId)
+        {
+            _functionToMethod.EraseIf([moduleId](const ModuleAndMethodID& key, FunctionID) { return key.moduleID == moduleId; });
+            _methodsToReJIT.EraseIf([moduleId](const ModuleAndMethodID& key) { return key.moduleID == moduleId; });
+        }
+
         FunctionID GetGenericFunctionId(ModuleID moduleId, mdMethodDef methodId)
         {
             ModuleAndMethodID moduleAndMethodID(moduleId, methodId);
 
-            auto id = GetGenericFunctionIdUnderLock(moduleAndMethodID);
-            if (!IsValid(id))
+            // cool.  if we find the id, it comes out of the map with it.
+            FunctionID id = INVALID_FUNCTION_ID;
+            if (!_functionToMethod.TryTake(moduleAndMethodID, id))
             {
                 LogTrace(L"Generic function lookup failed, queued a reJIT");
-                AddToReJITSetUnderLock(moduleAndMethodID);
+                _methodsToReJIT.Insert(moduleAndMethodID);
             }
 
             return id;
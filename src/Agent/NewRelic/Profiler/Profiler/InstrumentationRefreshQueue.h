@@ -0,0 +1,123 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "../Configuration/IgnoreInstrumentation.h"
+#include "../Logging/Logger.h"
+#include <cor.h>
+
+namespace NewRelic { namespace Profiler
+{
+    // Runs instrumentation refreshes on one long-lived thread.  Callers only record that a refresh is wanted and
+    // return straight away; every request made while a refresh is waiting or running is merged into the next one,
+    // so a burst of configuration changes costs a single rejit pass.
+    //
+    // Requests are numbered.  Once the completed generation reaches the number a request was given, a refresh
+    // that started after that request has finished.
+    class InstrumentationRefreshQueue
+    {
+    public:
+        typedef std::function<HRESULT(Configuration::IgnoreInstrumentationListPtr)> RefreshFunction;
+
+        InstrumentationRefreshQueue(RefreshFunction refresh) :
+            _refresh(refresh),
+            _requestedGeneration(0),
+            _completedGeneration(0),
+            _lastResult(S_OK),
+            _stopping(false)
+        {
+            _worker = std::thread(&InstrumentationRefreshQueue::Run, this);
+        }
+
+        ~InstrumentationRefreshQueue()
+        {
+            Shutdown();
+        }
+
+        // a null ignore list means it hasn't changed, so it doesn't replace one an earlier pending request supplied
+        uint64_t Request(Configuration::IgnoreInstrumentationListPtr ignoreList)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (ignoreList != nullptr)
+                _pendingIgnoreList = ignoreList;
+
+            auto generation = ++_requestedGeneration;
+            _wakeUp.notify_one();
+            return generation;
+        }
+
+        // returns the result of the most recently completed refresh
+        HRESULT GetStatus(uint64_t& requestedGeneration, uint64_t& completedGeneration)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            requestedGeneration = _requestedGeneration;
+            completedGeneration = _completedGeneration;
+            return _lastResult;
+        }
+
+        // a refresh that is already running is allowed to finish, pending ones are dropped
+        void Shutdown()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_stopping)
+                    return;
+                _stopping = true;
+            }
+
+            _wakeUp.notify_one();
+            if (_worker.joinable())
+                _worker.join();
+        }
+
+    private:
+        void Run()
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (true)
+            {
+                _wakeUp.wait(lock, [&] { return _stopping || _requestedGeneration > _completedGeneration; });
+                if (_stopping)
+                    return;
+
+                auto generation = _requestedGeneration;
+                auto ignoreList = _pendingIgnoreList;
+                _pendingIgnoreList = nullptr;
+                lock.unlock();
+
+                LogTrace("Running instrumentation refresh ", generation);
+                HRESULT result = E_FAIL;
+                try
+                {
+                    result = _refresh(ignoreList);
+                }
+                catch (...)
+                {
+                    LogError(L"An exception was thrown while refreshing instrumentation.");
+                }
+
+                lock.lock();
+                _completedGeneration = generation;
+                _lastResult = result;
+            }
+        }
+
+        RefreshFunction _refresh;
+
+        std::mutex _mutex;
+        std::condition_variable _wakeUp;
+        Configuration::IgnoreInstrumentationListPtr _pendingIgnoreList;
+        uint64_t _requestedGeneration;
+        uint64_t _completedGeneration;
+        HRESULT _lastResult;
+        bool _stopping;
+
+        std::thread _worker;
+    };
+}}
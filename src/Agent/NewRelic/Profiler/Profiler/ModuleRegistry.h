@@ -0,0 +1,92 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../Common/Strings.h"
+#include "../Common/xplat.h"
+#include <cor.h>
+#include <corprof.h>
+
+namespace NewRelic { namespace Profiler
+{
+    // The modules that are currently loaded, grouped by assembly name.  Kept up to date from the module load
+    // and unload callbacks so an instrumentation refresh can go straight to the modules of the assemblies
+    // whose instrumentation changed instead of asking the runtime about every module in the process.
+    class ModuleRegistry
+    {
+    public:
+        typedef std::vector<std::pair<ModuleID, xstring_t>> ModuleList;
+
+        void Add(ModuleID moduleId, const xstring_t& assemblyName)
+        {
+            auto upperCaseName = Strings::ToUpper(assemblyName);
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            RemoveModule(moduleId);
+            _assemblyNameByModule[moduleId] = assemblyName;
+            _modulesByAssembly[upperCaseName].insert(moduleId);
+        }
+
+        void Remove(ModuleID moduleId)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            RemoveModule(moduleId);
+        }
+
+        // returns each module of the given assemblies along with the assembly name as the runtime reported it,
+        // assembly names are compared case-insensitively
+        ModuleList GetModules(const std::set<xstring_t>& assemblyNames)
+        {
+            std::set<xstring_t> upperCaseNames;
+            for (auto& assemblyName : assemblyNames)
+                upperCaseNames.insert(Strings::ToUpper(assemblyName));
+
+            ModuleList modules;
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (auto& upperCaseName : upperCaseNames)
+            {
+                auto assembly = _modulesByAssembly.find(upperCaseName);
+                if (assembly == _modulesByAssembly.end())
+                    continue;
+
+                for (auto moduleId : assembly->second)
+                    modules.emplace_back(moduleId, _assemblyNameByModule[moduleId]);
+            }
+            return modules;
+        }
+
+        size_t GetSize()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _assemblyNameByModule.size();
+        }
+
+    private:
+        void RemoveModule(ModuleID moduleId)
+        {
+            auto module = _assemblyNameByModule.find(moduleId);
+            if (module == _assemblyNameByModule.end())
+                return;
+
+            auto assembly = _modulesByAssembly.find(Strings::ToUpper(module->second));
+            if (assembly != _modulesByAssembly.end())
+            {
+                assembly->second.erase(moduleId);
+                if (assembly->second.empty())
+                    _modulesByAssembly.erase(assembly);
+            }
+            _assemblyNameByModule.erase(module);
+        }
+
+        std::mutex _mutex;
+        std::unordered_map<ModuleID, xstring_t> _assemblyNameByModule;
+        std::map<xstring_t, std::set<ModuleID>> _modulesByAssembly;
+    };
+}}
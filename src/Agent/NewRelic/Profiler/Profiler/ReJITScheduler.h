@@ -0,0 +1,294 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../Logging/Logger.h"
+#include <cor.h>
+#include <corprof.h>
+
+namespace NewRelic { namespace Profiler
+{
+    // Every RequestReJIT and RequestRevert call suspends the runtime, so asking for methods one at a time
+    // as they are found means thousands of suspensions during startup.  This class collects requests from
+    // any thread and hands them to the runtime from its own thread in as few calls as possible.
+    //
+    // Callers push onto a lock-free stack.  The worker wakes up when the first request arrives, waits for
+    // the coalescing window so that more can pile up, then drains the stack, keeps only the last request
+    // for each method and sends the rest in batches of at most maxBatchSize methods.
+    //
+    // Requests for a module that has started unloading are dropped, including ones pushed after it started by
+    // callbacks that were still running, until the module is released.  Each request is numbered as it is pushed,
+    // so a module that loads after the release and is given the same id doesn't lose the requests made for it.
+    class ReJITScheduler
+    {
+    public:
+        typedef std::function<HRESULT(ULONG, ModuleID*, mdMethodDef*)> RequestFunction;
+
+        static const uint32_t DefaultCoalescingWindowInMilliseconds = 100;
+        static const uint32_t DefaultMaxBatchSize = 4096;
+
+        ReJITScheduler(RequestFunction requestReJIT, RequestFunction requestRevert,
+            uint32_t coalescingWindowInMilliseconds = DefaultCoalescingWindowInMilliseconds,
+            uint32_t maxBatchSize = DefaultMaxBatchSize) :
+            _requestReJIT(requestReJIT),
+            _requestRevert(requestRevert),
+            _coalescingWindow(coalescingWindowInMilliseconds),
+            _maxBatchSize(maxBatchSize == 0 ? 1 : maxBatchSize),
+            _head(nullptr),
+            _nextSequence(0),
+            _pushed(0),
+            _issued(0),
+            _flushTarget(0),
+            _stopping(false)
+        {
+            _worker = std::thread(&ReJITScheduler::Run, this);
+        }
+
+        ~ReJITScheduler()
+        {
+            Shutdown();
+            DeleteRequests(_head.exchange(nullptr));
+        }
+
+        void ReJIT(ModuleID moduleId, mdMethodDef methodId)
+        {
+            Push(moduleId, methodId, false);
+        }
+
+        void Revert(ModuleID moduleId, mdMethodDef methodId)
+        {
+            Push(moduleId, methodId, true);
+        }
+
+        // blocks until every request pushed before the call has been handed to the runtime
+        void Flush()
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            auto target = _pushed.load();
+            if (target > _flushTarget)
+                _flushTarget = target;
+
+            _wakeUp.notify_one();
+            _issuedChanged.wait(lock, [&] { return _stopping || _issued >= target; });
+        }
+
+        // drops every request for the module, those pushed so far and those pushed until it is released
+        void DropModule(ModuleID moduleId)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _droppedModules[moduleId] = DroppedModule{ NotReleased };
+        }
+
+        // call once nothing can still be pushing a request for the module that was dropped, requests pushed from
+        // now on are for a module that reuses its id.  the entry goes away after the next drain
+        void ReleaseDroppedModule(ModuleID moduleId)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto dropped = _droppedModules.find(moduleId);
+            if (dropped != _droppedModules.end())
+                dropped->second._sequence = _nextSequence.load();
+        }
+
+        size_t GetDroppedModuleCount()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _droppedModules.size();
+        }
+
+        // requests that haven't been sent yet are dropped, the runtime no longer accepts them
+        void Shutdown()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_stopping)
+                    return;
+                _stopping = true;
+            }
+
+            _wakeUp.notify_one();
+            _issuedChanged.notify_all();
+            if (_worker.joinable())
+                _worker.join();
+        }
+
+    private:
+        struct Request
+        {
+            ModuleID _moduleId;
+            mdMethodDef _methodId;
+            bool _revert;
+            uint64_t _sequence;
+            Request* _next;
+        };
+
+        static const uint64_t NotReleased = UINT64_MAX;
+
+        struct DroppedModule
+        {
+            // requests numbered below this were pushed before the module was released, NotReleased until then
+            uint64_t _sequence;
+        };
+
+        typedef std::unordered_map<ModuleID, DroppedModule> DroppedModules;
+
+        typedef std::pair<ModuleID, mdMethodDef> MethodKey;
+
+        void Push(ModuleID moduleId, mdMethodDef methodId, bool revert)
+        {
+            // once the request is on the stack the worker may already have drained and deleted it, so whether it
+            // went onto an empty stack is worked out from a copy
+            auto next = _head.load(std::memory_order_relaxed);
+            auto request = new Request{ moduleId, methodId, revert, _nextSequence++, next };
+            while (!_head.compare_exchange_weak(next, request, std::memory_order_release, std::memory_order_relaxed))
+                request->_next = next;
+
+            auto pushed = ++_pushed;
+
+            // the worker only needs waking for the first request of a batch, or to cut the window
+            // short once a full batch is waiting.  taking the lock here means it can't miss the wakeup
+            // between checking the stack and going to sleep.
+            if (next == nullptr || pushed % _maxBatchSize == 0)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                }
+                _wakeUp.notify_one();
+            }
+        }
+
+        void Run()
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (!_stopping)
+            {
+                _wakeUp.wait(lock, [&] { return _stopping || _head.load() != nullptr; });
+                if (_stopping)
+                    break;
+
+                _wakeUp.wait_for(lock, _coalescingWindow, [&] {
+                    // a request can be drained before its push is counted, so _issued may briefly lead
+                    auto pushed = _pushed.load();
+                    return _stopping || _flushTarget > _issued || (pushed > _issued && pushed - _issued >= _maxBatchSize);
+                });
+                if (_stopping)
+                    break;
+
+                // released modules can't gain any more stale requests, so once this drain has filtered
+                // them out they no longer need to be remembered
+                auto dropped = _droppedModules;
+                auto head = _head.exchange(nullptr, std::memory_order_acquire);
+                lock.unlock();
+                auto drained = Issue(head, dropped);
+                lock.lock();
+
+                for (auto& module : dropped)
+                {
+                    auto current = _droppedModules.find(module.first);
+                    if (module.second._sequence != NotReleased && current != _droppedModules.end() && current->second._sequence == module.second._sequence)
+                        _droppedModules.erase(current);
+                }
+
+                _issued += drained;
+                _issuedChanged.notify_all();
+            }
+        }
+
+        // returns the number of requests that were taken off the stack
+        uint64_t Issue(Request* head, const DroppedModules& droppedModules)
+        {
+            // the stack hands requests back newest first, walking it and only keeping the first request
+            // seen for each method leaves the most recent one
+            std::map<MethodKey, bool> latest;
+            uint64_t drained = 0;
+            for (auto request = head; request != nullptr; request = request->_next)
+            {
+                ++drained;
+
+                auto dropped = droppedModules.find(request->_moduleId);
+                if (dropped != droppedModules.end() && request->_sequence < dropped->second._sequence)
+                    continue;
+
+                latest.emplace(MethodKey(request->_moduleId, request->_methodId), request->_revert);
+            }
+            DeleteRequests(head);
+
+            std::vector<ModuleID> moduleIds;
+            std::vector<mdMethodDef> methodIds;
+            for (auto revert : { true, false })
+            {
+                moduleIds.clear();
+                methodIds.clear();
+                for (auto& method : latest)
+                {
+                    if (method.second != revert)
+                        continue;
+
+                    moduleIds.push_back(method.first.first);
+                    methodIds.push_back(method.first.second);
+                }
+                Send(revert, moduleIds, methodIds);
+            }
+
+            return drained;
+        }
+
+        void Send(bool revert, std::vector<ModuleID>& moduleIds, std::vector<mdMethodDef>& methodIds)
+        {
+            for (size_t start = 0; start < moduleIds.size(); start += _maxBatchSize)
+            {
+                auto count = ULONG(std::min<size_t>(_maxBatchSize, moduleIds.size() - start));
+                auto hr = revert
+                    ? _requestRevert(count, moduleIds.data() + start, methodIds.data() + start)
+                    : _requestReJIT(count, moduleIds.data() + start, methodIds.data() + start);
+
+                if (FAILED(hr))
+                    LogError(revert ? L"Revert" : L"ReJIT", L" of ", count, L" methods failed. HRESULT: ", hr);
+                else
+                    LogDebug(revert ? L"Revert" : L"ReJIT", L" of ", count, L" methods requested");
+            }
+        }
+
+        static void DeleteRequests(Request* head)
+        {
+            while (head != nullptr)
+            {
+                auto next = head->_next;
+                delete head;
+                head = next;
+            }
+        }
+
+        RequestFunction _requestReJIT;
+        RequestFunction _requestRevert;
+        std::chrono::milliseconds _coalescingWindow;
+        uint64_t _maxBatchSize;
+
+        std::atomic<Request*> _head;
+        std::atomic<uint64_t> _nextSequence;
+        std::atomic<uint64_t> _pushed;
+
+        // guarded by _mutex
+        std::mutex _mutex;
+        std::condition_variable _wakeUp;
+        std::condition_variable _issuedChanged;
+        uint64_t _issued;
+        uint64_t _flushTarget;
+        DroppedModules _droppedModules;
+        bool _stopping;
+
+        std::thread _worker;
+    };
+}}
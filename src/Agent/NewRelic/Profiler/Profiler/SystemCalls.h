@@ -28,6 +28,9 @@ namespace NewRelic { namespace Profiler
 
         virtual std::unique_ptr<xstring_t> TryGetEnvironmentVariable(const xstring_t& variableName) override
         {
+            auto overrideValue = TryGetEnvironmentOverride(variableName);
+            if (overrideValue != nullptr) return overrideValue;
+
             // get the size of the buffer required to hold the result
             auto size = GetEnvironmentVariable(variableName.c_str(), nullptr, 0);
             if (size == 0) return nullptr;
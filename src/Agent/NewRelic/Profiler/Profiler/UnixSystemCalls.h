@@ -45,6 +45,9 @@ namespace NewRelic { namespace Profiler
 
         virtual std::unique_ptr<xstring_t> TryGetEnvironmentVariable(const xstring_t& variableName) override
         {
+            auto overrideValue = TryGetEnvironmentOverride(variableName);
+            if (overrideValue != nullptr) return overrideValue;
+
             auto envVal = std::getenv(ToCharString(variableName).c_str());
 
             if (envVal == nullptr)
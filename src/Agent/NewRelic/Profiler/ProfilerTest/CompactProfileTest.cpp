@@ -0,0 +1,212 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stdafx.h"
+#include <cstring>
+#include <vector>
+#include "CppUnitTest.h"
+#include "../ThreadProfiler/CompactProfile.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace NewRelic { namespace Profiler { namespace Test
+{
+    using namespace ThreadProfiler;
+
+    // reads a compact profile back the way the managed reader does, checking the layout as it goes
+    struct DecodedThread
+    {
+        uint64_t threadId;
+        int32_t hresult;
+        int32_t stackIndex;
+        std::vector<uintptr_t> frames;
+    };
+
+    struct DecodedProfile
+    {
+        CompactProfileHeader header;
+        std::vector<DecodedThread> threads;
+    };
+
+    template <typename T>
+    static T Read(const std::vector<uint8_t>& buffer, size_t offset)
+    {
+        Assert::IsTrue(offset + sizeof(T) <= buffer.size());
+        T value;
+        std::memcpy(&value, buffer.data() + offset, sizeof(T));
+        return value;
+    }
+
+    static std::vector<uintptr_t> DecodeFrames(const std::vector<uint8_t>& buffer, size_t offset, size_t end, uint32_t frameCount)
+    {
+        std::vector<uintptr_t> frames;
+        uint64_t previous = 0;
+        while (frames.size() != frameCount)
+        {
+            uint64_t zigzag = 0;
+            for (int shift = 0;; shift += 7)
+            {
+                Assert::IsTrue(offset < end);
+                const auto byte = buffer[offset++];
+                zigzag |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                    break;
+            }
+            const auto delta = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+            previous += static_cast<uint64_t>(delta);
+            frames.push_back(static_cast<uintptr_t>(previous));
+        }
+        Assert::IsTrue(offset == end);
+        return frames;
+    }
+
+    static DecodedProfile Decode(const std::vector<uint8_t>& buffer)
+    {
+        DecodedProfile profile;
+        profile.header = Read<CompactProfileHeader>(buffer, 0);
+        const auto& header = profile.header;
+        Assert::AreEqual(CompactProfileMagic, header.magic);
+        Assert::AreEqual(CompactProfileVersion, header.version);
+        Assert::AreEqual(uint16_t(sizeof(CompactProfileHeader)), header.headerSize);
+        Assert::AreEqual(uint32_t(header.headerSize), header.threadTableOffset);
+        Assert::AreEqual(header.threadTableOffset + header.threadCount * uint32_t(sizeof(CompactProfileThread)), header.stackTableOffset);
+        Assert::AreEqual(header.stackTableOffset + header.stackCount * uint32_t(sizeof(CompactProfileStack)), header.frameDataOffset);
+        Assert::AreEqual(size_t(header.frameDataOffset) + header.frameDataSize, buffer.size());
+
+        std::vector<CompactProfileStack> stacks;
+        for (uint32_t index = 0; index != header.stackCount; ++index)
+            stacks.push_back(Read<CompactProfileStack>(buffer, header.stackTableOffset + index * sizeof(CompactProfileStack)));
+
+        for (uint32_t index = 0; index != header.threadCount; ++index)
+        {
+            const auto thread = Read<CompactProfileThread>(buffer, header.threadTableOffset + index * sizeof(CompactProfileThread));
+            DecodedThread decoded{ thread.threadId, thread.hresult, thread.stackIndex, {} };
+            if (thread.stackIndex != -1)
+            {
+                Assert::IsTrue(thread.stackIndex >= 0 && uint32_t(thread.stackIndex) < header.stackCount);
+                const auto& stack = stacks[thread.stackIndex];
+                // a stack's frames run to where the next stack's start
+                const auto end = uint32_t(thread.stackIndex) + 1 < header.stackCount ? stacks[thread.stackIndex + 1].frameOffset : header.frameDataSize;
+                decoded.frames = DecodeFrames(buffer, header.frameDataOffset + stack.frameOffset, header.frameDataOffset + end, stack.frameCount);
+            }
+            profile.threads.push_back(decoded);
+        }
+        return profile;
+    }
+
+    TEST_CLASS(CompactProfileTest)
+    {
+    public:
+        TEST_METHOD(an_empty_profile_is_just_the_header)
+        {
+            CompactProfileWriter writer;
+            std::vector<uint8_t> buffer;
+            writer.write(buffer);
+
+            Assert::AreEqual(sizeof(CompactProfileHeader), buffer.size());
+            auto profile = Decode(buffer);
+            Assert::AreEqual(0u, profile.header.threadCount);
+            Assert::AreEqual(0u, profile.header.stackCount);
+            Assert::AreEqual(0u, profile.header.frameDataSize);
+        }
+
+        TEST_METHOD(threads_and_their_stacks_round_trip)
+        {
+            // ids that go up and down, and far apart, so deltas of both signs and many bytes are written
+            const std::vector<uintptr_t> first{ 0x7FF812340000, 0x7FF812340010, 0x7FF800000008, 0x10, static_cast<uintptr_t>(-1) };
+            const std::vector<uintptr_t> second{ 0x1000, 0x1000, 0x0FFF };
+            const std::vector<uintptr_t> empty;
+
+            CompactProfileWriter writer;
+            writer.add_thread(0x100, S_OK, first.begin(), first.end());
+            writer.add_thread(0x200, S_FALSE, second.begin(), second.end());
+            writer.add_thread(0x300, S_OK, empty.begin(), empty.end());
+            std::vector<uint8_t> buffer;
+            writer.write(buffer);
+
+            auto profile = Decode(buffer);
+            Assert::AreEqual(size_t(3), profile.threads.size());
+            Assert::AreEqual(3u, profile.header.stackCount);
+
+            Assert::IsTrue(profile.threads[0].threadId == 0x100);
+            Assert::AreEqual(S_OK, profile.threads[0].hresult);
+            Assert::IsTrue(profile.threads[0].frames == first);
+
+            Assert::IsTrue(profile.threads[1].threadId == 0x200);
+            Assert::AreEqual(S_FALSE, profile.threads[1].hresult);
+            Assert::IsTrue(profile.threads[1].frames == second);
+
+            Assert::IsTrue(profile.threads[2].frames.empty());
+            Assert::AreNotEqual(-1, profile.threads[2].stackIndex);
+        }
+
+        TEST_METHOD(repeated_stacks_are_written_once)
+        {
+            const std::vector<uintptr_t> waiting{ 0x10, 0x20, 0x30 };
+            const std::vector<uintptr_t> working{ 0x10, 0x20, 0x40 };
+
+            CompactProfileWriter writer;
+            for (ThreadID threadId = 1; threadId <= 10; ++threadId)
+            {
+                if (threadId % 5 == 0)
+                    writer.add_thread(threadId, S_OK, working.begin(), working.end());
+                else
+                    writer.add_thread(threadId, S_OK, waiting.begin(), waiting.end());
+            }
+            std::vector<uint8_t> buffer;
+            writer.write(buffer);
+
+            Assert::AreEqual(size_t(10), writer.thread_count());
+            Assert::AreEqual(size_t(2), writer.stack_count());
+
+            auto profile = Decode(buffer);
+            for (const auto& thread : profile.threads)
+            {
+                const auto& expected = thread.threadId % 5 == 0 ? working : waiting;
+                Assert::IsTrue(thread.frames == expected);
+            }
+            Assert::AreEqual(profile.threads[0].stackIndex, profile.threads[1].stackIndex);
+            Assert::AreEqual(profile.threads[4].stackIndex, profile.threads[9].stackIndex);
+            Assert::AreNotEqual(profile.threads[0].stackIndex, profile.threads[4].stackIndex);
+        }
+
+        TEST_METHOD(a_thread_without_a_stack_has_no_stack_index)
+        {
+            const std::vector<uintptr_t> frames{ 0x10 };
+            const HRESULT NameLookupFailed = E_FAIL;
+
+            CompactProfileWriter writer;
+            writer.add_thread(1, NameLookupFailed);
+            writer.add_thread(2, S_OK, frames.begin(), frames.end());
+            std::vector<uint8_t> buffer;
+            writer.write(buffer);
+
+            auto profile = Decode(buffer);
+            Assert::AreEqual(-1, profile.threads[0].stackIndex);
+            Assert::AreEqual(NameLookupFailed, profile.threads[0].hresult);
+            Assert::AreEqual(1u, profile.header.stackCount);
+            Assert::IsTrue(profile.threads[1].frames == frames);
+        }
+
+        TEST_METHOD(a_cleared_writer_starts_a_new_profile)
+        {
+            const std::vector<uintptr_t> frames{ 0x10, 0x20 };
+
+            CompactProfileWriter writer;
+            writer.add_thread(1, S_OK, frames.begin(), frames.end());
+            writer.add_thread(2, E_FAIL);
+            std::vector<uint8_t> buffer;
+            writer.write(buffer);
+
+            writer.clear();
+            writer.add_thread(3, S_OK, frames.begin(), frames.end());
+            writer.write(buffer);
+
+            auto profile = Decode(buffer);
+            Assert::AreEqual(size_t(1), profile.threads.size());
+            Assert::IsTrue(profile.threads[0].threadId == 3);
+            Assert::AreEqual(0, profile.threads[0].stackIndex);
+            Assert::IsTrue(profile.threads[0].frames == frames);
+        }
+    };
+}}}
@@ -0,0 +1,200 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stdafx.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "../Profiler/InstrumentationRefreshQueue.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace NewRelic { namespace Profiler { namespace Test
+{
+    // stands in for RefreshInstrumentation, each refresh blocks until the test lets it finish
+    class FakeRefresh
+    {
+    public:
+        InstrumentationRefreshQueue::RefreshFunction Callback(HRESULT result = S_OK)
+        {
+            return [this, result](Configuration::IgnoreInstrumentationListPtr ignoreList) {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _ignoreLists.push_back(ignoreList);
+                _changed.notify_all();
+                _changed.wait(lock, [&] { return _released >= _ignoreLists.size(); });
+                return result;
+            };
+        }
+
+        // lets the refreshes that have started so far finish
+        void Release()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _released = _ignoreLists.size();
+            _changed.notify_all();
+        }
+
+        // lets every refresh finish from now on
+        void ReleaseAll()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _released = SIZE_MAX;
+            _changed.notify_all();
+        }
+
+        void WaitForStarted(size_t count)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _changed.wait(lock, [&] { return _ignoreLists.size() >= count; });
+        }
+
+        std::vector<Configuration::IgnoreInstrumentationListPtr> GetIgnoreLists()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _ignoreLists;
+        }
+
+    private:
+        std::mutex _mutex;
+        std::condition_variable _changed;
+        std::vector<Configuration::IgnoreInstrumentationListPtr> _ignoreLists;
+        size_t _released = 0;
+    };
+
+    static HRESULT WaitForGeneration(InstrumentationRefreshQueue& queue, uint64_t generation)
+    {
+        uint64_t requested = 0, completed = 0;
+        HRESULT result = queue.GetStatus(requested, completed);
+        while (completed < generation)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            result = queue.GetStatus(requested, completed);
+        }
+        return result;
+    }
+
+    TEST_CLASS(InstrumentationRefreshQueueTest)
+    {
+    public:
+        TEST_METHOD(requests_are_numbered_and_complete_in_order)
+        {
+            FakeRefresh refresh;
+            refresh.ReleaseAll();
+            InstrumentationRefreshQueue queue(refresh.Callback());
+
+            uint64_t requested = 0, completed = 0;
+            Assert::AreEqual(S_OK, queue.GetStatus(requested, completed));
+            Assert::IsTrue(requested == 0 && completed == 0);
+
+            auto first = queue.Request(nullptr);
+            Assert::IsTrue(first == 1);
+            WaitForGeneration(queue, first);
+
+            auto second = queue.Request(nullptr);
+            Assert::IsTrue(second == 2);
+            WaitForGeneration(queue, second);
+
+            queue.GetStatus(requested, completed);
+            Assert::IsTrue(requested == 2 && completed == 2);
+            Assert::AreEqual(size_t(2), refresh.GetIgnoreLists().size());
+        }
+
+        TEST_METHOD(requests_made_while_a_refresh_runs_are_merged_into_one)
+        {
+            FakeRefresh refresh;
+            InstrumentationRefreshQueue queue(refresh.Callback());
+
+            queue.Request(nullptr);
+            refresh.WaitForStarted(1);
+
+            uint64_t last = 0;
+            for (int i = 0; i < 10; ++i)
+                last = queue.Request(nullptr);
+
+            // the running refresh started before these, so it doesn't complete them, and they all wait for one more
+            refresh.Release();
+            refresh.WaitForStarted(2);
+            uint64_t requested = 0, completed = 0;
+            queue.GetStatus(requested, completed);
+            Assert::IsTrue(completed == 1);
+
+            refresh.Release();
+            WaitForGeneration(queue, last);
+            Assert::AreEqual(size_t(2), refresh.GetIgnoreLists().size());
+        }
+
+        TEST_METHOD(a_null_ignore_list_keeps_the_pending_one)
+        {
+            FakeRefresh refresh;
+            InstrumentationRefreshQueue queue(refresh.Callback());
+
+            queue.Request(nullptr);
+            refresh.WaitForStarted(1);
+
+            auto ignoreList = std::make_shared<Configuration::IgnoreInstrumentationList>();
+            queue.Request(ignoreList);
+            auto last = queue.Request(nullptr);
+
+            refresh.ReleaseAll();
+            WaitForGeneration(queue, last);
+
+            auto ignoreLists = refresh.GetIgnoreLists();
+            Assert::AreEqual(size_t(2), ignoreLists.size());
+            Assert::IsTrue(ignoreLists[0] == nullptr);
+            Assert::IsTrue(ignoreLists[1] == ignoreList);
+        }
+
+        TEST_METHOD(status_returns_the_result_of_the_last_refresh)
+        {
+            FakeRefresh refresh;
+            refresh.ReleaseAll();
+            InstrumentationRefreshQueue queue(refresh.Callback(S_FALSE));
+
+            Assert::AreEqual(S_FALSE, WaitForGeneration(queue, queue.Request(nullptr)));
+        }
+
+        TEST_METHOD(a_refresh_that_throws_completes_with_a_failure)
+        {
+            InstrumentationRefreshQueue queue([](Configuration::IgnoreInstrumentationListPtr) -> HRESULT {
+                throw std::runtime_error("refresh failed");
+            });
+
+            Assert::AreEqual(E_FAIL, WaitForGeneration(queue, queue.Request(nullptr)));
+        }
+
+        TEST_METHOD(shutdown_waits_for_the_running_refresh_and_runs_no_more)
+        {
+            FakeRefresh refresh;
+            InstrumentationRefreshQueue queue(refresh.Callback());
+
+            queue.Request(nullptr);
+            refresh.WaitForStarted(1);
+            queue.Request(nullptr);
+
+            std::thread release([&] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                refresh.ReleaseAll();
+            });
+            queue.Shutdown();
+            release.join();
+            queue.Shutdown();
+
+            uint64_t requested = 0, completed = 0;
+            queue.GetStatus(requested, completed);
+            auto refreshes = refresh.GetIgnoreLists().size();
+            Assert::IsTrue(completed >= 1);
+
+            // requests made after shutdown are numbered but never run
+            Assert::IsTrue(queue.Request(nullptr) == requested + 1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            uint64_t completedAfter = 0;
+            queue.GetStatus(requested, completedAfter);
+            Assert::IsTrue(completedAfter == completed);
+            Assert::AreEqual(refreshes, refresh.GetIgnoreLists().size());
+        }
+    };
+}}}
@@ -0,0 +1,85 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stdafx.h"
+#include <set>
+#include "CppUnitTest.h"
+#include "../Profiler/ModuleRegistry.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace NewRelic { namespace Profiler { namespace Test
+{
+    TEST_CLASS(ModuleRegistryTest)
+    {
+    public:
+        TEST_METHOD(assembly_names_are_looked_up_case_insensitively)
+        {
+            ModuleRegistry registry;
+            registry.Add(1, _X("System.Net.Http"));
+
+            auto modules = registry.GetModules({ _X("SYSTEM.NET.HTTP") });
+            Assert::AreEqual(size_t(1), modules.size());
+            Assert::IsTrue(modules[0].first == 1);
+            // the name comes back the way the runtime reported it
+            Assert::IsTrue(modules[0].second == _X("System.Net.Http"));
+
+            Assert::AreEqual(size_t(1), registry.GetModules({ _X("system.net.http") }).size());
+            Assert::IsTrue(registry.GetModules({ _X("System.Net") }).empty());
+        }
+
+        TEST_METHOD(every_module_of_an_assembly_is_returned)
+        {
+            ModuleRegistry registry;
+            registry.Add(1, _X("MyAssembly"));
+            registry.Add(2, _X("MYASSEMBLY"));
+            registry.Add(3, _X("OtherAssembly"));
+
+            std::set<ModuleID> moduleIds;
+            for (auto& module : registry.GetModules({ _X("myassembly") }))
+                moduleIds.insert(module.first);
+            Assert::IsTrue(moduleIds == std::set<ModuleID>{ 1, 2 });
+
+            // asking for the same assembly twice returns its modules once
+            Assert::AreEqual(size_t(3), registry.GetModules({ _X("MyAssembly"), _X("myAssembly"), _X("OtherAssembly") }).size());
+        }
+
+        TEST_METHOD(unloaded_modules_are_removed)
+        {
+            ModuleRegistry registry;
+            registry.Add(1, _X("MyAssembly"));
+            registry.Add(2, _X("MyAssembly"));
+
+            registry.Remove(1);
+            auto modules = registry.GetModules({ _X("MyAssembly") });
+            Assert::AreEqual(size_t(1), modules.size());
+            Assert::IsTrue(modules[0].first == 2);
+
+            registry.Remove(2);
+            Assert::IsTrue(registry.GetModules({ _X("MyAssembly") }).empty());
+            Assert::AreEqual(size_t(0), registry.GetSize());
+
+            // a module that was never added, or was already removed, is ignored
+            registry.Remove(2);
+            registry.Remove(3);
+            Assert::AreEqual(size_t(0), registry.GetSize());
+        }
+
+        TEST_METHOD(a_reused_module_id_moves_to_its_new_assembly)
+        {
+            ModuleRegistry registry;
+            registry.Add(1, _X("MyAssembly"));
+            registry.Remove(1);
+            registry.Add(1, _X("OtherAssembly"));
+
+            Assert::IsTrue(registry.GetModules({ _X("MyAssembly") }).empty());
+            Assert::AreEqual(size_t(1), registry.GetModules({ _X("OtherAssembly") }).size());
+
+            // and moves without an unload in between too
+            registry.Add(1, _X("ThirdAssembly"));
+            Assert::IsTrue(registry.GetModules({ _X("OtherAssembly") }).empty());
+            Assert::AreEqual(size_t(1), registry.GetModules({ _X("ThirdAssembly") }).size());
+            Assert::AreEqual(size_t(1), registry.GetSize());
+        }
+    };
+}}}
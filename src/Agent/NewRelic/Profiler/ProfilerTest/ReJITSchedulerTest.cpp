@@ -0,0 +1,266 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stdafx.h"
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+#define LOGGER_DEFINE_STDLOG
+#include "CppUnitTest.h"
+#include "../Profiler/ReJITScheduler.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace NewRelic { namespace Profiler { namespace Test
+{
+    // stands in for RequestReJIT and RequestRevert, recording each batch it is handed
+    class FakeRequests
+    {
+    public:
+        typedef std::vector<std::pair<ModuleID, mdMethodDef>> Batch;
+
+        ReJITScheduler::RequestFunction Callback()
+        {
+            return [this](ULONG count, ModuleID* moduleIds, mdMethodDef* methodIds) {
+                Batch batch;
+                for (ULONG i = 0; i < count; ++i)
+                    batch.emplace_back(moduleIds[i], methodIds[i]);
+
+                std::lock_guard<std::mutex> lock(_mutex);
+                _batches.push_back(batch);
+                return S_OK;
+            };
+        }
+
+        std::vector<Batch> GetBatches()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _batches;
+        }
+
+        std::set<std::pair<ModuleID, mdMethodDef>> GetMethods()
+        {
+            std::set<std::pair<ModuleID, mdMethodDef>> methods;
+            for (auto& batch : GetBatches())
+                methods.insert(batch.begin(), batch.end());
+            return methods;
+        }
+
+        size_t GetMethodCount()
+        {
+            size_t count = 0;
+            for (auto& batch : GetBatches())
+                count += batch.size();
+            return count;
+        }
+
+    private:
+        std::mutex _mutex;
+        std::vector<Batch> _batches;
+    };
+
+    // long enough that nothing is sent by the window running out while a test is running
+    static const uint32_t LongWindowInMilliseconds = 60 * 1000;
+
+    TEST_CLASS(ReJITSchedulerTest)
+    {
+    public:
+        TEST_METHOD(duplicate_requests_are_sent_once)
+        {
+            FakeRequests rejits, reverts;
+            ReJITScheduler scheduler(rejits.Callback(), reverts.Callback(), LongWindowInMilliseconds);
+
+            scheduler.ReJIT(1, 0x06000001);
+            scheduler.ReJIT(1, 0x06000001);
+            scheduler.ReJIT(2, 0x06000001);
+            scheduler.Flush();
+
+            auto batches = rejits.GetBatches();
+            Assert::AreEqual(size_t(1), batches.size());
+            Assert::AreEqual(size_t(2), batches[0].size());
+            Assert::IsTrue(reverts.GetBatches().empty());
+        }
+
+        TEST_METHOD(the_last_request_for_a_method_wins)
+        {
+            FakeRequests rejits, reverts;
+            ReJITScheduler scheduler(rejits.Callback(), reverts.Callback(), LongWindowInMilliseconds);
+
+            scheduler.ReJIT(1, 0x06000001);
+            scheduler.Revert(1, 0x06000001);
+            scheduler.Revert(1, 0x06000002);
+            scheduler.ReJIT(1, 0x06000002);
+            scheduler.Flush();
+
+            Assert::IsTrue(rejits.GetMethods() == std::set<std::pair<ModuleID, mdMethodDef>>{ { 1, 0x06000002 } });
+            Assert::IsTrue(reverts.GetMethods() == std::set<std::pair<ModuleID, mdMethodDef>>{ { 1, 0x06000001 } });
+        }
+
+        TEST_METHOD(requests_wait_for_the_coalescing_window)
+        {
+            FakeRequests rejits, reverts;
+            ReJITScheduler scheduler(rejits.Callback(), reverts.Callback(), LongWindowInMilliseconds);
+
+            scheduler.ReJIT(1, 0x06000001);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            scheduler.ReJIT(1, 0x06000002);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            Assert::IsTrue(rejits.GetBatches().empty());
+
+            scheduler.Flush();
+            auto batches = rejits.GetBatches();
+            Assert::AreEqual(size_t(1), batches.size());
+            Assert::AreEqual(size_t(2), batches[0].size());
+        }
+
+        TEST_METHOD(requests_are_sent_once_the_window_ends)
+        {
+            FakeRequests rejits, reverts;
+            ReJITScheduler scheduler(rejits.Callback(), reverts.Callback(), 10);
+
+            scheduler.ReJIT(1, 0x06000001);
+            scheduler.ReJIT(1, 0x06000002);
+
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (rejits.GetMethodCount() < 2 && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+            Assert::AreEqual(size_t(2), rejits.GetMethodCount());
+        }
+
+        TEST_METHOD(a_full_batch_is_sent_without_waiting_for_the_window)
+        {
+            FakeRequests rejits, reverts;
+            ReJITScheduler scheduler(rejits.Callback(), reverts.Callback(), LongWindowInMilliseconds, 2);
+
+            scheduler.ReJIT(1, 0x06000001);
+            scheduler.ReJIT(1, 0x06000002);
+
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (rejits.GetMethodCount() < 2 && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+            Assert::AreEqual(size_t(2), rejits.GetMethodCount());
+        }
+
+        TEST_METHOD(batches_hold_at_most_max_batch_size_methods)
+        {
+            FakeRequests rejits, reverts;
+            ReJITScheduler scheduler(rejits.Callback(), reverts.Callback(), LongWindowInMilliseconds, 2);
+
+            for (mdMethodDef methodId = 0x06000001; methodId <= 0x06000005; ++methodId)
+                scheduler.ReJIT(1, methodId);
+            scheduler.Flush();
+
+            for (auto& batch : rejits.GetBatches())
+                Assert::IsTrue(batch.size() <= 2);
+            Assert::AreEqual(size_t(5), rejits.GetMethods().size());
+        }
+
+        TEST_METHOD(flush_returns_once_earlier_requests_are_sent)
+        {
+            FakeRequests rejits, reverts;
+            ReJITScheduler scheduler(rejits.Callback(), reverts.Callback(), LongWindowInMilliseconds);
+
+            scheduler.Flush();
+            Assert::IsTrue(rejits.GetBatches().empty());
+
+            scheduler.ReJIT(1, 0x06000001);
+            scheduler.Revert(2, 0x06000001);
+            scheduler.Flush();
+            Assert::AreEqual(size_t(1), rejits.GetMethodCount());
+            Assert::AreEqual(size_t(1), reverts.GetMethodCount());
+
+            scheduler.ReJIT(1, 0x06000002);
+            scheduler.Flush();
+            Assert::AreEqual(size_t(2), rejits.GetMethodCount());
+        }
+
+        TEST_METHOD(shutdown_drops_pending_requests)
+        {
+            FakeRequests rejits, reverts;
+            {
+                ReJITScheduler scheduler(rejits.Callback(), reverts.Callback(), LongWindowInMilliseconds);
+                scheduler.ReJIT(1, 0x06000001);
+                scheduler.Revert(1, 0x06000002);
+
+                scheduler.Shutdown();
+                scheduler.Shutdown();
+
+                // nothing will send them, so neither these nor a flush may block
+                scheduler.ReJIT(1, 0x06000003);
+                scheduler.Flush();
+            }
+
+            Assert::IsTrue(rejits.GetBatches().empty());
+            Assert::IsTrue(reverts.GetBatches().empty());
+        }
+
+        TEST_METHOD(requests_for_a_dropped_module_are_dropped_until_it_is_released)
+        {
+            FakeRequests rejits, reverts;
+            ReJITScheduler scheduler(rejits.Callback(), reverts.Callback(), LongWindowInMilliseconds);
+
+            scheduler.ReJIT(1, 0x06000001);
+            scheduler.ReJIT(2, 0x06000001);
+            scheduler.DropModule(1);
+
+            // a callback that was still running for the module when it started unloading
+            scheduler.ReJIT(1, 0x06000002);
+            scheduler.Revert(1, 0x06000003);
+            scheduler.Flush();
+            Assert::IsTrue(rejits.GetMethods() == std::set<std::pair<ModuleID, mdMethodDef>>{ { 2, 0x06000001 } });
+            Assert::IsTrue(reverts.GetBatches().empty());
+
+            scheduler.ReJIT(1, 0x06000004);
+            scheduler.Flush();
+            Assert::AreEqual(size_t(1), rejits.GetMethodCount());
+            Assert::AreEqual(size_t(1), scheduler.GetDroppedModuleCount());
+
+            // a module loaded after the release may have been given the same id
+            scheduler.ReleaseDroppedModule(1);
+            scheduler.ReJIT(1, 0x06000005);
+            scheduler.Flush();
+            Assert::IsTrue(rejits.GetMethods() == std::set<std::pair<ModuleID, mdMethodDef>>{ { 2, 0x06000001 }, { 1, 0x06000005 } });
+            Assert::AreEqual(size_t(0), scheduler.GetDroppedModuleCount());
+        }
+
+        TEST_METHOD(a_module_dropped_again_before_the_drain_stays_dropped)
+        {
+            FakeRequests rejits, reverts;
+            ReJITScheduler scheduler(rejits.Callback(), reverts.Callback(), LongWindowInMilliseconds);
+
+            scheduler.DropModule(1);
+            scheduler.ReleaseDroppedModule(1);
+            scheduler.DropModule(1);
+            scheduler.ReJIT(1, 0x06000001);
+            scheduler.Flush();
+
+            Assert::IsTrue(rejits.GetBatches().empty());
+            Assert::AreEqual(size_t(1), scheduler.GetDroppedModuleCount());
+        }
+
+        TEST_METHOD(requests_from_many_threads_are_all_sent)
+        {
+            FakeRequests rejits, reverts;
+            ReJITScheduler scheduler(rejits.Callback(), reverts.Callback(), 1, 64);
+
+            std::vector<std::thread> threads;
+            for (ModuleID moduleId = 1; moduleId <= 4; ++moduleId)
+            {
+                threads.emplace_back([&scheduler, moduleId] {
+                    for (mdMethodDef methodId = 0x06000001; methodId <= 0x06000400; ++methodId)
+                        scheduler.ReJIT(moduleId, methodId);
+                });
+            }
+            for (auto& thread : threads)
+                thread.join();
+            scheduler.Flush();
+
+            Assert::AreEqual(size_t(4 * 0x400), rejits.GetMethods().size());
+        }
+    };
+}}}
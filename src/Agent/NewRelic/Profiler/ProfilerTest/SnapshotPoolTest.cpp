@@ -0,0 +1,216 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stdafx.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "../ThreadProfiler/SnapshotPool.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace NewRelic { namespace Profiler { namespace Test
+{
+    using ThreadProfiler::SnapshotPool;
+
+    // records which thread ran each lane of the jobs it is handed
+    class LaneRecorder
+    {
+    public:
+        explicit LaneRecorder(size_t laneCount) : _threads(laneCount), _runs(laneCount)
+        {}
+
+        void operator()(size_t lane)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _threads[lane] = std::this_thread::get_id();
+            ++_runs[lane];
+        }
+
+        std::thread::id GetThread(size_t lane)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _threads[lane];
+        }
+
+        int GetRuns(size_t lane)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _runs[lane];
+        }
+
+    private:
+        std::mutex _mutex;
+        std::vector<std::thread::id> _threads;
+        std::vector<int> _runs;
+    };
+
+    TEST_CLASS(SnapshotPoolTest)
+    {
+    public:
+        TEST_METHOD(each_lane_runs_once_on_its_own_thread)
+        {
+            SnapshotPool pool;
+            pool.Start(4, nullptr);
+            Assert::AreEqual(size_t(4), pool.GetLaneCount());
+
+            LaneRecorder recorder(4);
+            pool.Run(4, recorder);
+
+            std::set<std::thread::id> threads;
+            for (size_t lane = 0; lane != 4; ++lane)
+            {
+                Assert::AreEqual(1, recorder.GetRuns(lane));
+                threads.insert(recorder.GetThread(lane));
+            }
+            Assert::AreEqual(size_t(4), threads.size());
+            // the caller is lane 0
+            Assert::IsTrue(recorder.GetThread(0) == std::this_thread::get_id());
+        }
+
+        TEST_METHOD(helper_threads_are_started_and_initialized_once_and_reused)
+        {
+            std::atomic<int> initializations{ 0 };
+            SnapshotPool pool;
+            pool.Start(3, [&initializations] { ++initializations; });
+
+            LaneRecorder first(3);
+            pool.Run(3, first);
+
+            LaneRecorder recorder(3);
+            for (int run = 0; run != 100; ++run)
+                pool.Run(3, recorder);
+
+            Assert::AreEqual(2, initializations.load());
+            for (size_t lane = 0; lane != 3; ++lane)
+            {
+                Assert::AreEqual(100, recorder.GetRuns(lane));
+                Assert::IsTrue(recorder.GetThread(lane) == first.GetThread(lane));
+            }
+        }
+
+        TEST_METHOD(a_job_runs_on_at_most_the_lanes_the_pool_has)
+        {
+            SnapshotPool pool;
+            pool.Start(2, nullptr);
+
+            LaneRecorder recorder(8);
+            pool.Run(8, recorder);
+
+            Assert::AreEqual(1, recorder.GetRuns(0));
+            Assert::AreEqual(1, recorder.GetRuns(1));
+            for (size_t lane = 2; lane != 8; ++lane)
+                Assert::AreEqual(0, recorder.GetRuns(lane));
+        }
+
+        TEST_METHOD(a_job_for_fewer_lanes_leaves_the_other_helpers_idle)
+        {
+            SnapshotPool pool;
+            pool.Start(4, nullptr);
+
+            LaneRecorder two(4);
+            pool.Run(2, two);
+            Assert::AreEqual(1, two.GetRuns(0));
+            Assert::AreEqual(1, two.GetRuns(1));
+            Assert::AreEqual(0, two.GetRuns(2));
+            Assert::AreEqual(0, two.GetRuns(3));
+
+            // the idle helpers still take the next job that needs them
+            LaneRecorder four(4);
+            pool.Run(4, four);
+            for (size_t lane = 0; lane != 4; ++lane)
+                Assert::AreEqual(1, four.GetRuns(lane));
+        }
+
+        TEST_METHOD(a_single_lane_runs_on_the_calling_thread)
+        {
+            SnapshotPool pool;
+            Assert::AreEqual(size_t(1), pool.GetLaneCount());
+
+            LaneRecorder recorder(1);
+            pool.Run(4, recorder);
+            pool.Run(0, recorder);
+            Assert::AreEqual(2, recorder.GetRuns(0));
+            Assert::IsTrue(recorder.GetThread(0) == std::this_thread::get_id());
+
+            pool.Start(4, nullptr);
+            pool.Run(1, recorder);
+            Assert::AreEqual(3, recorder.GetRuns(0));
+        }
+
+        TEST_METHOD(start_replaces_the_helper_threads_and_stop_joins_them)
+        {
+            std::atomic<int> initializations{ 0 };
+            SnapshotPool pool;
+            pool.Start(4, [&initializations] { ++initializations; });
+            pool.Start(2, [&initializations] { ++initializations; });
+            Assert::AreEqual(size_t(2), pool.GetLaneCount());
+
+            LaneRecorder recorder(4);
+            pool.Run(4, recorder);
+            Assert::AreEqual(1, recorder.GetRuns(1));
+            Assert::AreEqual(0, recorder.GetRuns(2));
+
+            pool.Stop();
+            pool.Stop();
+            Assert::AreEqual(size_t(1), pool.GetLaneCount());
+            Assert::AreEqual(4, initializations.load());
+        }
+
+        TEST_METHOD(a_pool_restarted_after_a_job_waits_for_the_next_one)
+        {
+            // the profiler stops the pool after every session and starts it again for the next
+            SnapshotPool pool;
+            pool.Start(4, nullptr);
+            LaneRecorder first(4);
+            pool.Run(4, first);
+            pool.Stop();
+
+            pool.Start(4, nullptr);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+            LaneRecorder second(4);
+            pool.Run(4, second);
+            pool.Run(2, second);
+            Assert::AreEqual(2, second.GetRuns(0));
+            Assert::AreEqual(2, second.GetRuns(1));
+            Assert::AreEqual(1, second.GetRuns(2));
+            Assert::AreEqual(1, second.GetRuns(3));
+            for (size_t lane = 0; lane != 4; ++lane)
+                Assert::AreEqual(1, first.GetRuns(lane));
+        }
+
+        TEST_METHOD(an_exception_from_the_calling_thread_is_rethrown_once_the_helpers_finish)
+        {
+            SnapshotPool pool;
+            pool.Start(3, nullptr);
+
+            std::atomic<int> helperRuns{ 0 };
+            auto job = [&helperRuns](size_t lane) {
+                if (lane == 0)
+                    throw std::runtime_error("lane 0 failed");
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                ++helperRuns;
+            };
+            Assert::ExpectException<std::runtime_error>([&] { pool.Run(3, job); });
+            Assert::AreEqual(2, helperRuns.load());
+
+            // an exception on a helper is dropped and the helper keeps working
+            auto helperThrows = [](size_t lane) {
+                if (lane != 0)
+                    throw std::runtime_error("helper failed");
+            };
+            pool.Run(3, helperThrows);
+
+            LaneRecorder recorder(3);
+            pool.Run(3, recorder);
+            for (size_t lane = 0; lane != 3; ++lane)
+                Assert::AreEqual(1, recorder.GetRuns(lane));
+        }
+    };
+}}}
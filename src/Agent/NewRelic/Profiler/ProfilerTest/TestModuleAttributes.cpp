@@ -0,0 +1,9 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+BEGIN_TEST_MODULE_ATTRIBUTE()
+    TEST_MODULE_ATTRIBUTE(L"Category", L"Profiler Unit Tests")
+END_TEST_MODULE_ATTRIBUTE()
@@ -0,0 +1,142 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stdafx.h"
+#include <algorithm>
+#include <vector>
+#include "CppUnitTest.h"
+#include "../ThreadProfiler/ThreadRegistry.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace NewRelic { namespace Profiler { namespace Test
+{
+    using ThreadProfiler::ThreadRegistry;
+
+    static std::vector<ThreadID> GetThreads(const ThreadRegistry& registry)
+    {
+        std::vector<ThreadID> threadIds;
+        registry.GetThreads(threadIds);
+        return threadIds;
+    }
+
+    static DWORD GetOSThreadId(const ThreadRegistry& registry, ThreadID threadId)
+    {
+        std::vector<DWORD> osThreadIds;
+        registry.GetOSThreadIds({ threadId }, osThreadIds);
+        return osThreadIds[0];
+    }
+
+    TEST_CLASS(ThreadRegistryTest)
+    {
+    public:
+        TEST_METHOD(a_thread_is_snapshot_once_it_is_assigned_an_os_thread)
+        {
+            ThreadRegistry registry;
+            registry.Add(1);
+
+            // a thread that hasn't started has no stack
+            Assert::AreEqual(size_t(1), registry.size());
+            Assert::IsTrue(GetThreads(registry).empty());
+            Assert::AreEqual(DWORD(0), GetOSThreadId(registry, 1));
+
+            registry.AssignOSThread(1, 100);
+            Assert::IsTrue(GetThreads(registry) == std::vector<ThreadID>{ 1 });
+            Assert::AreEqual(DWORD(100), GetOSThreadId(registry, 1));
+        }
+
+        TEST_METHOD(a_destroyed_thread_is_removed)
+        {
+            ThreadRegistry registry;
+            registry.Add(1);
+            registry.AssignOSThread(1, 100);
+
+            registry.Remove(1);
+            Assert::AreEqual(size_t(0), registry.size());
+            Assert::IsTrue(GetThreads(registry).empty());
+            Assert::AreEqual(DWORD(0), GetOSThreadId(registry, 1));
+
+            // a thread that is already gone, or was never added, is ignored
+            registry.Remove(1);
+            registry.Remove(2);
+            Assert::AreEqual(size_t(0), registry.size());
+        }
+
+        TEST_METHOD(a_thread_destroyed_before_it_is_assigned_is_never_snapshot)
+        {
+            ThreadRegistry registry;
+            registry.Add(1);
+            registry.Add(2);
+            registry.Remove(1);
+
+            Assert::AreEqual(size_t(1), registry.size());
+            Assert::IsTrue(GetThreads(registry).empty());
+
+            registry.AssignOSThread(2, 200);
+            Assert::IsTrue(GetThreads(registry) == std::vector<ThreadID>{ 2 });
+            Assert::AreEqual(DWORD(0), GetOSThreadId(registry, 1));
+        }
+
+        TEST_METHOD(removing_a_thread_keeps_the_others)
+        {
+            ThreadRegistry registry;
+            for (ThreadID threadId = 1; threadId <= 4; ++threadId)
+            {
+                registry.Add(threadId);
+                registry.AssignOSThread(threadId, static_cast<DWORD>(threadId * 100));
+            }
+
+            // the first and last entries, then one from the middle
+            registry.Remove(1);
+            registry.Remove(4);
+            registry.Remove(2);
+
+            Assert::IsTrue(GetThreads(registry) == std::vector<ThreadID>{ 3 });
+            Assert::AreEqual(DWORD(300), GetOSThreadId(registry, 3));
+            Assert::AreEqual(DWORD(0), GetOSThreadId(registry, 2));
+        }
+
+        TEST_METHOD(a_reused_thread_id_starts_over)
+        {
+            ThreadRegistry registry;
+            registry.Add(1);
+            registry.AssignOSThread(1, 100);
+            registry.Remove(1);
+
+            registry.Add(1);
+            Assert::IsTrue(GetThreads(registry).empty());
+            Assert::AreEqual(DWORD(0), GetOSThreadId(registry, 1));
+
+            registry.AssignOSThread(1, 101);
+            Assert::AreEqual(DWORD(101), GetOSThreadId(registry, 1));
+        }
+
+        TEST_METHOD(a_thread_assigned_without_being_created_is_added)
+        {
+            // the callbacks were turned on after the thread was created
+            ThreadRegistry registry;
+            registry.AssignOSThread(1, 100);
+
+            Assert::IsTrue(GetThreads(registry) == std::vector<ThreadID>{ 1 });
+            Assert::AreEqual(DWORD(100), GetOSThreadId(registry, 1));
+        }
+
+        TEST_METHOD(seeding_keeps_what_the_callbacks_reported)
+        {
+            ThreadRegistry registry;
+            Assert::IsFalse(registry.IsSeeded());
+            registry.AssignOSThread(1, 100);
+            registry.Add(2);
+
+            registry.Seed({ { 1, 999, true }, { 2, 200, true }, { 3, 0, false } });
+            Assert::IsTrue(registry.IsSeeded());
+            Assert::AreEqual(size_t(3), registry.size());
+            Assert::AreEqual(DWORD(100), GetOSThreadId(registry, 1));
+            Assert::AreEqual(DWORD(200), GetOSThreadId(registry, 2));
+
+            auto threads = GetThreads(registry);
+            Assert::AreEqual(size_t(2), threads.size());
+            Assert::IsTrue(std::find(threads.begin(), threads.end(), ThreadID(3)) == threads.end());
+        }
+    };
+}}}
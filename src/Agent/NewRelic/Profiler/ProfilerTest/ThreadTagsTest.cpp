@@ -0,0 +1,139 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "stdafx.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "../ThreadProfiler/ThreadTags.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace NewRelic { namespace Profiler { namespace Test
+{
+    using ThreadProfiler::ThreadTags;
+
+    // ThreadIDs are pointers, so tests use ids that look like them
+    static ThreadID ThreadIdFor(size_t thread)
+    {
+        return static_cast<ThreadID>(thread * 0x100);
+    }
+
+    static std::vector<ThreadID> GetTaggedThreads(const ThreadTags& tags)
+    {
+        std::vector<ThreadID> threadIds;
+        tags.GetTaggedThreads(threadIds);
+        return threadIds;
+    }
+
+    TEST_CLASS(ThreadTagsTest)
+    {
+    public:
+        TEST_METHOD(a_thread_has_no_tag_until_it_sets_one)
+        {
+            auto tags = std::make_unique<ThreadTags>();
+            Assert::IsTrue(tags->Get(ThreadIdFor(1)) == 0);
+
+            // clearing a tag that was never set takes no slot
+            Assert::IsTrue(tags->Set(ThreadIdFor(1), 0));
+            Assert::IsTrue(GetTaggedThreads(*tags).empty());
+
+            Assert::IsTrue(tags->Set(ThreadIdFor(1), 42));
+            Assert::IsTrue(tags->Get(ThreadIdFor(1)) == 42);
+            Assert::IsTrue(GetTaggedThreads(*tags) == std::vector<ThreadID>{ ThreadIdFor(1) });
+
+            Assert::IsTrue(tags->Set(ThreadIdFor(1), 43));
+            Assert::IsTrue(tags->Get(ThreadIdFor(1)) == 43);
+
+            Assert::IsTrue(tags->Set(ThreadIdFor(1), 0));
+            Assert::IsTrue(tags->Get(ThreadIdFor(1)) == 0);
+            Assert::IsTrue(GetTaggedThreads(*tags).empty());
+        }
+
+        TEST_METHOD(a_full_table_takes_a_new_thread_once_one_is_removed)
+        {
+            auto tags = std::make_unique<ThreadTags>();
+            for (size_t thread = 1; thread <= ThreadTags::Capacity; ++thread)
+                Assert::IsTrue(tags->Set(ThreadIdFor(thread), thread));
+
+            const auto newThread = ThreadIdFor(ThreadTags::Capacity + 1);
+            Assert::IsFalse(tags->Set(newThread, 1));
+            Assert::AreEqual(size_t(ThreadTags::Capacity), GetTaggedThreads(*tags).size());
+
+            tags->Remove(ThreadIdFor(10));
+            Assert::IsTrue(tags->Get(ThreadIdFor(10)) == 0);
+            Assert::IsTrue(tags->Set(newThread, 1));
+            Assert::IsTrue(tags->Get(newThread) == 1);
+            for (size_t thread = 1; thread <= ThreadTags::Capacity; ++thread)
+            {
+                if (thread != 10)
+                    Assert::IsTrue(tags->Get(ThreadIdFor(thread)) == thread);
+            }
+        }
+
+        TEST_METHOD(removed_threads_leave_no_tombstones_once_nothing_probes_past_them)
+        {
+            auto tags = std::make_unique<ThreadTags>();
+            // a full table, so every removed slot but the last has a thread after it
+            for (size_t thread = 1; thread <= ThreadTags::Capacity; ++thread)
+                tags->Set(ThreadIdFor(thread), thread);
+            for (size_t thread = 1; thread <= ThreadTags::Capacity; thread += 2)
+                tags->Remove(ThreadIdFor(thread));
+            Assert::IsTrue(tags->GetTombstoneCount() > 0);
+            for (size_t thread = 2; thread <= ThreadTags::Capacity; thread += 2)
+                Assert::IsTrue(tags->Get(ThreadIdFor(thread)) == thread);
+
+            for (size_t thread = 2; thread <= ThreadTags::Capacity; thread += 2)
+                tags->Remove(ThreadIdFor(thread));
+            Assert::AreEqual(size_t(0), tags->GetTombstoneCount());
+            Assert::IsTrue(GetTaggedThreads(*tags).empty());
+        }
+
+        TEST_METHOD(thread_pool_churn_leaves_no_tombstones)
+        {
+            auto tags = std::make_unique<ThreadTags>();
+            const auto longLived = ThreadIdFor(1);
+            tags->Set(longLived, 7);
+
+            // pool threads come and go, each with a new id, while the sampler keeps looking up a thread that stays
+            std::atomic<bool> done{ false };
+            std::atomic<int> missed{ 0 };
+            std::thread sampler([&] {
+                while (!done)
+                {
+                    if (tags->Get(longLived) != 7)
+                        ++missed;
+                }
+            });
+
+            std::vector<std::thread> pool;
+            for (size_t worker = 0; worker != 4; ++worker)
+            {
+                pool.emplace_back([&tags, worker] {
+                    for (size_t generation = 0; generation != 5000; ++generation)
+                    {
+                        const auto threadId = ThreadIdFor(2 + worker + generation * 4);
+                        tags->Set(threadId, generation + 1);
+                        if (tags->Get(threadId) != generation + 1)
+                            return;
+                        tags->Remove(threadId);
+                    }
+                });
+            }
+            for (auto& thread : pool)
+                thread.join();
+            done = true;
+            sampler.join();
+
+            Assert::AreEqual(0, missed.load());
+            Assert::IsTrue(GetTaggedThreads(*tags) == std::vector<ThreadID>{ longLived });
+            // only tombstones right before the thread that stays can be left
+            Assert::IsTrue(tags->GetTombstoneCount() < 16);
+
+            tags->Remove(longLived);
+            Assert::AreEqual(size_t(0), tags->GetTombstoneCount());
+        }
+    };
+}}}
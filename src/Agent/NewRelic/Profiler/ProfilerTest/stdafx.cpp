@@ -0,0 +1,12 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+
+// stdafx.cpp : source file that includes just the standard includes
+// ProfilerTest.pch will be the pre-compiled header
+// stdafx.obj will contain the pre-compiled type information
+
+#include "stdafx.h"
+
+// Reference any additional headers you need in STDAFX.H
+// and not in this file
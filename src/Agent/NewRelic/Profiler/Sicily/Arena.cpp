@@ -0,0 +1,96 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstdlib>
+#include <cstring>
+
+#include "Arena.h"
+
+namespace sicily {
+    Arena::Arena()
+        : cursor_(inline_), limit_(inline_ + kInlineSize), blocks_(nullptr), cleanups_(nullptr), bytesAllocated_(0)
+    {
+    }
+
+    Arena::~Arena()
+    {
+        Reset();
+    }
+
+    void*
+    Arena::Allocate(size_t size, size_t alignment)
+    {
+        uintptr_t current = reinterpret_cast<uintptr_t>(cursor_);
+        uintptr_t aligned = (current + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        if (aligned + size > reinterpret_cast<uintptr_t>(limit_)) {
+            return AllocateSlow(size, alignment);
+        }
+        cursor_ = reinterpret_cast<unsigned char*>(aligned + size);
+        bytesAllocated_ += size;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    void*
+    Arena::AllocateSlow(size_t size, size_t alignment)
+    {
+        // oversized requests get a block of their own so the remaining space in a normal block isn't wasted
+        size_t payload = size + alignment > kBlockSize ? size + alignment : kBlockSize;
+        Block* block = static_cast<Block*>(std::malloc(sizeof(Block) + payload));
+        if (block == nullptr) {
+            throw ArenaAllocationException();
+        }
+        block->next_ = blocks_;
+        block->size_ = payload;
+        blocks_ = block;
+
+        cursor_ = reinterpret_cast<unsigned char*>(block + 1);
+        limit_ = cursor_ + payload;
+        return Allocate(size, alignment);
+    }
+
+    void
+    Arena::RegisterCleanup(void* object, void (*destroy)(void*))
+    {
+        Cleanup* cleanup = static_cast<Cleanup*>(Allocate(sizeof(Cleanup), alignof(Cleanup)));
+        cleanup->next_ = cleanups_;
+        cleanup->destroy_ = destroy;
+        cleanup->object_ = object;
+        cleanups_ = cleanup;
+    }
+
+    StringView
+    Arena::CopyString(const xchar_t* data, size_t length)
+    {
+        xchar_t* copy = MakeArray<xchar_t>(length + 1);
+        if (length > 0) {
+            std::memcpy(copy, data, length * sizeof(xchar_t));
+        }
+        copy[length] = 0;
+        return StringView(copy, length);
+    }
+
+    void
+    Arena::Reset()
+    {
+        for (Cleanup* cleanup = cleanups_; cleanup != nullptr; cleanup = cleanup->next_) {
+            cleanup->destroy_(cleanup->object_);
+        }
+        cleanups_ = nullptr;
+
+        while (blocks_ != nullptr) {
+            Block* next = blocks_->next_;
+            std::free(blocks_);
+            blocks_ = next;
+        }
+
+        cursor_ = inline_;
+        limit_ = inline_ + kInlineSize;
+        bytesAllocated_ = 0;
+    }
+
+    size_t
+    Arena::GetBytesAllocated() const
+    {
+        return bytesAllocated_;
+    }
+};
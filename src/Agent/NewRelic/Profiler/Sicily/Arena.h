@@ -0,0 +1,98 @@
+/*
+* Copyright 2020 New Relic Corporation. All rights reserved.
+* SPDX-License-Identifier: Apache-2.0
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "Exceptions.h"
+#include "StringView.h"
+
+namespace sicily {
+    //
+    // Bump allocator that owns everything produced by a parse.  Nothing allocated
+    // from an arena is freed on its own; the whole arena is released in one step
+    // when it is destroyed (or Reset), which is normally right after bytecode
+    // generation.  The first block lives inside the arena itself so that the
+    // typical signature string never touches the heap.
+    //
+    class Arena
+    {
+        public:
+            Arena();
+            ~Arena();
+
+            void* Allocate(size_t size, size_t alignment);
+
+            template <typename T, typename... Args>
+            T* Make(Args&&... args)
+            {
+                void* memory = Allocate(sizeof(T), alignof(T));
+                T* object = new (memory) T(std::forward<Args>(args)...);
+                if (!std::is_trivially_destructible<T>::value) {
+                    RegisterCleanup(object, &Destroy<T>);
+                }
+                return object;
+            }
+
+            template <typename T>
+            T* MakeArray(size_t count)
+            {
+                static_assert(std::is_trivially_destructible<T>::value, "arena arrays are never destroyed");
+                return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+            }
+
+            // copies the characters into the arena so the result outlives its source
+            StringView CopyString(const xchar_t* data, size_t length);
+
+            // releases everything allocated so far, keeping the inline block for reuse
+            void Reset();
+
+            // bytes handed out since construction or the last Reset
+            size_t GetBytesAllocated() const;
+
+        private:
+            Arena(const Arena&) = delete;
+            Arena& operator=(const Arena&) = delete;
+
+            struct Block
+            {
+                Block* next_;
+                size_t size_;
+            };
+
+            struct Cleanup
+            {
+                Cleanup* next_;
+                void (*destroy_)(void*);
+                void* object_;
+            };
+
+            template <typename T>
+            static void Destroy(void* object)
+            {
+                static_cast<T*>(object)->~T();
+            }
+
+            void RegisterCleanup(void* object, void (*destroy)(void*));
+            void* AllocateSlow(size_t size, size_t alignment);
+
+            static const size_t kInlineSize = 1024;
+            static const size_t kBlockSize = 4096;
+
+            alignas(std::max_align_t) unsigned char inline_[kInlineSize];
+            unsigned char* cursor_;
+            unsigned char* limit_;
+            Block* blocks_;
+            Cleanup* cleanups_;
+            size_t bytesAllocated_;
+    };
+
+    struct ArenaAllocationException : SicilyException
+    {
+        ArenaAllocationException() : SicilyException(_X("sicily ArenaAllocationException")) { }
+    };
+};
@@ -0,0 +1,88 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <mutex>
+#include <unordered_map>
+
+#include "CompiledSignatureCache.h"
+
+#include "Parser.h"
+#include "Scanner.h"
+
+namespace sicily {
+    namespace {
+        struct Cache
+        {
+            std::mutex mutex_;
+            std::unordered_map<xstring_t, CompiledSignaturePtr> tokens_;
+            std::unordered_map<xstring_t, CompiledSignaturePtr> bytes_;
+        };
+
+        Cache& GetCache()
+        {
+            static Cache cache;
+            return cache;
+        }
+
+        CompiledSignaturePtr Compile(const xstring_t& cil, bool token)
+        {
+            Scanner scanner(cil);
+            Parser parser;
+            auto type = parser.Parse(scanner);
+
+            codegen::SignatureCompiler compiler;
+            return std::make_shared<const codegen::CompiledSignature>(token ? compiler.CompileToken(type) : compiler.CompileBytes(type));
+        }
+
+        CompiledSignaturePtr Get(std::unordered_map<xstring_t, CompiledSignaturePtr>& entries, const xstring_t& cil, bool token)
+        {
+            Cache& cache = GetCache();
+            {
+                std::lock_guard<std::mutex> lock(cache.mutex_);
+                auto found = entries.find(cil);
+                if (found != entries.end()) {
+                    return found->second;
+                }
+            }
+
+            // compile outside the lock; if two threads race on the same string both
+            // results are equivalent and the first one in wins
+            auto compiled = Compile(cil, token);
+
+            std::lock_guard<std::mutex> lock(cache.mutex_);
+            if (cache.tokens_.size() + cache.bytes_.size() >= CompiledSignatureCache::kMaxEntries) {
+                return compiled;
+            }
+            return entries.insert(std::make_pair(cil, compiled)).first->second;
+        }
+    }
+
+    CompiledSignaturePtr
+    CompiledSignatureCache::GetToken(const xstring_t& cil)
+    {
+        return Get(GetCache().tokens_, cil, true);
+    }
+
+    CompiledSignaturePtr
+    CompiledSignatureCache::GetBytes(const xstring_t& cil)
+    {
+        return Get(GetCache().bytes_, cil, false);
+    }
+
+    size_t
+    CompiledSignatureCache::GetSize()
+    {
+        Cache& cache = GetCache();
+        std::lock_guard<std::mutex> lock(cache.mutex_);
+        return cache.tokens_.size() + cache.bytes_.size();
+    }
+
+    void
+    CompiledSignatureCache::Clear()
+    {
+        Cache& cache = GetCache();
+        std::lock_guard<std::mutex> lock(cache.mutex_);
+        cache.tokens_.clear();
+        cache.bytes_.clear();
+    }
+};
@@ -0,0 +1,36 @@
+/*
+* Copyright 2020 New Relic Corporation. All rights reserved.
+* SPDX-License-Identifier: Apache-2.0
+*/
+#pragma once
+#include <memory>
+#include "../Common/xplat.h"
+#include "codegen/CompiledSignature.h"
+
+namespace sicily {
+    typedef std::shared_ptr<const codegen::CompiledSignature> CompiledSignaturePtr;
+
+    //
+    // The CIL strings handed to sicily are almost all literals in the instrumentation
+    // code, and the same handful are parsed for every method in every module that gets
+    // instrumented.  This parses and encodes each distinct string once per process and
+    // keeps the result, so instrumenting a method only costs the tokenizer lookups.
+    // Parse errors are not cached; they are rethrown every time the string is asked for.
+    //
+    class CompiledSignatureCache
+    {
+        public:
+            // a string compiled for ByteCodeGenerator::TypeToToken
+            static CompiledSignaturePtr GetToken(const xstring_t& cil);
+            // a string compiled for ByteCodeGenerator::TypeToBytes
+            static CompiledSignaturePtr GetBytes(const xstring_t& cil);
+
+            // number of compiled strings currently held
+            static size_t GetSize();
+            static void Clear();
+
+            // strings built at run time could grow the cache without bound, past this
+            // many entries new strings are compiled every time instead of being kept
+            static const size_t kMaxEntries = 4096;
+    };
+};
@@ -59,7 +59,7 @@ namespace sicily {
         ast::TypePtr returnType = nullptr;
         ast::ClassTypePtr targetType = nullptr;
         SemInfo sem;
-        xstring_t name;
+        StringView name;
 
         returnType = ParseTypeSignature(scanner);
 
@@ -75,18 +75,18 @@ namespace sicily {
         {
             throw UnexpectedTypeKindException(tempTargetType->GetKind(), ast::Type::Kind::kCLASS);
         }
-        targetType = std::dynamic_pointer_cast<ast::ClassType, ast::Type>(tempTargetType);
+        targetType = static_cast<ast::ClassTypePtr>(tempTargetType);
 
         scanner.Expect(TOK_DOUBLECOLON);
 
         //
         // FULLSTOP to handle `.ctor` etc.
         //
-        if (scanner.Maybe(TOK_FULLSTOP)) {
-            name += _X(".");
+        if (scanner.Maybe(TOK_FULLSTOP, sem)) {
+            name = sem.text_;
         }
         scanner.Expect(TOK_ID, sem);
-        name += sem.id_;
+        name = Concat(name, sem.text_);
 
         if (scanner.Maybe(TOK_LT)) {
             genericTypes = ParseTypeList(scanner);
@@ -99,10 +99,10 @@ namespace sicily {
             scanner.Expect(TOK_RBRACKET);
         }
 
-        if (argTypes == nullptr) argTypes = std::make_shared<ast::TypeList>();
-        if (genericTypes == nullptr) genericTypes = std::make_shared<ast::TypeList>();
+        if (argTypes == nullptr) argTypes = arena_.Make<ast::TypeList>(arena_);
+        if (genericTypes == nullptr) genericTypes = arena_.Make<ast::TypeList>(arena_);
 
-        return std::make_shared<ast::MethodType>(ast::MethodType(targetType, name, returnType, instanceMethod, argTypes, genericTypes));
+        return arena_.Make<ast::MethodType>(targetType, name, returnType, instanceMethod, argTypes, genericTypes);
     }
 
     ast::TypePtr
@@ -114,19 +114,19 @@ namespace sicily {
 
         switch (type) {
             case TOK_OBJECT:
-                result = std::make_shared<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kOBJECT);
+                result = arena_.Make<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kOBJECT);
                 break;
             case TOK_VOID:
-                result = std::make_shared<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kVOID);
+                result = arena_.Make<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kVOID);
                 break;
             case TOK_BOOL:
-                result = std::make_shared<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kBOOL);
+                result = arena_.Make<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kBOOL);
                 break;
             case TOK_UINT32:
-                result = std::make_shared<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kU4);
+                result = arena_.Make<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kU4);
                 break;
             case TOK_STRING:
-                result = std::make_shared<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kSTRING);
+                result = arena_.Make<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kSTRING);
                 break;
             case TOK_CLASS:
                 result = ParseClassTypeSignature(scanner);
@@ -136,11 +136,11 @@ namespace sicily {
                 break;
             case TOK_BANG:
                 scanner.Expect(TOK_NUM, sem);
-                result = std::make_shared<ast::GenericParamType>(ast::GenericParamType::GenericParamKind::kTYPE, sem.num_);
+                result = arena_.Make<ast::GenericParamType>(ast::GenericParamType::GenericParamKind::kTYPE, sem.num_);
                 break;
             case TOK_DOUBLEBANG:
                 scanner.Expect(TOK_NUM, sem);
-                result = std::make_shared<ast::GenericParamType>(ast::GenericParamType::GenericParamKind::kMETHOD, sem.num_);
+                result = arena_.Make<ast::GenericParamType>(ast::GenericParamType::GenericParamKind::kMETHOD, sem.num_);
                 break;
             case TOK_LSQBRACKET:
             case TOK_ID:
@@ -152,14 +152,15 @@ namespace sicily {
                     result = ParseClassTypeSignature(scanner, true);
                 }
                 else {
-                    throw ExpectedTypeDescriptorException(sem.id_);
+                    throw ExpectedTypeDescriptorException(sem.text_.ToString());
                 }
                 break;
             default:
                 throw UnhandledTokenException(type);
         };
 
-        while (scanner.Maybe(TOK_LSQBRACKET)) {
+        SemInfo bracket;
+        while (scanner.Maybe(TOK_LSQBRACKET, bracket)) {
             //
             // `void [mscorlib]System.Bar` is incorrectly parsed
             // as `void[...` -> scanner needs to be a little smarter.
@@ -168,11 +169,11 @@ namespace sicily {
             //
             if (scanner.Maybe(TOK_ID, sem)) {
                 scanner.Unget(TOK_ID, sem);
-                scanner.Unget(TOK_LSQBRACKET, sem);
+                scanner.Unget(TOK_LSQBRACKET, bracket);
                 break;
             }
             scanner.Expect(TOK_RSQBRACKET);
-            result = std::make_shared<ast::ArrayType>(result);
+            result = arena_.Make<ast::ArrayType>(result);
         }
 
         return result;
@@ -181,8 +182,8 @@ namespace sicily {
     ast::ClassTypePtr
     Parser::ParseClassTypeSignature(Scanner &scanner, bool isRaw, ast::ClassType::ClassKind classKind)
     {
-        xstring_t assembly;
-        xstring_t name;
+        StringView assembly;
+        StringView name;
         ast::TypeListPtr genericTypes = nullptr;
 
         if (scanner.Maybe(TOK_LSQBRACKET)) {
@@ -193,10 +194,11 @@ namespace sicily {
 
         ParseQualifiedName(scanner, name);
 
-        while (scanner.Maybe(TOK_SLASH)) {
-            xstring_t nameExtra;
+        SemInfo slash;
+        while (scanner.Maybe(TOK_SLASH, slash)) {
+            StringView nameExtra;
             ParseQualifiedName(scanner, nameExtra);
-            name += _X("/") + nameExtra;
+            name = Concat(Concat(name, slash.text_), nameExtra);
         }
 
         if (scanner.Maybe(TOK_BACKTICK)) {
@@ -211,14 +213,14 @@ namespace sicily {
             }
         }
 
-        if (genericTypes == nullptr) return std::make_shared<ast::ClassType>(name, assembly, isRaw, classKind);
-        else return std::make_shared<ast::GenericType>(name, assembly, genericTypes, isRaw, classKind);
+        if (genericTypes == nullptr) return arena_.Make<ast::ClassType>(name, assembly, isRaw, classKind);
+        else return arena_.Make<ast::GenericType>(name, assembly, genericTypes, isRaw, classKind);
     }
 
     ast::TypeListPtr
     Parser::ParseTypeList(Scanner &scanner)
     {
-        auto types = std::make_shared<ast::TypeList>();
+        auto types = arena_.Make<ast::TypeList>(arena_);
         for (;;) {
             ast::TypePtr type = ParseTypeSignature(scanner);
             types->Add(type);
@@ -231,21 +233,39 @@ namespace sicily {
     }
 
     void
-    Parser::ParseQualifiedName(Scanner &scanner, xstring_t &name)
+    Parser::ParseQualifiedName(Scanner &scanner, StringView &name)
     {
         sicily::SemInfo sem;
-        name = xstring_t();
+        name = StringView();
 
         for (;;) {
             scanner.Expect(TOK_ID, sem);
 
-            name += sem.id_.c_str();
+            name = Concat(name, sem.text_);
 
-            if (!scanner.Maybe(TOK_FULLSTOP)) {
+            if (!scanner.Maybe(TOK_FULLSTOP, sem)) {
                 break;
             }
 
-            name += _X(".");
+            name = Concat(name, sem.text_);
         }
     }
+
+    StringView
+    Parser::Concat(const StringView &left, const StringView &right)
+    {
+        if (left.empty()) return right;
+        if (right.empty()) return left;
+
+        //
+        // names are almost always written without interior whitespace, in which case
+        // the pieces sit next to each other in the scanned string and can share it
+        //
+        if (left.end() == right.data()) {
+            return StringView(left.data(), left.size() + right.size());
+        }
+
+        xstring_t joined = left.ToString() + right.ToString();
+        return arena_.CopyString(joined.data(), joined.size());
+    }
 };
@@ -4,6 +4,7 @@
 */
 #pragma once
 #include <string>
+#include "Arena.h"
 #include "Exceptions.h"
 #include "Scanner.h"
 #include "ast/Types.h"
@@ -15,15 +16,25 @@ namespace sicily {
             Parser();
             ~Parser();
 
+            // The returned tree is allocated from this parser's arena and points into the
+            // scanned string.  It is released in one step when the parser is destroyed, so
+            // keep the parser (and the string) alive until bytecode has been generated.
             ast::TypePtr Parse(Scanner &scanner);
 
         private:
+            Parser(const Parser&) = delete;
+            Parser& operator=(const Parser&) = delete;
+
             ast::TypePtr ParseMethodSignature(Scanner &scanner, bool instanceMethod, bool methodRequired);
             ast::TypePtr ParseTypeSignature(Scanner &scanner, bool allowRawClassName=false);
             ast::ClassTypePtr ParseClassTypeSignature(Scanner &scanner, bool isRaw=false, ast::ClassType::ClassKind classKind=ast::ClassType::ClassKind::CLASS);
             ast::TypeListPtr ParseTypeList(Scanner &scanner);
             // throws an exception if a qualified name is not found
-            void ParseQualifiedName(Scanner &scanner, xstring_t &name);
+            void ParseQualifiedName(Scanner &scanner, StringView &name);
+            // joins two views, without copying when they are adjacent in the scanned string
+            StringView Concat(const StringView &left, const StringView &right);
+
+            Arena arena_;
     };
 
     struct UnexpectedEndTokenException : ParserException {};
@@ -10,28 +10,30 @@
 #include "Exceptions.h"
 
 namespace sicily {
+    Scanner::Scanner(const xchar_t* data, size_t length)
+        : tokencount_(0), data_(data), datalen_(length), pos_(0)
+    {
+    }
+
     Scanner::Scanner(const xstring_t& data)
-        : data_(nullptr), datalen_(data.size()), pos_(0)
+        : tokencount_(0), data_(data.data()), datalen_(data.size()), pos_(0)
     {
-        data_ = new xchar_t[data.size() + 1];
-        std::copy (data.begin(), data.end(), data_);
     }
 
     Scanner::~Scanner()
     {
-        delete[] data_;
     }
 
     TokenType
     Scanner::Peek(SemInfo &sem)
     {
-        if (tokenbuf_.empty()) {
+        if (tokencount_ == 0) {
             TokenType type = Next(sem);
             Unget(type, sem);
             return type;
         }
         else {
-            token t = tokenbuf_.back();
+            const token& t = tokenbuf_[tokencount_ - 1];
             sem = t.second;
             return t.first;
         }
@@ -81,18 +83,21 @@ namespace sicily {
     TokenType
     Scanner::Next(SemInfo &sem)
     {
-        if (tokenbuf_.size() > 0) {
-            token t = tokenbuf_.back();
-            tokenbuf_.pop_back();
+        if (tokencount_ > 0) {
+            const token& t = tokenbuf_[--tokencount_];
             sem = t.second;
             return t.first;
         }
 
         for (;;) {
             if (pos_ >= datalen_) {
+                sem.text_ = StringView(data_ + datalen_, 0);
                 return TOK_END;
             }
 
+            // every punctuation token is one character except `::` and `!!`, which widen this below
+            sem.text_ = StringView(data_ + pos_, 1);
+
             switch (data_[pos_]) {
                 case L'[':
                     {
@@ -125,6 +130,7 @@ namespace sicily {
                         }
                         else {
                             pos_++;
+                            sem.text_ = StringView(data_ + pos_ - 2, 2);
                             return TOK_DOUBLECOLON;
                         }
                     }
@@ -136,6 +142,7 @@ namespace sicily {
                         }
                         else {
                             pos_++;
+                            sem.text_ = StringView(data_ + pos_ - 2, 2);
                             return TOK_DOUBLEBANG;
                         }
                     }
@@ -194,7 +201,10 @@ namespace sicily {
     void
     Scanner::Unget(TokenType type, const SemInfo &sem)
     {
-        tokenbuf_.push_back(token(type, sem));
+        if (tokencount_ >= kMaxLookahead) {
+            throw LookaheadOverflowException();
+        }
+        tokenbuf_[tokencount_++] = token(type, sem);
     }
 
     TokenType
@@ -207,29 +217,29 @@ namespace sicily {
                  data_[pos_] == L'.')) {
             pos_++;
         }
-        sem.id_ = xstring_t(data_ + begin, pos_ - begin);
-        if (sem.id_ == _X("instance")) {
+        sem.text_ = StringView(data_ + begin, pos_ - begin);
+        if (sem.text_ == StringView(_X("instance"))) {
             return TOK_INSTANCE;
         }
-        else if (sem.id_ == _X("class")) {
+        else if (sem.text_ == StringView(_X("class"))) {
             return TOK_CLASS;
         }
-        else if (sem.id_ == _X("valuetype")) {
+        else if (sem.text_ == StringView(_X("valuetype"))) {
             return TOK_VALUETYPE;
         }
-        else if (sem.id_ == _X("object")) {
+        else if (sem.text_ == StringView(_X("object"))) {
             return TOK_OBJECT;
         }
-        else if (sem.id_ == _X("void")) {
+        else if (sem.text_ == StringView(_X("void"))) {
             return TOK_VOID;
         }
-        else if (sem.id_ == _X("bool")) {
+        else if (sem.text_ == StringView(_X("bool"))) {
             return TOK_BOOL;
         }
-        else if (sem.id_ == _X("string")) {
+        else if (sem.text_ == StringView(_X("string"))) {
             return TOK_STRING;
         }
-        else if (sem.id_ == _X("uint32")) {
+        else if (sem.text_ == StringView(_X("uint32"))) {
             return TOK_UINT32;
         }
         else {
@@ -240,12 +250,14 @@ namespace sicily {
     TokenType
     Scanner::ScanNum(SemInfo &sem)
     {
+        size_t begin = pos_;
         int value = 0;
         while (pos_ < datalen_ && std::isdigit(data_[pos_])) {
             value *= 10;
             value += (int)(data_[pos_] - (char)0x30);
             pos_++;
         }
+        sem.text_ = StringView(data_ + begin, pos_ - begin);
         sem.num_ = value;
         return TOK_NUM;
     }
@@ -5,8 +5,8 @@
 #pragma once
 #include <string>
 #include <iostream>
-#include <list>
 #include "Exceptions.h"
+#include "StringView.h"
 
 namespace sicily {
     enum TokenType {
@@ -39,18 +39,24 @@ namespace sicily {
     };
 
     struct SemInfo {
-        xstring_t id_;
+        SemInfo() : num_(0) {}
+
+        // the characters of the token, pointing into the scanned string
+        StringView text_;
         int         num_;
-        struct {
-            size_t pos_;
-            xstring_t message_;
-        } error_;
     };
 
+    //
+    // Scans a string in place; nothing is copied out of the input.  The string must
+    // therefore outlive the scanner and any AST parsed from it.
+    //
     class Scanner
     {
         public:
-            Scanner(const xstring_t& data);
+            Scanner(const xchar_t* data, size_t length);
+            explicit Scanner(const xstring_t& data);
+            // a temporary would be destroyed while the scanner still points into it
+            explicit Scanner(xstring_t&& data) = delete;
             ~Scanner();
 
             void Skip();
@@ -71,10 +77,13 @@ namespace sicily {
             TokenType ScanNum(SemInfo &sem);
 
             typedef std::pair<TokenType, SemInfo> token;
-            typedef std::list<token> tokenbuf;
 
-            tokenbuf tokenbuf_;
-            xchar_t *data_;
+            // the parser never pushes back more than a couple of tokens
+            static const size_t kMaxLookahead = 4;
+
+            token tokenbuf_[kMaxLookahead];
+            size_t tokencount_;
+            const xchar_t *data_;
             size_t datalen_;
             size_t pos_;
     };
@@ -91,6 +100,7 @@ namespace sicily {
         UnhandledCharacterException(xchar_t found) : found_(found) {}
         xchar_t found_;
     };
+    struct LookaheadOverflowException : ScannerException {};
     struct UnexpectedTokenException : ScannerException
     {
         UnexpectedTokenException(TokenType expected, TokenType found) : expected_(expected), found_(found) {}
@@ -5,3 +5,4 @@
 #pragma once
 #include "Parser.h"
 #include "codegen/ByteCodeGenerator.h"
+#include "CompiledSignatureCache.h"
@@ -0,0 +1,78 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <CppUnitTest.h>
+#include "UnreferencedFunctions.h"
+
+#include "../Arena.h"
+#include "../ast/Types.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace sicily
+{
+    namespace Test
+    {
+        TEST_CLASS(ArenaTest)
+        {
+        private:
+            struct CountsDestruction
+            {
+                CountsDestruction(int& destroyed) : destroyed_(destroyed) {}
+                ~CountsDestruction() { ++destroyed_; }
+                int& destroyed_;
+            };
+
+        public:
+            TEST_METHOD(TestAllocationsAreAligned)
+            {
+                Arena arena;
+                arena.Allocate(1, 1);
+                auto pointer = arena.Allocate(sizeof(uint64_t), alignof(uint64_t));
+                Assert::AreEqual(size_t(0), reinterpret_cast<uintptr_t>(pointer) % alignof(uint64_t));
+            }
+
+            TEST_METHOD(TestAllocationsLargerThanABlock)
+            {
+                Arena arena;
+                auto bytes = static_cast<uint8_t*>(arena.Allocate(64 * 1024, 1));
+                bytes[64 * 1024 - 1] = 0xff;
+                Assert::AreEqual(size_t(64 * 1024), arena.GetBytesAllocated());
+            }
+
+            TEST_METHOD(TestResetRunsDestructors)
+            {
+                int destroyed = 0;
+                Arena arena;
+                arena.Make<CountsDestruction>(destroyed);
+                arena.Make<CountsDestruction>(destroyed);
+                arena.Reset();
+                Assert::AreEqual(2, destroyed);
+                Assert::AreEqual(size_t(0), arena.GetBytesAllocated());
+            }
+
+            TEST_METHOD(TestCopyStringOutlivesSource)
+            {
+                Arena arena;
+                StringView copy;
+                {
+                    std::wstring source(L"MyNamespace.MyClass");
+                    copy = arena.CopyString(source.data(), source.size());
+                }
+                Assert::AreEqual(std::wstring(L"MyNamespace.MyClass"), copy.ToString());
+            }
+
+            TEST_METHOD(TestTypeListGrowsPastInitialCapacity)
+            {
+                Arena arena;
+                auto list = arena.Make<ast::TypeList>(arena);
+                for (int i = 0; i < 100; ++i)
+                {
+                    list->Add(arena.Make<ast::GenericParamType>(ast::GenericParamType::GenericParamKind::kTYPE, i));
+                }
+                Assert::AreEqual(uint16_t(100), list->GetSize());
+                Assert::AreEqual(std::wstring(L"!99"), list->GetItem(99)->ToString());
+            }
+        };
+    }
+}
@@ -18,52 +18,55 @@ namespace sicily
         {
             TEST_CLASS(ArrayTypeTest)
             {
+            private:
+                Arena arena;
+
             public:
                 TEST_METHOD(TestGetKind)
                 {
-                    PrimitiveTypePtr primitiveType(new PrimitiveType(PrimitiveType::PrimitiveKind::kBOOL));
-                    std::unique_ptr<ArrayType> arrayType(new ArrayType(primitiveType));
+                    PrimitiveTypePtr primitiveType = arena.Make<PrimitiveType>(PrimitiveType::PrimitiveKind::kBOOL);
+                    ArrayTypePtr arrayType = arena.Make<ArrayType>(primitiveType);
                     Assert::AreEqual(Type::Kind::kARRAY, arrayType->GetKind());
                 }
 
                 TEST_METHOD(TestGetElementKind)
                 {
-                    PrimitiveTypePtr primitiveType(new PrimitiveType(PrimitiveType::PrimitiveKind::kBOOL));
-                    std::unique_ptr<ArrayType> arrayType(new ArrayType(primitiveType));
+                    PrimitiveTypePtr primitiveType = arena.Make<PrimitiveType>(PrimitiveType::PrimitiveKind::kBOOL);
+                    ArrayTypePtr arrayType = arena.Make<ArrayType>(primitiveType);
                     Assert::AreEqual(Type::Kind::kPRIMITIVE, arrayType->GetElementType()->GetKind());
                 }
 
                 TEST_METHOD(TestGetElement)
                 {
-                    PrimitiveTypePtr primitiveType(new PrimitiveType(PrimitiveType::PrimitiveKind::kBOOL));
-                    std::unique_ptr<ArrayType> arrayType(new ArrayType(primitiveType));
-                    PrimitiveTypePtr elementType = std::static_pointer_cast<PrimitiveType, Type>(arrayType->GetElementType());
+                    PrimitiveTypePtr primitiveType = arena.Make<PrimitiveType>(PrimitiveType::PrimitiveKind::kBOOL);
+                    ArrayTypePtr arrayType = arena.Make<ArrayType>(primitiveType);
+                    PrimitiveTypePtr elementType = static_cast<PrimitiveTypePtr>(arrayType->GetElementType());
                     Assert::AreEqual(PrimitiveType::PrimitiveKind::kBOOL, elementType->GetPrimitiveKind());
                 }
 
                 TEST_METHOD(TestPrimitiveArrayToString)
                 {
-                    PrimitiveTypePtr primitiveType(new PrimitiveType(PrimitiveType::PrimitiveKind::kBOOL));
-                    std::unique_ptr<ArrayType> arrayType(new ArrayType(primitiveType));
+                    PrimitiveTypePtr primitiveType = arena.Make<PrimitiveType>(PrimitiveType::PrimitiveKind::kBOOL);
+                    ArrayTypePtr arrayType = arena.Make<ArrayType>(primitiveType);
                     Assert::AreEqual(std::wstring(L"bool[]"), arrayType->ToString());
                 }
 
                 TEST_METHOD(TestClassArrayToString)
                 {
-                    ClassTypePtr classType(new ClassType(L"Foo", L"bar"));
-                    std::unique_ptr<ArrayType> arrayType(new ArrayType(classType));
+                    ClassTypePtr classType = arena.Make<ClassType>(L"Foo", L"bar");
+                    ArrayTypePtr arrayType = arena.Make<ArrayType>(classType);
                     Assert::AreEqual(std::wstring(L"class [bar]Foo[]"), arrayType->ToString());
                 }
 
                 TEST_METHOD(TestGenericArrayToString)
                 {
-                    TypeListPtr typeList(new TypeList());
-                    PrimitiveTypePtr primitiveType(new PrimitiveType(PrimitiveType::PrimitiveKind::kBOOL));
-                    ClassTypePtr classType(new ClassType(L"Baz", L"bar"));
+                    TypeListPtr typeList = arena.Make<TypeList>(arena);
+                    PrimitiveTypePtr primitiveType = arena.Make<PrimitiveType>(PrimitiveType::PrimitiveKind::kBOOL);
+                    ClassTypePtr classType = arena.Make<ClassType>(L"Baz", L"bar");
                     typeList->Add(primitiveType);
                     typeList->Add(classType);
-                    GenericTypePtr genericType(new GenericType(L"Foo", L"bar", typeList));
-                    ArrayTypePtr arrayType(new ArrayType(genericType));
+                    GenericTypePtr genericType = arena.Make<GenericType>(L"Foo", L"bar", typeList);
+                    ArrayTypePtr arrayType = arena.Make<ArrayType>(genericType);
                     Assert::AreEqual(std::wstring(L"class [bar]Foo`2<bool, class [bar]Baz>[]"), arrayType->ToString());
                 }
             };
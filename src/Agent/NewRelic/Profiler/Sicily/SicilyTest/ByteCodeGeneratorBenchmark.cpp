@@ -0,0 +1,144 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <CppUnitTest.h>
+#include "UnreferencedFunctions.h"
+
+#include <chrono>
+#include <sstream>
+#include "NullTokenizer.h"
+#include "TestTemplates.h"
+#include "../CompiledSignatureCache.h"
+#include "../Parser.h"
+#include "../Scanner.h"
+#include "../codegen/ByteCodeGenerator.h"
+#include "../ast/Types.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace sicily
+{
+    namespace codegen
+    {
+        namespace Test
+        {
+            //
+            // The ByteCodeGeneratorTest cases run in a loop, reporting throughput to the test
+            // log.  Nothing is asserted about timing; compare the logged numbers across builds.
+            //
+            TEST_CLASS(ByteCodeGeneratorBenchmark)
+            {
+            private:
+                static const int kIterations = 100000;
+
+                Arena arena;
+                NullTokenizerPtr tokenizer = NullTokenizerPtr(new NullTokenizer());
+
+                template <typename Function>
+                static void Measure(const wchar_t* name, Function function)
+                {
+                    size_t checksum = 0;
+                    auto start = std::chrono::steady_clock::now();
+                    for (int i = 0; i < kIterations; ++i)
+                    {
+                        checksum += function();
+                    }
+                    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+                    std::wostringstream message;
+                    message << name << L": " << (elapsed / kIterations) << L" ns/op, "
+                        << (elapsed == 0 ? 0 : (long long)(kIterations * 1000000000.0 / elapsed)) << L" ops/s";
+                    Logger::WriteMessage(message.str().c_str());
+                    // keeps the optimizer from throwing the work away
+                    Assert::AreNotEqual(size_t(0), checksum);
+                }
+
+                void MeasureBytes(const wchar_t* name, ast::TypePtr type)
+                {
+                    ByteCodeGenerator generator(tokenizer);
+                    Measure(name, [&]() { return generator.TypeToBytes(type).size(); });
+                }
+
+                ast::GenericTypePtr MakeGenericType()
+                {
+                    ast::ArrayTypePtr objectArrayType = arena.Make<ast::ArrayType>(arena.Make<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kOBJECT));
+                    ast::TypeListPtr genericParamTypes = arena.Make<ast::TypeList>(arena);
+                    genericParamTypes->Add(objectArrayType);
+                    return arena.Make<ast::GenericType>(L"MyClass", L"MyAssembly", genericParamTypes);
+                }
+
+                ast::MethodTypePtr MakeMethodType()
+                {
+                    ast::ClassTypePtr targetType = arena.Make<ast::ClassType>(L"MyClass", L"MyAssembly");
+                    ast::PrimitiveTypePtr returnType = arena.Make<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kVOID);
+                    ast::TypeListPtr argTypes = arena.Make<ast::TypeList>(arena);
+                    argTypes->Add(arena.Make<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kBOOL));
+                    ast::TypeListPtr genericTypes = arena.Make<ast::TypeList>(arena);
+                    genericTypes->Add(arena.Make<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kOBJECT));
+                    return arena.Make<ast::MethodType>(targetType, L"MyMethod", returnType, true, argTypes, genericTypes);
+                }
+
+            public:
+                TEST_METHOD(BenchmarkPrimitiveTypeToBytes)
+                {
+                    MeasureBytes(L"primitive", arena.Make<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kI4));
+                }
+
+                TEST_METHOD(BenchmarkArrayTypeToBytes)
+                {
+                    MeasureBytes(L"array", arena.Make<ast::ArrayType>(arena.Make<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kBOOL)));
+                }
+
+                TEST_METHOD(BenchmarkClassTypeToBytes)
+                {
+                    MeasureBytes(L"class", arena.Make<ast::ClassType>(L"MyClass", L"MyAssembly"));
+                }
+
+                TEST_METHOD(BenchmarkGenericTypeToBytes)
+                {
+                    MeasureBytes(L"generic class", MakeGenericType());
+                }
+
+                TEST_METHOD(BenchmarkMethodTypeToBytes)
+                {
+                    MeasureBytes(L"method", MakeMethodType());
+                }
+
+                TEST_METHOD(BenchmarkGenericMethodInstantiationToSignature)
+                {
+                    auto type = MakeMethodType();
+                    ByteCodeGenerator generator(tokenizer);
+                    Measure(L"method instantiation", [&]() { return generator.GenericMethodInstantiationToSignature(type).size(); });
+                }
+
+                TEST_METHOD(BenchmarkGenericClassInstantiationToSignature)
+                {
+                    auto type = MakeGenericType();
+                    ByteCodeGenerator generator(tokenizer);
+                    Measure(L"class instantiation", [&]() { return generator.GenericClassInstantiationToSignature(type).size(); });
+                }
+
+                TEST_METHOD(BenchmarkParseAndTokenizeMethodString)
+                {
+                    std::wstring cil(L"class [mscorlib]System.Tuple`2<!!0,!!1> [mscorlib]System.Tuple::Create<class [mscorlib]System.Action`1<object[]>,class [mscorlib]System.Action`1<object[]>>(!!0, !!1)");
+                    Measure(L"parse and tokenize", [&]()
+                    {
+                        Scanner scanner(cil);
+                        Parser parser;
+                        ByteCodeGenerator generator(tokenizer);
+                        return size_t(generator.TypeToToken(parser.Parse(scanner)) + 1);
+                    });
+                }
+
+                TEST_METHOD(BenchmarkCachedTokenizeMethodString)
+                {
+                    std::wstring cil(L"class [mscorlib]System.Tuple`2<!!0,!!1> [mscorlib]System.Tuple::Create<class [mscorlib]System.Action`1<object[]>,class [mscorlib]System.Action`1<object[]>>(!!0, !!1)");
+                    Measure(L"cached tokenize", [&]()
+                    {
+                        return size_t(CompiledSignatureCache::GetToken(cil)->ResolveToken(*tokenizer) + 1);
+                    });
+                }
+            };
+        }
+    }
+}
@@ -24,6 +24,8 @@ namespace sicily
             TEST_CLASS(ByteCodeGeneratorTest)
             {
             private:
+                Arena arena;
+
                 ByteCodeGenerator CreateBadFoodByteCodeGenerator()
                 {
                     NullTokenizerPtr tokenizer(new NullTokenizer());
@@ -32,7 +34,7 @@ namespace sicily
 
                 void TestPrimitive(ast::PrimitiveType::PrimitiveKind kind, unsigned char expectedByte)
                 {
-                    ast::TypePtr type(new ast::PrimitiveType(kind));
+                    ast::TypePtr type = arena.Make<ast::PrimitiveType>(kind);
                     ByteVector actualBytes = CreateBadFoodByteCodeGenerator().TypeToBytes(type);
                     BYTEVECTOR(expectedBytes, {expectedByte});
                     Assert::AreEqual(expectedBytes, actualBytes);
@@ -116,8 +118,8 @@ namespace sicily
 
                 TEST_METHOD(TestArrayTypeToBytes)
                 {
-                    ast::TypePtr innerType(new ast::PrimitiveType(PrimitiveType::PrimitiveKind::kBOOL));
-                    ast::TypePtr type(new ast::ArrayType(innerType));
+                    ast::TypePtr innerType = arena.Make<ast::PrimitiveType>(PrimitiveType::PrimitiveKind::kBOOL);
+                    ast::TypePtr type = arena.Make<ast::ArrayType>(innerType);
                     ByteVector actualBytes = CreateBadFoodByteCodeGenerator().TypeToBytes(type);
                     // bool[] == 0x1d 0x02
                     BYTEVECTOR(expectedBytes, 0x1d, 0x02);
@@ -126,7 +128,7 @@ namespace sicily
 
                 TEST_METHOD(TestClassTypeToBytes)
                 {
-                    ast::TypePtr type(new ast::ClassType(L"MyClass", L"MyAssembly"));
+                    ast::TypePtr type = arena.Make<ast::ClassType>(L"MyClass", L"MyAssembly");
                     ByteVector actualBytes = CreateBadFoodByteCodeGenerator().TypeToBytes(type);
                     // class <token> == 0x12 <compressed 0> == 0x12 0x00
                     BYTEVECTOR(expectedBytes, 0x12, 0x00);
@@ -135,11 +137,11 @@ namespace sicily
 
                 TEST_METHOD(TestGenericTypeToBytes)
                 {
-                    ast::PrimitiveTypePtr objectType(new ast::PrimitiveType(PrimitiveType::PrimitiveKind::kOBJECT));
-                    ast::ArrayTypePtr objectArrayType(new ast::ArrayType(objectType));
-                    ast::TypeListPtr genericParamTypes(new ast::TypeList());
+                    ast::PrimitiveTypePtr objectType = arena.Make<ast::PrimitiveType>(PrimitiveType::PrimitiveKind::kOBJECT);
+                    ast::ArrayTypePtr objectArrayType = arena.Make<ast::ArrayType>(objectType);
+                    ast::TypeListPtr genericParamTypes = arena.Make<ast::TypeList>(arena);
                     genericParamTypes->Add(objectArrayType);
-                    ast::TypePtr type(new ast::GenericType(L"MyClass", L"MyAssembly", genericParamTypes));
+                    ast::TypePtr type = arena.Make<ast::GenericType>(L"MyClass", L"MyAssembly", genericParamTypes);
 
                     auto actualBytes = CreateBadFoodByteCodeGenerator().TypeToBytes(type);
                     // genericinst <type> <type-arg-count> <type*> == 0x15 class <compressed token> 0x01 <object[]> == 0x15 0x12 0xc2af37bc 0x01 0x1d 0x1c
@@ -149,15 +151,15 @@ namespace sicily
 
                 TEST_METHOD(TestMethodTypeToBytes)
                 {
-                    ast::ClassTypePtr targetType(new ast::ClassType(L"MyClass", L"MyAssembly"));
-                    ast::PrimitiveTypePtr returnType(new ast::PrimitiveType(PrimitiveType::PrimitiveKind::kVOID));
-                    ast::TypeListPtr argTypes(new ast::TypeList());
-                    ast::PrimitiveTypePtr arg1Type(new ast::PrimitiveType(ast::PrimitiveType::PrimitiveKind::kBOOL));
+                    ast::ClassTypePtr targetType = arena.Make<ast::ClassType>(L"MyClass", L"MyAssembly");
+                    ast::PrimitiveTypePtr returnType = arena.Make<ast::PrimitiveType>(PrimitiveType::PrimitiveKind::kVOID);
+                    ast::TypeListPtr argTypes = arena.Make<ast::TypeList>(arena);
+                    ast::PrimitiveTypePtr arg1Type = arena.Make<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kBOOL);
                     argTypes->Add(arg1Type);
-                    ast::TypeListPtr genericTypes(new ast::TypeList());
-                    ast::PrimitiveTypePtr generic1Type(new ast::PrimitiveType(ast::PrimitiveType::PrimitiveKind::kOBJECT));
+                    ast::TypeListPtr genericTypes = arena.Make<ast::TypeList>(arena);
+                    ast::PrimitiveTypePtr generic1Type = arena.Make<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kOBJECT);
                     genericTypes->Add(generic1Type);
-                    ast::TypePtr type(new ast::MethodType(targetType, L"MyMethod", returnType, true, argTypes, genericTypes));
+                    ast::TypePtr type = arena.Make<ast::MethodType>(targetType, L"MyMethod", returnType, true, argTypes, genericTypes);
 
                     auto actualBytes = CreateBadFoodByteCodeGenerator().TypeToBytes(type);
                     // HASTHIS GENERIC GenParamCount ParamCount RetType Param*
@@ -168,15 +170,15 @@ namespace sicily
 
                 TEST_METHOD(TestGenericMethodInstantiationToSignature)
                 {
-                    ast::ClassTypePtr targetType(new ast::ClassType(L"MyClass", L"MyAssembly"));
-                    ast::PrimitiveTypePtr returnType(new ast::PrimitiveType(PrimitiveType::PrimitiveKind::kVOID));
-                    ast::TypeListPtr argTypes(new ast::TypeList());
-                    ast::PrimitiveTypePtr arg1Type(new ast::PrimitiveType(ast::PrimitiveType::PrimitiveKind::kBOOL));
+                    ast::ClassTypePtr targetType = arena.Make<ast::ClassType>(L"MyClass", L"MyAssembly");
+                    ast::PrimitiveTypePtr returnType = arena.Make<ast::PrimitiveType>(PrimitiveType::PrimitiveKind::kVOID);
+                    ast::TypeListPtr argTypes = arena.Make<ast::TypeList>(arena);
+                    ast::PrimitiveTypePtr arg1Type = arena.Make<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kBOOL);
                     argTypes->Add(arg1Type);
-                    ast::TypeListPtr genericTypes(new ast::TypeList());
-                    ast::PrimitiveTypePtr generic1Type(new ast::PrimitiveType(ast::PrimitiveType::PrimitiveKind::kOBJECT));
+                    ast::TypeListPtr genericTypes = arena.Make<ast::TypeList>(arena);
+                    ast::PrimitiveTypePtr generic1Type = arena.Make<ast::PrimitiveType>(ast::PrimitiveType::PrimitiveKind::kOBJECT);
                     genericTypes->Add(generic1Type);
-                    ast::MethodTypePtr type(new ast::MethodType(targetType, L"MyMethod", returnType, true, argTypes, genericTypes));
+                    ast::MethodTypePtr type = arena.Make<ast::MethodType>(targetType, L"MyMethod", returnType, true, argTypes, genericTypes);
 
                     auto actualBytes = CreateBadFoodByteCodeGenerator().GenericMethodInstantiationToSignature(type);
                     // GENERICINST GenArgCount Type+
@@ -187,11 +189,11 @@ namespace sicily
 
                 TEST_METHOD(TestGenericClassInstantiationToSignature)
                 {
-                    ast::PrimitiveTypePtr objectType(new ast::PrimitiveType(PrimitiveType::PrimitiveKind::kOBJECT));
-                    ast::ArrayTypePtr objectArrayType(new ast::ArrayType(objectType));
-                    ast::TypeListPtr genericParamTypes(new ast::TypeList());
+                    ast::PrimitiveTypePtr objectType = arena.Make<ast::PrimitiveType>(PrimitiveType::PrimitiveKind::kOBJECT);
+                    ast::ArrayTypePtr objectArrayType = arena.Make<ast::ArrayType>(objectType);
+                    ast::TypeListPtr genericParamTypes = arena.Make<ast::TypeList>(arena);
                     genericParamTypes->Add(objectArrayType);
-                    ast::GenericTypePtr type(new ast::GenericType(L"MyClass", L"MyAssembly", genericParamTypes));
+                    ast::GenericTypePtr type = arena.Make<ast::GenericType>(L"MyClass", L"MyAssembly", genericParamTypes);
 
                     auto actualBytes = CreateBadFoodByteCodeGenerator().GenericClassInstantiationToSignature(type);
                     // GENERICINST CLASS TypeDefOrRefOrSpecEncoded GenArgCount Type+
@@ -5,6 +5,7 @@
 #include "UnreferencedFunctions.h"
 
 #include "../ast/ClassType.h"
+#include "../Arena.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -16,29 +17,32 @@ namespace sicily
         {
             TEST_CLASS(ClassTypeTest)
             {
+            private:
+                Arena arena;
+
             public:
         
                 TEST_METHOD(TestGetKind)
                 {
-                    ClassTypePtr classType(new ClassType(L"Foo", L"bar"));
+                    ClassTypePtr classType = arena.Make<ClassType>(L"Foo", L"bar");
                     Assert::IsTrue(classType->GetKind() == Type::Kind::kCLASS);
                 }
 
                 TEST_METHOD(TestGetAssembly)
                 {
-                    ClassTypePtr classType(new ClassType(L"Foo", L"bar"));
+                    ClassTypePtr classType = arena.Make<ClassType>(L"Foo", L"bar");
                     Assert::AreEqual(std::wstring(L"bar"), classType->GetAssembly());
                 }
 
                 TEST_METHOD(TestGetName)
                 {
-                    ClassTypePtr classType(new ClassType(L"Foo", L"bar"));
+                    ClassTypePtr classType = arena.Make<ClassType>(L"Foo", L"bar");
                     Assert::AreEqual(std::wstring(L"Foo"), classType->GetName());
                 }
 
                 TEST_METHOD(TestToString)
                 {
-                    ClassTypePtr classType(new ClassType(L"Foo", L"bar"));
+                    ClassTypePtr classType = arena.Make<ClassType>(L"Foo", L"bar");
                     Assert::AreEqual(std::wstring(L"class [bar]Foo"), classType->ToString());
                 }
             };
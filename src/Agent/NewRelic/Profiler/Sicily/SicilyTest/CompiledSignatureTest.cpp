@@ -0,0 +1,126 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <CppUnitTest.h>
+#include "UnreferencedFunctions.h"
+
+#include "../CompiledSignatureCache.h"
+#include "../Parser.h"
+#include "../Scanner.h"
+#include "../codegen/ByteCodeGenerator.h"
+#include "RealisticTokenizer.h"
+#include "TestTemplates.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace sicily
+{
+    namespace codegen
+    {
+        namespace Test
+        {
+            TEST_CLASS(CompiledSignatureTest)
+            {
+            private:
+                static ByteVector GenerateBytes(const std::wstring& cil, ITokenizerPtr tokenizer)
+                {
+                    Scanner scanner(cil);
+                    Parser parser;
+                    ByteCodeGenerator generator(tokenizer);
+                    return generator.TypeToBytes(parser.Parse(scanner));
+                }
+
+                static uint32_t GenerateToken(const std::wstring& cil, ITokenizerPtr tokenizer)
+                {
+                    Scanner scanner(cil);
+                    Parser parser;
+                    ByteCodeGenerator generator(tokenizer);
+                    return generator.TypeToToken(parser.Parse(scanner));
+                }
+
+            public:
+                TEST_METHOD(TestCompiledBytesMatchGeneratedBytes)
+                {
+                    std::wstring cil(L"class [mscorlib]System.Tuple`2<!!0,!!1> [mscorlib]System.Tuple::Create<class [mscorlib]System.Action`1<object[]>,class [mscorlib]System.Action`1<object[]>>(!!0, !!1, valuetype [mscorlib]System.Guid, uint32[], !0)");
+                    RealisticTokenizerPtr generated(new RealisticTokenizer());
+                    RealisticTokenizerPtr compiled(new RealisticTokenizer());
+
+                    auto expected = GenerateBytes(cil, generated);
+                    auto actual = CompiledSignatureCache::GetBytes(cil)->ResolveBytes(*compiled);
+
+                    Assert::AreEqual(expected, actual);
+                }
+
+                TEST_METHOD(TestCompiledTokenMatchesGeneratedToken)
+                {
+                    std::wstring cil(L"class [mscorlib]System.Tuple`2<!!0,!!1> [mscorlib]System.Tuple::Create<class [mscorlib]System.Action`1<object[]>,class [mscorlib]System.Action`1<object[]>>(!!0, !!1)");
+                    RealisticTokenizerPtr generated(new RealisticTokenizer());
+                    RealisticTokenizerPtr compiled(new RealisticTokenizer());
+
+                    auto expected = GenerateToken(cil, generated);
+                    auto actual = CompiledSignatureCache::GetToken(cil)->ResolveToken(*compiled);
+
+                    Assert::AreEqual(expected, actual);
+                    Assert::AreEqual(std::get<1>(generated->GetMethodSpec(expected)), std::get<1>(compiled->GetMethodSpec(actual)));
+                }
+
+                TEST_METHOD(TestCompiledSignatureResolvesAgainstEachTokenizer)
+                {
+                    // the same compiled string must pick up each module's own tokens
+                    std::wstring cil(L"class [mscorlib]System.Object");
+                    auto compiled = CompiledSignatureCache::GetBytes(cil);
+                    RealisticTokenizerPtr fresh(new RealisticTokenizer());
+                    RealisticTokenizerPtr padded(new RealisticTokenizer());
+                    for (int i = 0; i < 100; ++i)
+                    {
+                        padded->GetTypeDefToken(L"Padding.Type" + std::to_wstring(i));
+                        padded->GetTypeRefToken(L"mscorlib", L"Padding.Type" + std::to_wstring(i));
+                    }
+
+                    auto freshBytes = compiled->ResolveBytes(*fresh);
+                    auto paddedBytes = compiled->ResolveBytes(*padded);
+
+                    Assert::AreEqual(GenerateBytes(cil, RealisticTokenizerPtr(new RealisticTokenizer())), freshBytes);
+                    // the compressed token grows past one byte once the table is big enough
+                    Assert::AreEqual(size_t(2), freshBytes.size());
+                    Assert::AreEqual(size_t(3), paddedBytes.size());
+                }
+
+                TEST_METHOD(TestRepeatedTypesAreRequestedOnce)
+                {
+                    auto compiled = CompiledSignatureCache::GetBytes(L"void [MyAssembly]MyClass::MyMethod(class [MyAssembly]Foo, class [MyAssembly]Foo, class [MyAssembly]Foo)");
+                    Assert::AreEqual(size_t(1), compiled->GetRequestCount());
+                }
+
+                TEST_METHOD(TestCacheReturnsTheSameCompiledSignature)
+                {
+                    std::wstring cil(L"void [MyAssembly]MyNamespace.MyClass::MyMethod(uint32)");
+                    auto first = CompiledSignatureCache::GetToken(cil);
+                    auto second = CompiledSignatureCache::GetToken(cil);
+                    Assert::IsTrue(first == second);
+
+                    // bytes and tokens are compiled differently so they are kept apart
+                    auto bytes = CompiledSignatureCache::GetBytes(cil);
+                    Assert::IsFalse(first == bytes);
+                }
+
+                TEST_METHOD(TestParseErrorsAreNotCached)
+                {
+                    auto size = CompiledSignatureCache::GetSize();
+                    for (int i = 0; i < 2; ++i)
+                    {
+                        try
+                        {
+                            CompiledSignatureCache::GetToken(L"void [MyAssembly]MyClass::MyMethod(");
+                            Assert::Fail(L"Expected a parse exception");
+                        }
+                        catch (const SicilyException&)
+                        {
+                        }
+                    }
+                    Assert::AreEqual(size, CompiledSignatureCache::GetSize());
+                }
+            };
+        }
+    }
+}
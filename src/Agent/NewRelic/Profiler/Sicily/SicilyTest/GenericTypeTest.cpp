@@ -59,14 +59,16 @@ namespace sicily
                 }
 
             private:
+                Arena arena;
+
                 GenericTypePtr CreateGenericType()
                 {
-                    PrimitiveTypePtr primitiveType(new PrimitiveType(PrimitiveType::PrimitiveKind::kBOOL));
-                    ClassTypePtr classType(new ClassType(L"Faz", L"bar"));
-                    TypeListPtr typeList(new TypeList());
+                    PrimitiveTypePtr primitiveType = arena.Make<PrimitiveType>(PrimitiveType::PrimitiveKind::kBOOL);
+                    ClassTypePtr classType = arena.Make<ClassType>(L"Faz", L"bar");
+                    TypeListPtr typeList = arena.Make<TypeList>(arena);
                     typeList->Add(primitiveType);
                     typeList->Add(classType);
-                    GenericTypePtr genericType(new GenericType(L"Foo", L"bar", typeList));
+                    GenericTypePtr genericType = arena.Make<GenericType>(L"Foo", L"bar", typeList);
                     return genericType;
                 }
             };
@@ -20,97 +20,99 @@ namespace sicily
             public:
                 TEST_METHOD(TestGetKind)
                 {
-                    MethodTypePtr methodType = CreateSimpleMethodType();
+                    MethodTypePtr methodType = CreateSimpleMethodType(arena);
                     Assert::AreEqual(Type::Kind::kMETHOD, methodType->GetKind());
                 }
 
                 TEST_METHOD(TestGetMethodName)
                 {
-                    MethodTypePtr methodType = CreateSimpleMethodType();
+                    MethodTypePtr methodType = CreateSimpleMethodType(arena);
                     Assert::AreEqual(std::wstring(L"MyMethod"), methodType->GetMethodName());
                 }
 
                 TEST_METHOD(TestGetTargetType)
                 {
-                    MethodTypePtr methodType = CreateSimpleMethodType();
+                    MethodTypePtr methodType = CreateSimpleMethodType(arena);
                     Assert::AreEqual(std::wstring(L"class [MyAssembly]MyClass"), methodType->GetTargetType()->ToString());
                 }
 
                 TEST_METHOD(TestGetParameterCount)
                 {
-                    MethodTypePtr methodType = CreateSimpleMethodType();
+                    MethodTypePtr methodType = CreateSimpleMethodType(arena);
                     Assert::AreEqual(uint16_t(2), methodType->GetArgTypes()->GetSize());
                 }
 
                 TEST_METHOD(TestGetGenericCount)
                 {
-                    MethodTypePtr methodType = CreateComplexMethodType();
+                    MethodTypePtr methodType = CreateComplexMethodType(arena);
                     Assert::AreEqual(uint16_t(1), methodType->GetGenericTypes()->GetSize());
                 }
 
                 TEST_METHOD(TestToString)
                 {
-                    MethodTypePtr methodType = CreateComplexMethodType();
+                    MethodTypePtr methodType = CreateComplexMethodType(arena);
                     Assert::AreEqual(std::wstring(L"instance class [MyAssembly]MyGenericReturnClass`2<object[], string> class [MyAssembly]MyClass`1<unsigned int64[]>::MyMethod<class [MyAssembly]MyGenericClass`1<class [MyAssembly]MyNestedGenericClass`1<bool[]>>>(object, bool)"), methodType->ToString());
                 }
 
                 TEST_METHOD(TestIsInstanceMethod)
                 {
-                    MethodTypePtr nonInstanceMethodType = CreateSimpleMethodType();
+                    MethodTypePtr nonInstanceMethodType = CreateSimpleMethodType(arena);
                     Assert::IsFalse(nonInstanceMethodType->IsInstanceMethod());
 
-                    MethodTypePtr instanceMethodType = CreateComplexMethodType();
+                    MethodTypePtr instanceMethodType = CreateComplexMethodType(arena);
                     Assert::IsTrue(instanceMethodType->IsInstanceMethod());
                 }
 
             private:
-                static MethodTypePtr CreateSimpleMethodType()
+                Arena arena;
+
+                static MethodTypePtr CreateSimpleMethodType(Arena& arena)
                 {
-                    ClassTypePtr targetType(new ClassType(L"MyClass", L"MyAssembly"));
-                    TypePtr returnType(new PrimitiveType(PrimitiveType::PrimitiveKind::kSTRING));
-                    TypePtr parameterType1(new PrimitiveType(PrimitiveType::PrimitiveKind::kOBJECT));
-                    TypePtr parameterType2(new PrimitiveType(PrimitiveType::PrimitiveKind::kBOOL));
-                    TypeListPtr parameterTypes(new TypeList());
+                    ClassTypePtr targetType = arena.Make<ClassType>(L"MyClass", L"MyAssembly");
+                    TypePtr returnType = arena.Make<PrimitiveType>(PrimitiveType::PrimitiveKind::kSTRING);
+                    TypePtr parameterType1 = arena.Make<PrimitiveType>(PrimitiveType::PrimitiveKind::kOBJECT);
+                    TypePtr parameterType2 = arena.Make<PrimitiveType>(PrimitiveType::PrimitiveKind::kBOOL);
+                    TypeListPtr parameterTypes = arena.Make<TypeList>(arena);
                     parameterTypes->Add(parameterType1);
                     parameterTypes->Add(parameterType2);
-                    MethodTypePtr methodType(new MethodType(targetType, L"MyMethod", returnType, false, parameterTypes));
+                    MethodTypePtr methodType = arena.Make<MethodType>(targetType, L"MyMethod", returnType, false, parameterTypes, arena.Make<TypeList>(arena));
                     return methodType;
                 }
 
-                static MethodTypePtr CreateComplexMethodType()
+                static MethodTypePtr CreateComplexMethodType(Arena& arena)
                 {
-                    PrimitiveTypePtr u8Type(new PrimitiveType(PrimitiveType::PrimitiveKind::kU8));
-                    ArrayTypePtr u8ArrayType(new ArrayType(u8Type));
-                    TypeListPtr targetTypeGenericArguments(new TypeList());
+                    PrimitiveTypePtr u8Type = arena.Make<PrimitiveType>(PrimitiveType::PrimitiveKind::kU8);
+                    ArrayTypePtr u8ArrayType = arena.Make<ArrayType>(u8Type);
+                    TypeListPtr targetTypeGenericArguments = arena.Make<TypeList>(arena);
                     targetTypeGenericArguments->Add(u8ArrayType);
-                    GenericTypePtr targetType(new GenericType(L"MyClass", L"MyAssembly", targetTypeGenericArguments));
+                    GenericTypePtr targetType = arena.Make<GenericType>(L"MyClass", L"MyAssembly", targetTypeGenericArguments);
                     
-                    PrimitiveTypePtr stringType(new PrimitiveType(PrimitiveType::PrimitiveKind::kSTRING));
-                    PrimitiveTypePtr objectType(new PrimitiveType(PrimitiveType::PrimitiveKind::kOBJECT));
-                    ArrayTypePtr objectArrayType(new ArrayType(objectType));
-                    TypeListPtr returnTypeGenericArguments(new TypeList());
+                    PrimitiveTypePtr stringType = arena.Make<PrimitiveType>(PrimitiveType::PrimitiveKind::kSTRING);
+                    PrimitiveTypePtr objectType = arena.Make<PrimitiveType>(PrimitiveType::PrimitiveKind::kOBJECT);
+                    ArrayTypePtr objectArrayType = arena.Make<ArrayType>(objectType);
+                    TypeListPtr returnTypeGenericArguments = arena.Make<TypeList>(arena);
                     returnTypeGenericArguments->Add(objectArrayType);
                     returnTypeGenericArguments->Add(stringType);
-                    GenericTypePtr returnType(new GenericType(L"MyGenericReturnClass", L"MyAssembly", returnTypeGenericArguments));
+                    GenericTypePtr returnType = arena.Make<GenericType>(L"MyGenericReturnClass", L"MyAssembly", returnTypeGenericArguments);
                     
-                    TypePtr parameterType1(new PrimitiveType(PrimitiveType::PrimitiveKind::kOBJECT));
-                    TypePtr parameterType2(new PrimitiveType(PrimitiveType::PrimitiveKind::kBOOL));
-                    TypeListPtr parameterTypes(new TypeList());
+                    TypePtr parameterType1 = arena.Make<PrimitiveType>(PrimitiveType::PrimitiveKind::kOBJECT);
+                    TypePtr parameterType2 = arena.Make<PrimitiveType>(PrimitiveType::PrimitiveKind::kBOOL);
+                    TypeListPtr parameterTypes = arena.Make<TypeList>(arena);
                     parameterTypes->Add(parameterType1);
                     parameterTypes->Add(parameterType2);
 
-                    PrimitiveTypePtr boolType(new PrimitiveType(PrimitiveType::PrimitiveKind::kBOOL));
-                    ArrayTypePtr boolArrayType(new ArrayType(boolType));
-                    TypeListPtr nestedGenericArguments(new TypeList());
+                    PrimitiveTypePtr boolType = arena.Make<PrimitiveType>(PrimitiveType::PrimitiveKind::kBOOL);
+                    ArrayTypePtr boolArrayType = arena.Make<ArrayType>(boolType);
+                    TypeListPtr nestedGenericArguments = arena.Make<TypeList>(arena);
                     nestedGenericArguments->Add(boolArrayType);
-                    GenericTypePtr nestedGenericType(new GenericType(L"MyNestedGenericClass", L"MyAssembly", nestedGenericArguments));
-                    TypeListPtr genericArguments(new TypeList());
+                    GenericTypePtr nestedGenericType = arena.Make<GenericType>(L"MyNestedGenericClass", L"MyAssembly", nestedGenericArguments);
+                    TypeListPtr genericArguments = arena.Make<TypeList>(arena);
                     genericArguments->Add(nestedGenericType);
-                    GenericTypePtr genericType(new GenericType(L"MyGenericClass", L"MyAssembly", genericArguments));
-                    TypeListPtr methodGenericArguments(new TypeList());
+                    GenericTypePtr genericType = arena.Make<GenericType>(L"MyGenericClass", L"MyAssembly", genericArguments);
+                    TypeListPtr methodGenericArguments = arena.Make<TypeList>(arena);
                     methodGenericArguments->Add(genericType);
                     
-                    MethodTypePtr methodType(new MethodType(targetType, L"MyMethod", returnType, true, parameterTypes, methodGenericArguments));
+                    MethodTypePtr methodType = arena.Make<MethodType>(targetType, L"MyMethod", returnType, true, parameterTypes, methodGenericArguments);
                     return methodType;
                 }
             };
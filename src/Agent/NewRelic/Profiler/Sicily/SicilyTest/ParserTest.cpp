@@ -185,6 +185,20 @@ namespace sicily
             {
                 TestParser(L"instance !0 class [mscorlib]System.Tuple`2<class [mscorlib]System.Action`1<object[]>, class [mscorlib]System.Action`1<object[]>>::get_Item1()");
             }
+
+            TEST_METHOD(TestNestedTypeConstructor)
+            {
+                TestParser(L"instance void [MyAssembly]MyNamespace.Outer/Inner::.ctor(string)");
+            }
+
+            TEST_METHOD(TestNameWithInteriorWhitespaceIsJoined)
+            {
+                std::wstring testString(L"void [MyAssembly]MyNamespace . MyClass / Inner::MyMethod()");
+                Scanner scanner(testString);
+                Parser parser;
+                ast::TypePtr rootType = parser.Parse(scanner);
+                Assert::AreEqual(std::wstring(L"void [MyAssembly]MyNamespace.MyClass/Inner::MyMethod()"), rootType->ToString());
+            }
         };
     }
 }
@@ -55,6 +55,7 @@ namespace sicily
                 public:
                     TypeImplementation(Type::Kind kind) : Type(kind) {}
                     virtual std::wstring ToString() const override final { throw NotImplementedException(); }
+                    virtual void Accept(TypeVisitor& /*visitor*/) const override final { throw NotImplementedException(); }
                 };
             };
         }
@@ -0,0 +1,48 @@
+/*
+* Copyright 2020 New Relic Corporation. All rights reserved.
+* SPDX-License-Identifier: Apache-2.0
+*/
+#pragma once
+#include <cstddef>
+#include <string>
+#include "../Common/xplat.h"
+
+namespace sicily {
+    //
+    // A non-owning view of a run of characters.  The scanner hands these out for every
+    // token and the AST keeps them for names, so the characters they point at (the
+    // string being parsed, a literal, or an arena copy) must outlive the view.
+    //
+    class StringView
+    {
+        public:
+            StringView() : data_(nullptr), size_(0) {}
+            StringView(const xchar_t* data, size_t size) : data_(data), size_(size) {}
+            StringView(const xchar_t* nullTerminated) :
+                data_(nullTerminated),
+                size_(nullTerminated == nullptr ? 0 : std::char_traits<xchar_t>::length(nullTerminated))
+            {}
+            explicit StringView(const xstring_t& string) : data_(string.data()), size_(string.size()) {}
+
+            const xchar_t* data() const { return data_; }
+            const xchar_t* end() const { return data_ + size_; }
+            size_t size() const { return size_; }
+            bool empty() const { return size_ == 0; }
+
+            xstring_t ToString() const { return empty() ? xstring_t() : xstring_t(data_, size_); }
+
+            bool operator==(const StringView& other) const
+            {
+                return size_ == other.size_ && (size_ == 0 || std::char_traits<xchar_t>::compare(data_, other.data_, size_) == 0);
+            }
+
+            bool operator!=(const StringView& other) const
+            {
+                return !(*this == other);
+            }
+
+        private:
+            const xchar_t* data_;
+            size_t size_;
+    };
+};
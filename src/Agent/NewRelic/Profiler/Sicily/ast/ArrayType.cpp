@@ -12,10 +12,6 @@ namespace sicily {
             assert(elementType != nullptr);
         }
 
-        ArrayType::~ArrayType()
-        {
-        }
-
         TypePtr
         ArrayType::GetElementType() const
         {
@@ -27,6 +23,12 @@ namespace sicily {
         {
             return elementType_->ToString() + _X("[]");
         }
+
+        void
+        ArrayType::Accept(TypeVisitor& visitor) const
+        {
+            visitor.Visit(*this);
+        }
     };
 };
 
@@ -4,23 +4,22 @@
 */
 #pragma once
 #include "Type.h"
-#include <memory>
 
 namespace sicily {
     namespace ast {
         class ArrayType : public Type {
             public:
                 ArrayType(TypePtr elementType);
-                virtual ~ArrayType();
 
                 TypePtr GetElementType() const;
 
                 xstring_t ToString() const;
+                void Accept(TypeVisitor& visitor) const;
 
             private:
                 TypePtr elementType_;
         };
 
-        typedef std::shared_ptr<ArrayType> ArrayTypePtr;
+        typedef ArrayType* ArrayTypePtr;
     };
 };
@@ -9,7 +9,7 @@
 
 namespace sicily {
     namespace ast {
-        ClassType::ClassType(const xstring_t& name, const xstring_t& assembly, bool raw, ClassKind classKind) :
+        ClassType::ClassType(StringView name, StringView assembly, bool raw, ClassKind classKind) :
             Type(Type::Kind::kCLASS),
             assembly_(assembly),
             name_(name),
@@ -19,7 +19,7 @@ namespace sicily {
             assert(!name.empty());
         }
 
-        ClassType::ClassType(Type::Kind kind, const xstring_t& name, const xstring_t& assembly, bool raw, ClassKind classKind) :
+        ClassType::ClassType(Type::Kind kind, StringView name, StringView assembly, bool raw, ClassKind classKind) :
             Type(kind),
             assembly_(assembly),
             name_(name),
@@ -29,18 +29,26 @@ namespace sicily {
             assert(!name.empty());
         }
 
-        ClassType::~ClassType()
+        xstring_t
+        ClassType::GetAssembly() const
         {
+            return assembly_.ToString();
         }
 
         xstring_t
-        ClassType::GetAssembly() const
+        ClassType::GetName() const
+        {
+            return name_.ToString();
+        }
+
+        const StringView&
+        ClassType::GetAssemblyView() const
         {
             return assembly_;
         }
 
-        xstring_t
-        ClassType::GetName() const
+        const StringView&
+        ClassType::GetNameView() const
         {
             return name_;
         }
@@ -74,14 +82,22 @@ namespace sicily {
                 }
             }
 
-            if (!GetAssembly().empty()) {
-                buf += _X("[") + GetAssembly() + _X("]");
+            if (!assembly_.empty()) {
+                buf += _X("[");
+                buf.append(assembly_.data(), assembly_.size());
+                buf += _X("]");
             }
 
-            buf += GetName();
+            buf.append(name_.data(), name_.size());
 
             return buf;
         }
+
+        void
+        ClassType::Accept(TypeVisitor& visitor) const
+        {
+            visitor.Visit(*this);
+        }
     };
 };
 
@@ -4,6 +4,7 @@
 */
 #pragma once
 #include "Type.h"
+#include "../StringView.h"
 
 namespace sicily {
     namespace ast {
@@ -17,35 +18,37 @@ namespace sicily {
                 };
 
                 ClassType(
-                    const xstring_t& name,
-                    const xstring_t& assembly = _X(""),
+                    StringView name,
+                    StringView assembly = StringView(),
                     bool raw = false,
                     ClassKind classKind = ClassKind::CLASS
                 );
-                virtual ~ClassType();
 
                 xstring_t GetAssembly() const;
                 xstring_t GetName() const;
+                const StringView& GetAssemblyView() const;
+                const StringView& GetNameView() const;
                 bool IsRaw() const;
                 ClassKind GetClassKind() const;
 
                 xstring_t ToString() const;
+                void Accept(TypeVisitor& visitor) const;
 
             protected:
                 ClassType(
                     const Type::Kind kind,
-                    const xstring_t& name,
-                    const xstring_t& assembly = _X(""),
+                    StringView name,
+                    StringView assembly = StringView(),
                     bool raw = false,
                     ClassKind classKind = ClassKind::CLASS);
 
             private:
-                xstring_t assembly_;
-                xstring_t name_;
+                StringView assembly_;
+                StringView name_;
                 bool raw_;
                 ClassKind classKind_;
         };
 
-        typedef std::shared_ptr<ClassType> ClassTypePtr;
+        typedef ClassType* ClassTypePtr;
     };
 };
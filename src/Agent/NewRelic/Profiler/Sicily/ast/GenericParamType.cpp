@@ -25,14 +25,19 @@ namespace sicily
             return stream;
         }
 
-        GenericParamType::GenericParamKind GenericParamType::GetGenericParamKind()
+        GenericParamType::GenericParamKind GenericParamType::GetGenericParamKind() const
         {
             return kind_;
         }
 
-        uint32_t GenericParamType::GetNumber()
+        uint32_t GenericParamType::GetNumber() const
         {
             return number_;
         }
+
+        void GenericParamType::Accept(TypeVisitor& visitor) const
+        {
+            visitor.Visit(*this);
+        }
     }
 }
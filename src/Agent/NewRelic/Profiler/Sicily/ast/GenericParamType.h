@@ -4,7 +4,6 @@
 */
 #pragma once
 #include <cstdint>
-#include <memory>
 #include "Type.h"
 
 namespace sicily
@@ -21,18 +20,18 @@ namespace sicily
             };
 
             GenericParamType(GenericParamKind kind, uint32_t number);
-            virtual ~GenericParamType() { }
 
-            virtual GenericParamKind GetGenericParamKind();
-            virtual uint32_t GetNumber();
+            virtual GenericParamKind GetGenericParamKind() const;
+            virtual uint32_t GetNumber() const;
 
             virtual xstring_t ToString() const override;
+            virtual void Accept(TypeVisitor& visitor) const override;
 
         private:
             GenericParamKind kind_;
             uint32_t number_;
         };
 
-        typedef std::shared_ptr<GenericParamType> GenericParamTypePtr;
+        typedef GenericParamType* GenericParamTypePtr;
     }
 }
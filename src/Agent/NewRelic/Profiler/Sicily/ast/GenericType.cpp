@@ -9,17 +9,13 @@
 
 namespace sicily {
     namespace ast {
-        GenericType::GenericType(const xstring_t& name, const xstring_t& assembly, TypeListPtr genericTypes, bool raw, ClassKind kind) :
+        GenericType::GenericType(StringView name, StringView assembly, TypeListPtr genericTypes, bool raw, ClassKind kind) :
             ClassType(Type::Kind::kGENERICCLASS, name, assembly, raw, kind),
             genericTypes_(genericTypes)
         {
             assert(genericTypes != nullptr);
         }
 
-        GenericType::~GenericType()
-        {
-        }
-
         TypeListPtr
         GenericType::GetGenericTypes() const
         {
@@ -33,7 +29,7 @@ namespace sicily {
 
             buf += ClassType::ToString();
 
-            if (genericTypes_ != NULL) {
+            if (genericTypes_ != nullptr) {
                 size_t size = genericTypes_->GetSize();
                 buf.push_back('`');
                 buf += to_xstring((unsigned)size);
@@ -44,5 +40,11 @@ namespace sicily {
 
             return buf;
         }
+
+        void
+        GenericType::Accept(TypeVisitor& visitor) const
+        {
+            visitor.Visit(*this);
+        }
     };
 };
@@ -12,22 +12,22 @@ namespace sicily {
         {
             public:
                 GenericType(
-                    const xstring_t& name,
-                    const xstring_t& assembly = _X(""),
-                    TypeListPtr genericTypes = TypeListPtr(new TypeList()),
+                    StringView name,
+                    StringView assembly,
+                    TypeListPtr genericTypes,
                     bool raw = false,
                     ClassKind kind = ClassKind::CLASS
                 );
-                virtual ~GenericType();
 
                 TypeListPtr GetGenericTypes() const;
 
                 xstring_t ToString() const;
+                void Accept(TypeVisitor& visitor) const;
 
             private:
                 TypeListPtr genericTypes_;
         };
 
-        typedef std::shared_ptr<GenericType> GenericTypePtr;
+        typedef GenericType* GenericTypePtr;
     };
 };
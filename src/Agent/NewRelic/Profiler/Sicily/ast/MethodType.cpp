@@ -11,7 +11,7 @@ namespace sicily {
     namespace ast {
         MethodType::MethodType(
             ClassTypePtr targetType,
-            const xstring_t& methodName,
+            StringView methodName,
             TypePtr returnType,
             bool instanceMethod,
             TypeListPtr argTypes,
@@ -29,10 +29,6 @@ namespace sicily {
             assert(genericTypes != nullptr);
         }
 
-        MethodType::~MethodType()
-        {
-        }
-
         ClassTypePtr
         MethodType::GetTargetType() const
         {
@@ -41,6 +37,12 @@ namespace sicily {
 
         xstring_t
         MethodType::GetMethodName() const
+        {
+            return methodName_.ToString();
+        }
+
+        const StringView&
+        MethodType::GetMethodNameView() const
         {
             return methodName_;
         }
@@ -80,7 +82,7 @@ namespace sicily {
 
             buf += GetReturnType()->ToString() + _X(" ");
             buf += GetTargetType()->ToString() + _X("::");
-            buf += GetMethodName();
+            buf.append(methodName_.data(), methodName_.size());
 
             TypeListPtr genericTypes = GetGenericTypes();
             if (genericTypes->GetSize() > 0) {
@@ -98,6 +100,12 @@ namespace sicily {
 
             return buf;
         }
+
+        void
+        MethodType::Accept(TypeVisitor& visitor) const
+        {
+            visitor.Visit(*this);
+        }
     };
 };
 
@@ -4,7 +4,6 @@
 */
 #pragma once
 
-#include <memory>
 #include <string>
 
 #include "Types.h"
@@ -16,32 +15,33 @@ namespace sicily {
             public:
                 MethodType(
                     ClassTypePtr targetType,
-                    const xstring_t& methodName,
+                    StringView methodName,
                     TypePtr returnType,
                     bool instanceMethod,
-                    TypeListPtr argTypes = TypeListPtr(new TypeList()),
-                    TypeListPtr genericTypes = TypeListPtr(new TypeList())
+                    TypeListPtr argTypes,
+                    TypeListPtr genericTypes
                 );
-                virtual ~MethodType();
 
                 ClassTypePtr GetTargetType() const;
                 xstring_t GetMethodName() const;
+                const StringView& GetMethodNameView() const;
                 TypePtr GetReturnType() const;
                 TypeListPtr GetArgTypes() const;
                 TypeListPtr GetGenericTypes() const;
                 bool IsInstanceMethod() const;
 
                 xstring_t ToString() const;
+                void Accept(TypeVisitor& visitor) const;
 
             private:
                 ClassTypePtr targetType_;
-                xstring_t methodName_;
+                StringView methodName_;
                 TypePtr returnType_;
                 TypeListPtr argTypes_;
                 TypeListPtr genericTypes_;
                 bool instanceMethod_;
         };
 
-        typedef std::shared_ptr<MethodType> MethodTypePtr;
+        typedef MethodType* MethodTypePtr;
     };
 };
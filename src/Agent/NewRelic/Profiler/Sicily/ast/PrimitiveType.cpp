@@ -10,10 +10,6 @@ namespace sicily {
         {
         }
 
-        PrimitiveType::~PrimitiveType()
-        {
-        }
-
         PrimitiveType::PrimitiveKind
         PrimitiveType::GetPrimitiveKind() const
         {
@@ -45,6 +41,12 @@ namespace sicily {
                 default: return _X("unknown");
             };
         }
+
+        void
+        PrimitiveType::Accept(TypeVisitor& visitor) const
+        {
+            visitor.Visit(*this);
+        }
     };
 };
 
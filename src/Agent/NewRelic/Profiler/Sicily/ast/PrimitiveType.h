@@ -32,16 +32,16 @@ namespace sicily {
                 };
                     
                 PrimitiveType(PrimitiveKind kind);
-                virtual ~PrimitiveType();
 
                 PrimitiveKind GetPrimitiveKind() const;
 
                 xstring_t ToString() const;
+                void Accept(TypeVisitor& visitor) const;
 
             private:
                 PrimitiveKind primitiveKind_;
         };
 
-        typedef std::shared_ptr<PrimitiveType> PrimitiveTypePtr;
+        typedef PrimitiveType* PrimitiveTypePtr;
     };
 };
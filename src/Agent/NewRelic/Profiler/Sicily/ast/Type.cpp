@@ -10,10 +10,6 @@ namespace sicily {
         {
         }
 
-        Type::~Type()
-        {
-        }
-
         Type::Kind
         Type::GetKind() const
         {
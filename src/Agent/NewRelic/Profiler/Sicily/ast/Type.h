@@ -4,8 +4,8 @@
 */
 #pragma once
 #include <string>
-#include <memory>
 #include "../Exceptions.h"
+#include "TypeVisitor.h"
 
 namespace sicily {
     namespace ast {
@@ -23,17 +23,21 @@ namespace sicily {
                 };
 
                 Type(Kind kind);
-                virtual ~Type();
 
                 Kind GetKind() const;
 
                 virtual xstring_t ToString() const = 0;
+                virtual void Accept(TypeVisitor& visitor) const = 0;
+
+            protected:
+                // AST nodes live in a parser's arena, which destroys each as its own type, so a Type* can't be deleted
+                ~Type() = default;
 
             private:
                 Kind kind_;
         };
 
-        typedef std::shared_ptr<Type> TypePtr;
+        typedef Type* TypePtr;
 
         struct UnknownTypeKindException : AstException
         {
@@ -1,32 +1,41 @@
 // Copyright 2020 New Relic, Inc. All rights reserved.
 // SPDX-License-Identifier: Apache-2.0
 
-#include <sstream>
+#include <cstring>
 
 #include "TypeList.h"
 
 namespace sicily {
     namespace ast {
-        TypeList::TypeList()
-        {
-        }
-
-        TypeList::~TypeList()
+        TypeList::TypeList(Arena& arena)
+            : arena_(arena), items_(nullptr), size_(0), capacity_(0)
         {
         }
 
         void
         TypeList::Add(TypePtr type)
         {
-            items_.push_back(type);
+            if (size_ == UINT16_MAX) {
+                throw AstException(_X("sicily TypeList is full"));
+            }
+
+            if (size_ == capacity_) {
+                uint16_t capacity = capacity_ == 0 ? kInitialCapacity : (capacity_ > UINT16_MAX / 2 ? UINT16_MAX : uint16_t(capacity_ * 2));
+                TypePtr* items = arena_.MakeArray<TypePtr>(capacity);
+                if (size_ > 0) {
+                    std::memcpy(items, items_, size_ * sizeof(TypePtr));
+                }
+                items_ = items;
+                capacity_ = capacity;
+            }
+
+            items_[size_++] = type;
         }
 
         uint16_t
         TypeList::GetSize() const
         {
-            if (items_.size() > UINT16_MAX) return UINT16_MAX;
-
-            return uint16_t(items_.size());
+            return size_;
         }
 
         TypePtr
@@ -39,10 +48,10 @@ namespace sicily {
         TypeList::ToString() const
         {
             auto buf = xstring_t();
-            for (size_t i = 0; i < items_.size(); i++) {
+            for (uint16_t i = 0; i < size_; i++) {
                 buf += items_[i]->ToString();
 
-                if (i < (items_.size()-1)) {
+                if (i < (size_-1)) {
                     buf += _X(", ");
                 }
             }
@@ -6,22 +6,22 @@
 #define _SIGPARSE_AST_TYPE_LIST_H_INCLUDED_
 
 #include <cstdint>
-#include <memory>
-#include <vector>
 #include <string>
 
 #include "Type.h"
+#include "../Arena.h"
 
 namespace sicily {
     namespace ast {
         //
-        // XXX gut this & replace with unique_ptr
+        // A growable array of types whose storage comes from the same arena as the
+        // nodes it holds.  Growing abandons the old array to the arena rather than
+        // freeing it; lists are short enough that this is cheaper than a heap vector.
         //
         class TypeList
         {
             public:
-                TypeList();
-                ~TypeList();
+                explicit TypeList(Arena& arena);
 
                 void Add(TypePtr type);
                 TypePtr GetItem(uint16_t i) const;
@@ -30,12 +30,15 @@ namespace sicily {
                 xstring_t ToString() const;
 
             private:
-                typedef std::vector<TypePtr> types;
+                static const uint16_t kInitialCapacity = 4;
 
-                types items_;
+                Arena& arena_;
+                TypePtr* items_;
+                uint16_t size_;
+                uint16_t capacity_;
         };
 
-        typedef std::shared_ptr<TypeList> TypeListPtr;
+        typedef TypeList* TypeListPtr;
     };
 };
 
@@ -0,0 +1,33 @@
+/*
+* Copyright 2020 New Relic Corporation. All rights reserved.
+* SPDX-License-Identifier: Apache-2.0
+*/
+#pragma once
+
+namespace sicily {
+    namespace ast {
+        class ArrayType;
+        class ClassType;
+        class GenericParamType;
+        class GenericType;
+        class MethodType;
+        class PrimitiveType;
+
+        //
+        // Double dispatch over the concrete node types, so that code walking a tree
+        // doesn't have to switch on GetKind() and cast at every level.
+        //
+        class TypeVisitor
+        {
+            public:
+                virtual ~TypeVisitor() {}
+
+                virtual void Visit(const PrimitiveType& type) = 0;
+                virtual void Visit(const ArrayType& type) = 0;
+                virtual void Visit(const ClassType& type) = 0;
+                virtual void Visit(const GenericType& type) = 0;
+                virtual void Visit(const MethodType& type) = 0;
+                virtual void Visit(const GenericParamType& type) = 0;
+        };
+    };
+};
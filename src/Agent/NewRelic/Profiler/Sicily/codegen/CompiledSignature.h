@@ -0,0 +1,495 @@
+/*
+* Copyright 2020 New Relic Corporation. All rights reserved.
+* SPDX-License-Identifier: Apache-2.0
+*/
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "../Exceptions.h"
+#include "ITokenizer.h"
+#include "../ast/Types.h"
+
+namespace sicily { namespace codegen
+{
+    struct UnhandledTypeKindException : BytecodeGeneratorException
+    {
+        UnhandledTypeKindException(ast::Type::Kind kind) : kind_(kind) {}
+        ast::Type::Kind kind_;
+    };
+
+    struct UnknownClassKindException : BytecodeGeneratorException
+    {
+        UnknownClassKindException(ast::ClassType::ClassKind kind) : kind_(kind) {}
+        ast::ClassType::ClassKind kind_;
+    };
+
+    struct DataTooLargeToCompressException : BytecodeGeneratorException
+    {};
+
+    struct NoRootTokenException : BytecodeGeneratorException
+    {};
+
+    // appends the ECMA-335 II.23.2 compressed form of an unsigned integer
+    inline void AppendCompressedData(ByteVector& bytes, uint32_t dataToCompress)
+    {
+        if (dataToCompress <= 0x7F)
+        {
+            bytes.push_back((unsigned char)dataToCompress);
+            return;
+        }
+
+        if (dataToCompress <= 0x3FFF)
+        {
+            bytes.push_back((unsigned char)((dataToCompress >> 8) | 0x80));
+            bytes.push_back((unsigned char)(dataToCompress & 0xFF));
+            return;
+        }
+
+        if (dataToCompress <= 0x1FFFFFFF)
+        {
+            bytes.push_back((unsigned char)((dataToCompress >> 24) | 0xC0));
+            bytes.push_back((unsigned char)((dataToCompress >> 16) & 0xFF));
+            bytes.push_back((unsigned char)((dataToCompress >> 8) & 0xFF));
+            bytes.push_back((unsigned char)(dataToCompress & 0xFF));
+            return;
+        }
+
+        throw DataTooLargeToCompressException();
+    }
+
+    // appends a TypeDefOrRefOrSpecEncoded token (ECMA-335 II.23.2.8)
+    inline void AppendCompressedToken(ByteVector& bytes, uint32_t tokenToCompress)
+    {
+        uint32_t lowBits = tokenToCompress & 0x00ffffff;
+        uint8_t highBits = tokenToCompress >> 24;
+
+        // TypeDef is encoded with low bits 0x02000000
+        // TypeRef is encoded with low bits 0x01000000
+        // TypeSpec is encoded with low bits 0x1b000000
+        // BaseType is encoded with low bits 0x72000000
+
+        uint32_t result = (lowBits << 2);
+        if (highBits == 0x02) result |= 0x0;
+        else if (highBits == 0x01) result |= 0x1;
+        else if (highBits == 0x1b) result |= 0x2;
+        else if (highBits == 0x72) result |= 0x3;
+
+        AppendCompressedData(bytes, result);
+    }
+
+    //
+    // A signature blob whose embedded type tokens are left as holes.  The tokens are
+    // module specific and their compressed length depends on their value, so they
+    // can only be filled in once a module's tokenizer has resolved them.
+    //
+    class SignatureTemplate
+    {
+    public:
+        void AppendByte(uint8_t byte)
+        {
+            bytes_.push_back(byte);
+        }
+
+        void AppendCompressedData(uint32_t data)
+        {
+            codegen::AppendCompressedData(bytes_, data);
+        }
+
+        // reserves a spot for the compressed token produced by the given request
+        void AppendToken(size_t request)
+        {
+            holes_.push_back(Hole(bytes_.size(), request));
+        }
+
+        void Materialize(const std::vector<uint32_t>& tokens, ByteVector& out) const
+        {
+            size_t written = 0;
+            for (auto& hole : holes_)
+            {
+                out.insert(out.end(), bytes_.begin() + written, bytes_.begin() + hole.first);
+                written = hole.first;
+                AppendCompressedToken(out, tokens[hole.second]);
+            }
+            out.insert(out.end(), bytes_.begin() + written, bytes_.end());
+        }
+
+        // the largest the blob can be once every hole holds a four byte token
+        size_t GetMaxSize() const
+        {
+            return bytes_.size() + holes_.size() * 4;
+        }
+
+        bool operator==(const SignatureTemplate& other) const
+        {
+            return bytes_ == other.bytes_ && holes_ == other.holes_;
+        }
+
+    private:
+        // offset into bytes_ and the index of the request whose token goes there
+        typedef std::pair<size_t, size_t> Hole;
+
+        ByteVector bytes_;
+        std::vector<Hole> holes_;
+    };
+
+    // one call that has to be made on a module's tokenizer
+    struct TokenRequest
+    {
+        enum class Kind
+        {
+            kTYPEREF,
+            kTYPEDEF,
+            kTYPESPEC,
+            kMEMBERREF,
+            kMETHODSPEC,
+        };
+
+        TokenRequest(Kind kind) : kind_(kind), parent_(0) {}
+
+        Kind kind_;
+        xstring_t assembly_;
+        xstring_t name_;
+        // the request whose token is the parent type (kMEMBERREF) or generic method (kMETHODSPEC)
+        size_t parent_;
+        SignatureTemplate signature_;
+
+        bool operator==(const TokenRequest& other) const
+        {
+            return kind_ == other.kind_ && parent_ == other.parent_ && assembly_ == other.assembly_ && name_ == other.name_ && signature_ == other.signature_;
+        }
+    };
+
+    //
+    // A parsed and encoded type or method string that no longer depends on the
+    // text it came from.  It is immutable once compiled, so one instance can be
+    // shared by every module and thread; resolving it only makes the tokenizer
+    // calls and splices the resulting tokens into the pre-encoded blobs.
+    //
+    class CompiledSignature
+    {
+    public:
+        CompiledSignature() : root_(npos) {}
+
+        static const size_t npos = size_t(-1);
+
+        uint32_t ResolveToken(ITokenizer& tokenizer) const
+        {
+            if (root_ == npos) throw NoRootTokenException();
+
+            std::vector<uint32_t> tokens;
+            ResolveRequests(tokenizer, tokens);
+            return tokens[root_];
+        }
+
+        ByteVector ResolveBytes(ITokenizer& tokenizer) const
+        {
+            ByteVector bytes;
+            ResolveBytes(tokenizer, bytes);
+            return bytes;
+        }
+
+        // appends the resolved blob to the end of an existing buffer
+        void ResolveBytes(ITokenizer& tokenizer, ByteVector& bytes) const
+        {
+            std::vector<uint32_t> tokens;
+            ResolveRequests(tokenizer, tokens);
+            bytes.reserve(bytes.size() + bytes_.GetMaxSize());
+            bytes_.Materialize(tokens, bytes);
+        }
+
+        size_t GetRequestCount() const
+        {
+            return requests_.size();
+        }
+
+    private:
+        friend class SignatureCompiler;
+
+        void ResolveRequests(ITokenizer& tokenizer, std::vector<uint32_t>& tokens) const
+        {
+            tokens.resize(requests_.size());
+
+            // one buffer is reused for every request's signature
+            ByteVector signature;
+            for (size_t i = 0; i < requests_.size(); ++i)
+            {
+                auto& request = requests_[i];
+                signature.clear();
+                request.signature_.Materialize(tokens, signature);
+
+                switch (request.kind_)
+                {
+                    case TokenRequest::Kind::kTYPEREF:
+                        tokens[i] = tokenizer.GetTypeRefToken(request.assembly_, request.name_);
+                        break;
+                    case TokenRequest::Kind::kTYPEDEF:
+                        tokens[i] = tokenizer.GetTypeDefToken(request.name_);
+                        break;
+                    case TokenRequest::Kind::kTYPESPEC:
+                        tokens[i] = tokenizer.GetTypeSpecToken(signature);
+                        break;
+                    case TokenRequest::Kind::kMEMBERREF:
+                        tokens[i] = tokenizer.GetMemberRefOrDefToken(tokens[request.parent_], request.name_, signature);
+                        break;
+                    case TokenRequest::Kind::kMETHODSPEC:
+                        tokens[i] = tokenizer.GetMethodSpecToken(tokens[request.parent_], signature);
+                        break;
+                }
+            }
+        }
+
+        // in the order the tokenizer must see them; a request only refers to earlier ones
+        std::vector<TokenRequest> requests_;
+        // the request whose token is the result, when compiled for a token
+        size_t root_;
+        // the resulting blob, when compiled for bytes
+        SignatureTemplate bytes_;
+    };
+
+    //
+    // Turns an AST into a CompiledSignature.  This is where the ECMA-335 II.23.2
+    // signature encoding lives; ByteCodeGenerator compiles and resolves in one go.
+    //
+    class SignatureCompiler
+    {
+    public:
+        CompiledSignature CompileToken(ast::TypePtr type)
+        {
+            CompiledSignature compiled;
+            RequestBuilder builder(compiled);
+            type->Accept(builder);
+            compiled.root_ = builder.GetRequest();
+            return compiled;
+        }
+
+        CompiledSignature CompileBytes(ast::TypePtr type)
+        {
+            CompiledSignature compiled;
+            BlobWriter writer(compiled, compiled.bytes_);
+            type->Accept(writer);
+            return compiled;
+        }
+
+        CompiledSignature CompileMethodInstantiation(ast::MethodTypePtr type)
+        {
+            CompiledSignature compiled;
+            BlobWriter writer(compiled, compiled.bytes_);
+            writer.WriteMethodInstantiation(*type);
+            return compiled;
+        }
+
+        CompiledSignature CompileClassInstantiation(ast::GenericTypePtr type)
+        {
+            CompiledSignature compiled;
+            BlobWriter writer(compiled, compiled.bytes_);
+            type->Accept(writer);
+            return compiled;
+        }
+
+    private:
+        static size_t AddRequest(CompiledSignature& compiled, TokenRequest& request)
+        {
+            // the same type often appears more than once in a signature, only ask for it once
+            for (size_t i = 0; i < compiled.requests_.size(); ++i)
+            {
+                if (compiled.requests_[i] == request) return i;
+            }
+            compiled.requests_.push_back(std::move(request));
+            return compiled.requests_.size() - 1;
+        }
+
+        // generic definitions are looked up by their arity-suffixed name, e.g. Action`1
+        static size_t AddClassRequest(CompiledSignature& compiled, const ast::ClassType& type, uint32_t genericCount)
+        {
+            TokenRequest request(type.GetAssemblyView().empty() ? TokenRequest::Kind::kTYPEDEF : TokenRequest::Kind::kTYPEREF);
+            request.assembly_ = type.GetAssembly();
+            request.name_ = type.GetName();
+            if (genericCount != 0)
+            {
+                request.name_.push_back('`');
+                request.name_ += to_xstring((unsigned)genericCount);
+            }
+            return AddRequest(compiled, request);
+        }
+
+        // writes the signature encoding of a type into a single template
+        class BlobWriter : public ast::TypeVisitor
+        {
+        public:
+            BlobWriter(CompiledSignature& compiled, SignatureTemplate& bytes) : compiled_(compiled), bytes_(bytes) {}
+
+            virtual void Visit(const ast::PrimitiveType& type) override
+            {
+                // BOOLEAN | CHAR | I1 | U1 | I2 | U2 | I4 | U4 | I8 | U8 | R4 | R8 | I | U
+                bytes_.AppendByte((unsigned char)(type.GetPrimitiveKind()));
+            }
+
+            virtual void Visit(const ast::ArrayType& type) override
+            {
+                // SZARRAY Type
+                bytes_.AppendByte(0x1d);
+                type.GetElementType()->Accept(*this);
+            }
+
+            virtual void Visit(const ast::ClassType& type) override
+            {
+                WriteClass(type, 0);
+            }
+
+            virtual void Visit(const ast::GenericType& type) override
+            {
+                auto genericArguments = type.GetGenericTypes();
+                // GENERICINST
+                bytes_.AppendByte(0x15);
+                // (CLASS | VALUETYPE) TypeDefOrRefOrSpecEncoded
+                WriteClass(type, genericArguments->GetSize());
+                // GenArgCount Type*
+                WriteTypeList(genericArguments);
+            }
+
+            virtual void Visit(const ast::MethodType& type) override
+            {
+                auto genericCount = type.GetGenericTypes()->GetSize();
+
+                // first byte (HASTHIS, EXPLICITTHIS, DEFAULT, VARARG, GENERIC ORed together)
+                unsigned char firstByte = 0x00;
+                if (type.IsInstanceMethod()) firstByte |= 0x20;
+                if (genericCount != 0) firstByte |= 0x10;
+                bytes_.AppendByte(firstByte);
+
+                // generic type count
+                if (genericCount > 0)
+                {
+                    bytes_.AppendCompressedData(genericCount);
+                }
+
+                auto argTypes = type.GetArgTypes();
+                // parameter count
+                bytes_.AppendCompressedData(argTypes->GetSize());
+                // return type
+                type.GetReturnType()->Accept(*this);
+                // parameters
+                for (uint16_t i = 0; i < argTypes->GetSize(); ++i)
+                {
+                    argTypes->GetItem(i)->Accept(*this);
+                }
+            }
+
+            virtual void Visit(const ast::GenericParamType& type) override
+            {
+                // MVAR | VAR Number
+                bytes_.AppendByte(uint8_t(type.GetGenericParamKind()));
+                bytes_.AppendCompressedData(type.GetNumber());
+            }
+
+            void WriteMethodInstantiation(const ast::MethodType& type)
+            {
+                // GENRICINST (misspelling intentional, see ECMA-335 II.23.2.15, different from GENERICINST)
+                bytes_.AppendByte(0x0a);
+                // GenArgCount Type+
+                WriteTypeList(type.GetGenericTypes());
+            }
+
+        private:
+            void WriteClass(const ast::ClassType& type, uint32_t genericCount)
+            {
+                // CLASS | VALUETYPE
+                switch (type.GetClassKind())
+                {
+                    case ast::ClassType::ClassKind::VALUETYPE:
+                        bytes_.AppendByte(0x11);
+                        break;
+                    case ast::ClassType::ClassKind::CLASS:
+                        bytes_.AppendByte(0x12);
+                        break;
+                    default:
+                        throw UnknownClassKindException(type.GetClassKind());
+                }
+                // TypeDefOrRefOrSpecEncoded
+                bytes_.AppendToken(AddClassRequest(compiled_, type, genericCount));
+            }
+
+            void WriteTypeList(ast::TypeListPtr types)
+            {
+                bytes_.AppendCompressedData(types->GetSize());
+                for (uint16_t i = 0; i < types->GetSize(); ++i)
+                {
+                    types->GetItem(i)->Accept(*this);
+                }
+            }
+
+            CompiledSignature& compiled_;
+            SignatureTemplate& bytes_;
+        };
+
+        // finds (or adds) the request that produces a type's token
+        class RequestBuilder : public ast::TypeVisitor
+        {
+        public:
+            RequestBuilder(CompiledSignature& compiled) : compiled_(compiled), request_(CompiledSignature::npos) {}
+
+            size_t GetRequest() const
+            {
+                return request_;
+            }
+
+            virtual void Visit(const ast::PrimitiveType& type) override
+            {
+                throw UnhandledTypeKindException(type.GetKind());
+            }
+
+            virtual void Visit(const ast::ArrayType& type) override
+            {
+                AddTypeSpec(type);
+            }
+
+            virtual void Visit(const ast::ClassType& type) override
+            {
+                request_ = AddClassRequest(compiled_, type, 0);
+            }
+
+            virtual void Visit(const ast::GenericType& type) override
+            {
+                AddTypeSpec(type);
+            }
+
+            virtual void Visit(const ast::MethodType& type) override
+            {
+                // the signature's types are requested before the type the method belongs to
+                TokenRequest memberRef(TokenRequest::Kind::kMEMBERREF);
+                BlobWriter signature(compiled_, memberRef.signature_);
+                type.Accept(signature);
+                type.GetTargetType()->Accept(*this);
+                memberRef.parent_ = request_;
+                memberRef.name_ = type.GetMethodName();
+                request_ = AddRequest(compiled_, memberRef);
+
+                if (type.GetGenericTypes()->GetSize() == 0) return;
+
+                TokenRequest methodSpec(TokenRequest::Kind::kMETHODSPEC);
+                methodSpec.parent_ = request_;
+                BlobWriter instantiation(compiled_, methodSpec.signature_);
+                instantiation.WriteMethodInstantiation(type);
+                request_ = AddRequest(compiled_, methodSpec);
+            }
+
+            virtual void Visit(const ast::GenericParamType& type) override
+            {
+                throw UnhandledTypeKindException(type.GetKind());
+            }
+
+        private:
+            void AddTypeSpec(const ast::Type& type)
+            {
+                TokenRequest typeSpec(TokenRequest::Kind::kTYPESPEC);
+                BlobWriter writer(compiled_, typeSpec.signature_);
+                type.Accept(writer);
+                request_ = AddRequest(compiled_, typeSpec);
+            }
+
+            CompiledSignature& compiled_;
+            size_t request_;
+        };
+    };
+}}
@@ -0,0 +1,205 @@
+/*
+* Copyright 2020 New Relic Corporation. All rights reserved.
+* SPDX-License-Identifier: Apache-2.0
+*/
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+#include <cor.h>
+#include <corprof.h>
+#include "../Common/OpenAddressingMap.h"
+
+namespace NewRelic {
+    namespace Profiler {
+        namespace ThreadProfiler
+        {
+            //!!!MARSHALED LAYOUT!!!
+            //This structure is marshaled by the managed code.  Do not change without updating the managed marshaling code.
+            //One node of the call tree returned from SwapCallTree.  Node 0 is the root, it has no function and its hit count is
+            //the number of stacks sampled.  The root's children have no function either, there's one for each tag the sampled threads
+            //had, zero for untagged threads, and the stacks sampled with that tag hang under it.  A node's parent always comes before it.
+            //The hit counts are the wall clock view of the tree, the CPU times the CPU view.
+            struct alignas(uint64_t) MarshaledCallTreeNode
+            {
+                //the FunctionID, widened so the layout doesn't depend on how 32 bit compilers align the fields after it
+                uint64_t functionId;
+                //the tag of the samples under this node
+                uint64_t tag;
+                //CPU time the sampled threads used since they were last sampled, for samples whose stack passed through this node
+                uint64_t cpuTimeNanoseconds;
+                //the same for samples whose stack ended at this node
+                uint64_t selfCpuTimeNanoseconds;
+                int32_t parentIndex;
+                //samples whose stack passed through this node
+                int32_t hitCount;
+                //samples whose stack ended at this node
+                int32_t selfHitCount;
+                //samples whose stack passed through this node taken from a thread that was running rather than blocked
+                int32_t runningHitCount;
+            };
+            static_assert(sizeof(MarshaledCallTreeNode) == 48, "call tree nodes are marshaled, CallTreeNode.NativeSize has to match");
+
+            //Merges sampled stacks into a prefix tree that counts how often each call path was seen, grouped by the tag the sampled
+            //thread had.  The nodes and the index used to find a node's children are allocated up front, so adding a stack never
+            //allocates.  Once the tree is full, paths it doesn't have yet are cut short at the deepest node it does have.
+            //
+            //Not thread safe.
+            class CallTree
+            {
+            public:
+                explicit CallTree(std::size_t maxNodes) :
+                    _maxNodes(maxNodes),
+                    //twice as many slots as nodes keeps the index under its maximum load factor, so it never grows
+                    _children(maxNodes * 2)
+                {
+                    _nodes.reserve(maxNodes);
+                    clear();
+                }
+
+                //adds one stack sampled from a thread with the given tag, weighed by the CPU time the thread used since it was last sampled.
+                //  The frames are given from the root of the stack to its leaf.
+                template <typename RootFirstIterator>
+                void add_stack(std::uint64_t tag, std::uint64_t cpuTimeNanoseconds, bool running, RootFirstIterator frame, RootFirstIterator end)
+                {
+                    const auto passThrough = [&](std::uint32_t index) {
+                        auto& node = _nodes[index];
+                        ++node.hitCount;
+                        node.cpuTimeNanoseconds += cpuTimeNanoseconds;
+                        node.runningHitCount += running ? 1 : 0;
+                    };
+                    const auto endAt = [&](std::uint32_t index) {
+                        auto& node = _nodes[index];
+                        ++node.selfHitCount;
+                        node.selfCpuTimeNanoseconds += cpuTimeNanoseconds;
+                    };
+
+                    ++_sampleCount;
+                    auto node = RootIndex;
+                    passThrough(node);
+                    const auto tagNode = find_or_add_child(node, tag, 0, tag);
+                    if (tagNode == NoNode)
+                    {
+                        ++_truncatedCount;
+                        endAt(node);
+                        return;
+                    }
+                    node = tagNode;
+                    passThrough(node);
+
+                    for (; frame != end; ++frame)
+                    {
+                        //frames without a function id are native code
+                        if (*frame == 0)
+                        {
+                            continue;
+                        }
+
+                        const auto child = find_or_add_child(node, *frame, *frame, tag);
+                        if (child == NoNode)
+                        {
+                            ++_truncatedCount;
+                            break;
+                        }
+                        node = child;
+                        passThrough(node);
+                    }
+                    endAt(node);
+                }
+
+                //copies the tree into the marshal-ready layout
+                void marshal(std::vector<MarshaledCallTreeNode>& marshaled) const
+                {
+                    marshaled.clear();
+                    marshaled.reserve(_nodes.size());
+                    for (const auto& node : _nodes)
+                    {
+                        marshaled.push_back(MarshaledCallTreeNode{ node.functionId, node.tag, node.cpuTimeNanoseconds, node.selfCpuTimeNanoseconds,
+                            static_cast<int32_t>(node.parentIndex), static_cast<int32_t>(node.hitCount), static_cast<int32_t>(node.selfHitCount),
+                            static_cast<int32_t>(node.runningHitCount) });
+                    }
+                }
+
+                //empties the tree, keeping what it has allocated
+                void clear()
+                {
+                    _nodes.clear();
+                    _nodes.push_back(Node{ 0, 0, -1, 0, 0, 0, 0, 0 });
+                    _children.Clear();
+                    _sampleCount = 0;
+                    _truncatedCount = 0;
+                }
+
+                std::size_t node_count() const noexcept
+                {
+                    return _nodes.size();
+                }
+
+                std::uint64_t sample_count() const noexcept
+                {
+                    return _sampleCount;
+                }
+
+                //stacks that were cut short because the tree was full
+                std::uint64_t truncated_count() const noexcept
+                {
+                    return _truncatedCount;
+                }
+
+            private:
+                static constexpr std::uint32_t RootIndex = 0;
+                static constexpr std::uint32_t NoNode = UINT32_MAX;
+
+                struct Node
+                {
+                    FunctionID functionId;
+                    std::uint64_t tag;
+                    std::int64_t parentIndex;
+                    std::uint32_t hitCount;
+                    std::uint32_t selfHitCount;
+                    std::uint32_t runningHitCount;
+                    std::uint64_t cpuTimeNanoseconds;
+                    std::uint64_t selfCpuTimeNanoseconds;
+                };
+
+                //a child is found by its parent and its function id, or for the root's children, their tag
+                using ChildKey = std::pair<std::uint32_t, std::uint64_t>;
+
+                struct ChildKeyHash
+                {
+                    std::size_t operator()(const ChildKey& key) const noexcept
+                    {
+                        return std::hash<std::uint64_t>()(key.second) * 31 + key.first;
+                    }
+                };
+
+                std::uint32_t find_or_add_child(std::uint32_t parent, std::uint64_t childKey, FunctionID functionId, std::uint64_t tag)
+                {
+                    const ChildKey key(parent, childKey);
+                    const auto existing = _children.Find(key);
+                    if (existing != nullptr)
+                    {
+                        return *existing;
+                    }
+
+                    if (_nodes.size() >= _maxNodes)
+                    {
+                        return NoNode;
+                    }
+
+                    const auto child = static_cast<std::uint32_t>(_nodes.size());
+                    _nodes.push_back(Node{ functionId, tag, parent, 0, 0, 0, 0, 0 });
+                    _children.Insert(key, child);
+                    return child;
+                }
+
+                const std::size_t _maxNodes;
+                std::vector<Node> _nodes;
+                OpenAddressingMap<ChildKey, std::uint32_t, ChildKeyHash> _children;
+                std::uint64_t _sampleCount{};
+                std::uint64_t _truncatedCount{};
+            };
+        } // namespace ThreadProfiler
+    } // namespace Profiler
+} // namespace NewRelic
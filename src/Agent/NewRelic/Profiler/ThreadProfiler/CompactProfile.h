@@ -0,0 +1,187 @@
+/*
+* Copyright 2020 New Relic Corporation. All rights reserved.
+* SPDX-License-Identifier: Apache-2.0
+*/
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include <cor.h>
+#include <corprof.h>
+
+namespace NewRelic {
+    namespace Profiler {
+        namespace ThreadProfiler
+        {
+            //!!!MARSHALED LAYOUT!!!
+            //The buffer returned from RequestCompactProfile is read by the managed code.  Do not change it without bumping
+            //  CompactProfileVersion and updating the managed reader.
+            //
+            //  CompactProfileHeader
+            //  CompactProfileThread[threadCount]   at threadTableOffset
+            //  CompactProfileStack[stackCount]     at stackTableOffset
+            //  frame data                          at frameDataOffset, frameDataSize bytes
+            //
+            //Offsets are in bytes from the start of the buffer.  As with RequestProfile, only the threads DoStackSnapshot succeeded on
+            //  are in the profile, so a thread with no managed frames is left out.  Threads with the same stack share one entry of the
+            //  stack table.  A stack's frames are in the order they were walked, leaf first, the same as RequestProfile.  Each frame is
+            //  stored as the difference from the frame before it (the first from zero), zigzag encoded and written 7 bits at a time,
+            //  low bits first, with the high bit set on every byte but the last.
+            static constexpr uint32_t CompactProfileMagic = 0x5043524E; // "NRCP"
+            static constexpr uint16_t CompactProfileVersion = 1;
+
+            struct CompactProfileHeader
+            {
+                uint32_t magic;
+                uint16_t version;
+                uint16_t headerSize;
+                uint32_t threadCount;
+                uint32_t stackCount;
+                uint32_t threadTableOffset;
+                uint32_t stackTableOffset;
+                uint32_t frameDataOffset;
+                uint32_t frameDataSize;
+            };
+
+            struct CompactProfileThread
+            {
+                uint64_t threadId;
+                int32_t hresult;
+                //-1 when the thread's stack isn't reported because looking up one of its function names failed, hresult says why
+                int32_t stackIndex;
+            };
+
+            struct CompactProfileStack
+            {
+                //from the start of the frame data
+                uint32_t frameOffset;
+                uint32_t frameCount;
+            };
+
+            static_assert(sizeof(CompactProfileHeader) == 32, "the compact profile header is marshaled");
+            static_assert(sizeof(CompactProfileThread) == 16, "compact profile threads are marshaled");
+            static_assert(sizeof(CompactProfileStack) == 8, "compact profile stacks are marshaled");
+
+            //Builds the compact profile buffer one thread at a time.  Keeps what it has allocated between profiles.
+            class CompactProfileWriter
+            {
+            public:
+                void clear()
+                {
+                    _threads.clear();
+                    _stacks.clear();
+                    _frameData.clear();
+                    _stackIndex.clear();
+                }
+
+                //add a thread whose stack can't be reported
+                void add_thread(ThreadID threadId, HRESULT hresult)
+                {
+                    _threads.push_back(CompactProfileThread{ threadId, hresult, -1 });
+                }
+
+                //add a thread and its stack, the frames are in walk order
+                template <typename FrameIterator>
+                void add_thread(ThreadID threadId, HRESULT hresult, FrameIterator frame, FrameIterator end)
+                {
+                    _encoded.clear();
+                    uint32_t frameCount{};
+                    uint64_t previous{};
+                    for (; frame != end; ++frame, ++frameCount)
+                    {
+                        const auto current = static_cast<uint64_t>(*frame);
+                        const auto delta = static_cast<int64_t>(current - previous);
+                        previous = current;
+                        auto zigzag = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+                        while (zigzag >= 0x80)
+                        {
+                            _encoded.push_back(static_cast<uint8_t>(zigzag | 0x80));
+                            zigzag >>= 7;
+                        }
+                        _encoded.push_back(static_cast<uint8_t>(zigzag));
+                    }
+
+                    _threads.push_back(CompactProfileThread{ threadId, hresult, InternStack(frameCount) });
+                }
+
+                size_t thread_count() const noexcept
+                {
+                    return _threads.size();
+                }
+
+                size_t stack_count() const noexcept
+                {
+                    return _stacks.size();
+                }
+
+                //lay the profile out in buffer
+                void write(std::vector<uint8_t>& buffer) const
+                {
+                    CompactProfileHeader header{};
+                    header.magic = CompactProfileMagic;
+                    header.version = CompactProfileVersion;
+                    header.headerSize = sizeof(CompactProfileHeader);
+                    header.threadCount = static_cast<uint32_t>(_threads.size());
+                    header.stackCount = static_cast<uint32_t>(_stacks.size());
+                    header.threadTableOffset = sizeof(CompactProfileHeader);
+                    header.stackTableOffset = header.threadTableOffset + static_cast<uint32_t>(_threads.size() * sizeof(CompactProfileThread));
+                    header.frameDataOffset = header.stackTableOffset + static_cast<uint32_t>(_stacks.size() * sizeof(CompactProfileStack));
+                    header.frameDataSize = static_cast<uint32_t>(_frameData.size());
+
+                    buffer.resize(header.frameDataOffset + _frameData.size());
+                    std::memcpy(buffer.data(), &header, sizeof(header));
+                    CopyTo(buffer, header.threadTableOffset, _threads);
+                    CopyTo(buffer, header.stackTableOffset, _stacks);
+                    CopyTo(buffer, header.frameDataOffset, _frameData);
+                }
+
+            private:
+                //return the index of the stack just encoded, adding it to the stack table if no other thread has it
+                int32_t InternStack(uint32_t frameCount)
+                {
+                    //FNV-1a
+                    uint64_t hash = 14695981039346656037ull;
+                    for (const auto byte : _encoded)
+                    {
+                        hash = (hash ^ byte) * 1099511628211ull;
+                    }
+
+                    const auto candidates = _stackIndex.equal_range(hash);
+                    for (auto candidate = candidates.first; candidate != candidates.second; ++candidate)
+                    {
+                        const auto& stack = _stacks[candidate->second];
+                        const auto stackEnd = candidate->second + 1 < _stacks.size() ? _stacks[candidate->second + 1].frameOffset : _frameData.size();
+                        if (stack.frameCount == frameCount && stackEnd - stack.frameOffset == _encoded.size() &&
+                            std::equal(_encoded.begin(), _encoded.end(), _frameData.begin() + stack.frameOffset))
+                        {
+                            return static_cast<int32_t>(candidate->second);
+                        }
+                    }
+
+                    const auto index = static_cast<uint32_t>(_stacks.size());
+                    _stacks.push_back(CompactProfileStack{ static_cast<uint32_t>(_frameData.size()), frameCount });
+                    _frameData.insert(_frameData.end(), _encoded.begin(), _encoded.end());
+                    _stackIndex.emplace(hash, index);
+                    return static_cast<int32_t>(index);
+                }
+
+                template <typename T>
+                static void CopyTo(std::vector<uint8_t>& buffer, uint32_t offset, const std::vector<T>& items)
+                {
+                    if (!items.empty())
+                    {
+                        std::memcpy(buffer.data() + offset, items.data(), items.size() * sizeof(T));
+                    }
+                }
+
+                std::vector<CompactProfileThread> _threads;
+                std::vector<CompactProfileStack> _stacks;
+                std::vector<uint8_t> _frameData;
+                std::vector<uint8_t> _encoded;
+                std::unordered_multimap<uint64_t, uint32_t> _stackIndex;
+            };
+        } // namespace ThreadProfiler
+    } // namespace Profiler
+} // namespace NewRelic
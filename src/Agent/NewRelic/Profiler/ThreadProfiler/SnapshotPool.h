@@ -0,0 +1,168 @@
+/*
+* Copyright 2020 New Relic Corporation. All rights reserved.
+* SPDX-License-Identifier: Apache-2.0
+*/
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NewRelic {
+    namespace Profiler {
+        namespace ThreadProfiler
+        {
+            //Helper threads that are started, and initialized, before they're needed so a job can be split across them while the
+            //  runtime is suspended.  The thread calling Run is lane 0, each helper thread is one of the lanes after it.  Helpers
+            //  wait on a condition variable between jobs, waking them doesn't allocate.
+            //
+            //Start, Run and Stop are called from one thread.
+            class SnapshotPool
+            {
+            public:
+                SnapshotPool() = default;
+                ~SnapshotPool()
+                {
+                    Stop();
+                }
+                SnapshotPool(const SnapshotPool&) = delete;
+                SnapshotPool& operator=(const SnapshotPool&) = delete;
+
+                //start laneCount - 1 helper threads, each of which calls initializeThread once before it takes any work
+                void Start(std::size_t laneCount, std::function<void()> initializeThread)
+                {
+                    Stop();
+                    std::uint64_t generation{};
+                    {
+                        std::lock_guard<std::mutex> l(_mtx);
+                        _stopping = false;
+                        generation = _generation;
+                    }
+                    //the helpers start from the current generation, otherwise a pool restarted after a job would wake them for the old one
+                    for (std::size_t lane = 1; lane < laneCount; ++lane)
+                    {
+                        _helpers.emplace_back(&SnapshotPool::HelperThreadStart, this, lane, generation, initializeThread);
+                    }
+                }
+
+                //lanes a job can be split across, the calling thread included
+                std::size_t GetLaneCount() const noexcept
+                {
+                    return _helpers.size() + 1;
+                }
+
+                //call job(lane) once for every lane below laneCount, all at once, and return when they've all finished.  job shouldn't
+                //  throw, anything it throws on a helper thread is dropped.  job is called through a pointer so running it never allocates.
+                template <typename Job>
+                void Run(std::size_t laneCount, Job& job)
+                {
+                    laneCount = std::min(laneCount, GetLaneCount());
+                    if (laneCount <= 1)
+                    {
+                        job(0);
+                        return;
+                    }
+
+                    {
+                        std::lock_guard<std::mutex> l(_mtx);
+                        _job = &job;
+                        _invokeJob = [](void* context, std::size_t lane) { (*static_cast<Job*>(context))(lane); };
+                        _activeLanes = laneCount;
+                        _pendingLanes = laneCount - 1;
+                        ++_generation;
+                    }
+                    _cv_work.notify_all();
+
+                    try
+                    {
+                        job(0);
+                    }
+                    catch (...)
+                    {
+                        WaitForHelpers();
+                        throw;
+                    }
+                    WaitForHelpers();
+                }
+
+                //stop and join the helper threads
+                void Stop()
+                {
+                    {
+                        std::lock_guard<std::mutex> l(_mtx);
+                        _stopping = true;
+                    }
+                    _cv_work.notify_all();
+                    for (auto& helper : _helpers)
+                    {
+                        helper.join();
+                    }
+                    _helpers.clear();
+                }
+
+            private:
+                void WaitForHelpers()
+                {
+                    std::unique_lock<std::mutex> l(_mtx);
+                    _cv_done.wait(l, [this]() noexcept { return _pendingLanes == 0; });
+                    _job = nullptr;
+                }
+
+                void HelperThreadStart(std::size_t lane, std::uint64_t generationSeen, std::function<void()> initializeThread)
+                {
+                    if (initializeThread)
+                    {
+                        initializeThread();
+                    }
+
+                    std::unique_lock<std::mutex> l(_mtx);
+                    for (;;)
+                    {
+                        _cv_work.wait(l, [&]() noexcept { return _stopping || _generation != generationSeen; });
+                        if (_stopping)
+                        {
+                            return;
+                        }
+
+                        generationSeen = _generation;
+                        if (lane >= _activeLanes)
+                        {
+                            continue;
+                        }
+
+                        const auto job = _job;
+                        const auto invokeJob = _invokeJob;
+                        l.unlock();
+                        try
+                        {
+                            invokeJob(job, lane);
+                        }
+                        catch (...)
+                        {
+                        }
+                        l.lock();
+
+                        if (--_pendingLanes == 0)
+                        {
+                            _cv_done.notify_one();
+                        }
+                    }
+                }
+
+                std::mutex _mtx;
+                std::condition_variable _cv_work;
+                std::condition_variable _cv_done;
+                void* _job{};
+                void (*_invokeJob)(void* context, std::size_t lane){};
+                std::size_t _activeLanes{};
+                std::size_t _pendingLanes{};
+                std::uint64_t _generation{};
+                bool _stopping{};
+                std::vector<std::thread> _helpers;
+            };
+        } // namespace ThreadProfiler
+    } // namespace Profiler
+} // namespace NewRelic
@@ -0,0 +1,58 @@
+/*
+* Copyright 2020 New Relic Corporation. All rights reserved.
+* SPDX-License-Identifier: Apache-2.0
+*/
+#pragma once
+#include <chrono>
+#include <cstdint>
+#ifdef PAL_STDCPP_COMPAT
+#include <time.h>
+#endif
+#include <cor.h>
+
+namespace NewRelic {
+    namespace Profiler {
+        namespace ThreadProfiler
+        {
+            //Read the CPU time, user and kernel, that a thread of this process has used, from the id ThreadAssignedToOSThread reported for
+            //  it.  Returns false if it can't be read, such as once the thread has ended.
+            inline bool TryGetThreadCpuTime(DWORD osThreadId, std::chrono::nanoseconds& cpuTime) noexcept
+            {
+                if (osThreadId == 0)
+                {
+                    return false;
+                }
+#ifdef PAL_STDCPP_COMPAT
+                //on Linux the OS thread id is the kernel's thread id.  The clock of a thread's CPU time is named the way
+                //  pthread_getcpuclockid names it: the inverted thread id shifted past the per thread flag (4) and CPUCLOCK_SCHED (2).
+                const auto clockId = static_cast<clockid_t>((~static_cast<uint32_t>(osThreadId) << 3) | 6);
+                timespec time{};
+                if (clock_gettime(clockId, &time) != 0)
+                {
+                    return false;
+                }
+                cpuTime = std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+                return true;
+#else
+                const auto thread = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, osThreadId);
+                if (thread == nullptr)
+                {
+                    return false;
+                }
+                FILETIME creationTime{}, exitTime{}, kernelTime{}, userTime{};
+                const auto succeeded = GetThreadTimes(thread, &creationTime, &exitTime, &kernelTime, &userTime);
+                CloseHandle(thread);
+                if (!succeeded)
+                {
+                    return false;
+                }
+
+                //FILETIMEs count 100ns intervals
+                const auto toIntervals = [](const FILETIME& time) noexcept { return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime; };
+                cpuTime = std::chrono::nanoseconds((toIntervals(kernelTime) + toIntervals(userTime)) * 100);
+                return true;
+#endif
+            }
+        } // namespace ThreadProfiler
+    } // namespace Profiler
+} // namespace NewRelic
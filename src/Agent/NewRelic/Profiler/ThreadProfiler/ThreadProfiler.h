@@ -3,10 +3,15 @@
 * SPDX-License-Identifier: Apache-2.0
 */
 #pragma once
+#include <algorithm>
+#include <chrono>
 #include <condition_variable>
+#include <iterator>
 #include <mutex>
 #include <atomic>
+#include <set>
 #include <thread>
+#include <unordered_map>
 
 #include <cor.h>
 
@@ -15,6 +20,12 @@
 
 #pragma warning(pop)
 
+#include "CallTree.h"
+#include "CompactProfile.h"
+#include "SnapshotPool.h"
+#include "ThreadCpuClock.h"
+#include "ThreadRegistry.h"
+#include "ThreadTags.h"
 #include "namecache.h"
 #include "../Logging/Logger.h"
 
@@ -22,20 +33,54 @@
 
 /*
 GLOSSARY
-StackFrame        A structure describing the FunctionID of the method, the mdTypeDef of the type the method is attached to and their associated names
+StackFrame        A structure holding the FunctionID of the method
 StackWalk        A array of StackFrames (preallocated)
 ThreadProfile    One is created for each managed thread during the RequestProfile call. It contains the managed thread id, any error code, a StackWalk
-and an indicator of the last valid entry in the StackWalk.  It also serves as the context for the snapshot callback; as such, it contains
-references to the name cache and profiling COM interface.
+and an indicator of the last valid entry in the StackWalk.  It also serves as the context for the snapshot callback.
 Profile            A collection of ThreadProfile(s) for all current managed threads.
 ActiveThreadID  A collection of ThreadIDs for all current managed threads.
+ThreadRegistry  The managed threads the runtime has reported through the thread callbacks, with their OS thread ids.
+ThreadTags      The tag each managed thread has set on itself, such as the id of the transaction it's working on.
+SnapshotLane    One of the threads a snapshot is split across.  Each has its own StackWalk and collects its own results while the runtime is suspended.
 
 CAVEATS
 Due to the requirement of not using dynamically allocated memory or taking any locks during the snapshot callback, the data structures are preallocated for use during profiling.
 Data structures that use dynamically allocated memory can be read, but no operations may take place on them that might require a lock to be taken (_ITERATOR_DEBUG_LEVEL 2 as an example)
+The snapshot callback only records FunctionIDs.  Type and method names are looked up once the runtime has been resumed, so the metadata calls don't
+lengthen the time the application is paused.
 */
 namespace NewRelic { namespace Profiler { namespace ThreadProfiler
 {
+    //!!!MARSHALED LAYOUT!!!
+    //This structure is marshaled by the managed code.  Do not change without updating the managed marshaling code.
+    //How long a profile, or the samples merged into a call tree, kept the runtime suspended and how long the names took to resolve
+    //  once it was resumed.  Returned by GetProfileTimings and GetCallTreeTimings.
+    struct ProfileTimings
+    {
+        //1 for a profile, the number of samples for a call tree
+        uint64_t snapshotCount;
+        uint64_t threadCount;
+        uint64_t pauseCount;
+        uint64_t totalPauseMicroseconds;
+        uint64_t longestPauseMicroseconds;
+        //from the first suspend to the last resume, including the time between pauses
+        uint64_t snapshotMicroseconds;
+        uint64_t resolvedFunctionCount;
+        uint64_t resolveMicroseconds;
+
+        void add(const ProfileTimings& other) noexcept
+        {
+            snapshotCount += other.snapshotCount;
+            threadCount += other.threadCount;
+            pauseCount += other.pauseCount;
+            totalPauseMicroseconds += other.totalPauseMicroseconds;
+            longestPauseMicroseconds = std::max(longestPauseMicroseconds, other.longestPauseMicroseconds);
+            snapshotMicroseconds += other.snapshotMicroseconds;
+            resolvedFunctionCount += other.resolvedFunctionCount;
+            resolveMicroseconds += other.resolveMicroseconds;
+        }
+    };
+
     class ThreadProfilerBase
     {
     public:
@@ -75,6 +120,76 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
             return E_NOTIMPL;
         }
 
+        virtual void ModuleUnloaded(ModuleID /*moduleId*/) noexcept
+        {}
+
+        virtual void SetMaxPauseInMicroseconds(uint32_t /*maxPauseInMicroseconds*/) noexcept
+        {}
+
+        virtual HRESULT ThreadCreated(ThreadID /*threadId*/) noexcept
+        {
+            return E_NOTIMPL;
+        }
+
+        virtual HRESULT ThreadAssignedToOSThread(ThreadID /*threadId*/, DWORD /*osThreadId*/) noexcept
+        {
+            return E_NOTIMPL;
+        }
+
+        virtual HRESULT SetCurrentThreadTag(uint64_t /*tag*/) noexcept
+        {
+            return E_NOTIMPL;
+        }
+
+        virtual void SetTaggedThreadsOnly(bool /*taggedThreadsOnly*/) noexcept
+        {}
+
+        virtual HRESULT RequestCompactProfile(int /*version*/, void** profile, int* length) noexcept
+        {
+            if (profile)
+            {
+                *profile = nullptr;
+            }
+            if (length)
+            {
+                *length = 0;
+            }
+            return E_NOTIMPL;
+        }
+
+        virtual HRESULT StartContinuousProfiling(int /*samplesPerSecond*/) noexcept
+        {
+            return E_NOTIMPL;
+        }
+
+        virtual HRESULT StopContinuousProfiling() noexcept
+        {
+            return E_NOTIMPL;
+        }
+
+        virtual HRESULT SwapCallTree(void** nodes, int* length) noexcept
+        {
+            if (nodes)
+            {
+                *nodes = nullptr;
+            }
+            if (length)
+            {
+                *length = 0;
+            }
+            return E_NOTIMPL;
+        }
+
+        virtual HRESULT GetProfileTimings(ProfileTimings* /*timings*/) noexcept
+        {
+            return E_NOTIMPL;
+        }
+
+        virtual HRESULT GetCallTreeTimings(ProfileTimings* /*timings*/) noexcept
+        {
+            return E_NOTIMPL;
+        }
+
         ThreadProfilerBase() noexcept = default;
         virtual ~ThreadProfilerBase() noexcept = default;
         ThreadProfilerBase(const ThreadProfilerBase&) = delete;
@@ -132,7 +247,7 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
                 return E_INVALIDARG;
             }
 
-            if (!_marshaledProfiles.empty())
+            if (!_marshaledProfiles.empty() || !_compactProfile.empty())
             {
                 return E_FAIL;
             }
@@ -182,10 +297,72 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
             return S_OK;
         } //RequestProfile
 
-        //Release any data cached by a prior call to RequestProfile
+        //Like RequestProfile, but the profile is returned in one buffer laid out as described in CompactProfile.h, length is its size in
+        //  bytes.  version is the layout the caller reads, only CompactProfileVersion is supported.  The buffer is valid until
+        //  ReleaseProfile is called.
+        HRESULT RequestCompactProfile(int version, void** profile, int* length) noexcept override
+        {
+            if (nullptr == profile || nullptr == length)
+            {
+                return E_INVALIDARG;
+            }
+
+            if (version != CompactProfileVersion)
+            {
+                LogDebug(L"TP: ", __func__, L" called for version ", version, L", only version ", CompactProfileVersion, L" is supported");
+                return E_INVALIDARG;
+            }
+
+            if (!_marshaledProfiles.empty() || !_compactProfile.empty())
+            {
+                return E_FAIL;
+            }
+
+            if (!_corProfilerInfo)
+            {
+                LogDebug(L"TP: ", __func__, L" called without proper initialization. (corProfilerInfo)");
+                return E_UNEXPECTED;
+            }
+
+            try
+            {
+#ifdef PAL_STDCPP_COMPAT
+                if (!_corProfilerInfo10) {
+                    LogDebug(L"TP: ", __func__, L" called without proper initialization. (corProfilerInfo10)");
+                    return E_UNEXPECTED;
+                }
+#endif
+                Start();
+
+                _compactProfileRequested.store(true);
+                SignalProfileRequested();
+
+                WaitForProfileCompletedOrShutdown();
+
+                if (HasShutdownBeenRequested())
+                {
+                    *length = 0;
+                    *profile = nullptr;
+                    LogTrace(L"The thread profile was aborted.");
+
+                    return E_ABORT;
+                }
+
+                *length = static_cast<int>(_compactProfile.size());
+                *profile = _compactProfile.data();
+            }
+            catch (const std::exception&)
+            {
+                return E_UNEXPECTED;
+            }
+            return S_OK;
+        }
+
+        //Release any data cached by a prior call to RequestProfile or RequestCompactProfile
         void ReleaseProfile() noexcept override
         {
             _marshaledProfiles.clear();
+            _compactProfile.clear();
         }
 
         //Get the type and method names for each of the provided FunctionIDs
@@ -200,10 +377,16 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
             {
                 ReleaseGetTypeAndMethodNamesResults();
                 _marshaledFunctionIDTypeNameMethodNames.reserve(length);
+
+                //the worker thread can add to the name cache at any time while continuous profiling is on, so the names are copied
+                //  rather than pointed to.  Reserving up front keeps the copies where the marshaled pointers say they are.
+                std::lock_guard<std::mutex> l(_mtx_nameCache);
+                _marshaledNames.reserve(length);
                 for (int idx=0; idx != length; ++idx)
                 {
                     const auto fid = functionIds[idx];
-                    const auto& typeAndMethodNames = _nameCache[fid];
+                    _marshaledNames.push_back(_nameCache[fid]);
+                    const auto& typeAndMethodNames = _marshaledNames.back();
                     _marshaledFunctionIDTypeNameMethodNames.emplace_back(fid, typeAndMethodNames.TypeName(), typeAndMethodNames.MethodName());
                 }
                 *results = _marshaledFunctionIDTypeNameMethodNames.data();
@@ -219,6 +402,139 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
             return S_OK;
         }
 
+        //Sample every managed thread samplesPerSecond times a second on the worker thread, merging the stacks into a call tree that
+        //  SwapCallTree hands back.  Calling it again while it is running changes the rate.  RequestProfile can still be called.
+        HRESULT StartContinuousProfiling(int samplesPerSecond) noexcept override
+        {
+            if (samplesPerSecond < MinSamplesPerSecond || samplesPerSecond > MaxSamplesPerSecond)
+            {
+                return E_INVALIDARG;
+            }
+
+            if (!_corProfilerInfo)
+            {
+                LogDebug(L"TP: ", __func__, L" called without proper initialization. (corProfilerInfo)");
+                return E_UNEXPECTED;
+            }
+
+            try
+            {
+#ifdef PAL_STDCPP_COMPAT
+                if (!_corProfilerInfo10) {
+                    LogDebug(L"TP: ", __func__, L" called without proper initialization. (corProfilerInfo10)");
+                    return E_UNEXPECTED;
+                }
+#endif
+                {
+                    std::lock_guard<std::mutex> l(_mtx_ProfileRequested);
+                    _samplingInterval = std::chrono::microseconds(1000000 / samplesPerSecond);
+                    _nextSample = std::chrono::steady_clock::now();
+                }
+                Start();
+                _cv_ProfileRequested.notify_one();
+                LogInfo(L"TP: continuous profiling at ", samplesPerSecond, L" samples per second");
+            }
+            catch (const std::exception&)
+            {
+                return E_UNEXPECTED;
+            }
+            return S_OK;
+        }
+
+        //Stop sampling.  The call tree keeps what was sampled until the next SwapCallTree.
+        HRESULT StopContinuousProfiling() noexcept override
+        {
+            try
+            {
+                {
+                    std::lock_guard<std::mutex> l(_mtx_ProfileRequested);
+                    _samplingInterval = std::chrono::microseconds::zero();
+                }
+                _cv_ProfileRequested.notify_one();
+                LogInfo(L"TP: continuous profiling stopped");
+            }
+            catch (const std::exception&)
+            {
+                return E_UNEXPECTED;
+            }
+            return S_OK;
+        }
+
+        //Return the call tree sampled since the previous call and start a new one.  The nodes are valid until the next call.  Their
+        //  names come from GetTypeAndMethodNames, which already knows every function in the tree.
+        HRESULT SwapCallTree(void** nodes, int* length) noexcept override
+        {
+            if (nullptr == nodes || nullptr == length)
+            {
+                return E_INVALIDARG;
+            }
+
+            try
+            {
+                std::lock_guard<std::mutex> l(_mtx_callTree);
+                _marshaledCallTree.clear();
+                _swappedCallTreeTimings = _callTreeTimings;
+                _callTreeTimings = ProfileTimings{};
+                if (_callTree)
+                {
+                    LogDebug(L"TP: call tree of ", _callTree->sample_count(), L" stacks has ", _callTree->node_count(), L" nodes, ",
+                        _callTree->truncated_count(), L" stacks were cut short");
+                    _callTree->marshal(_marshaledCallTree);
+                    _callTree->clear();
+                }
+
+                *length = static_cast<int>(_marshaledCallTree.size());
+                *nodes = _marshaledCallTree.empty() ? nullptr : _marshaledCallTree.data();
+            }
+            catch (const std::bad_alloc&)
+            {
+                return E_OUTOFMEMORY;
+            }
+            catch (const std::exception&)
+            {
+                return E_UNEXPECTED;
+            }
+            return S_OK;
+        }
+
+        //Return the timings of the last profile taken for RequestProfile or RequestCompactProfile
+        HRESULT GetProfileTimings(ProfileTimings* timings) noexcept override
+        {
+            if (nullptr == timings)
+            {
+                return E_INVALIDARG;
+            }
+
+            std::lock_guard<std::mutex> l(_mtx_profileTimings);
+            *timings = _profileTimings;
+            return S_OK;
+        }
+
+        //Return the timings of the samples merged into the call tree the last SwapCallTree returned
+        HRESULT GetCallTreeTimings(ProfileTimings* timings) noexcept override
+        {
+            if (nullptr == timings)
+            {
+                return E_INVALIDARG;
+            }
+
+            std::lock_guard<std::mutex> l(_mtx_callTree);
+            *timings = _swappedCallTreeTimings;
+            return S_OK;
+        }
+
+        //Bound how long the runtime stays suspended while a profile or sample is taken.  Once a pause reaches maxPauseInMicroseconds
+        //  the runtime is resumed, and suspended again for the threads that haven't been snapshot yet.  A pause always snapshots at
+        //  least one thread per lane.  Zero, the default, snapshots every thread in one pause.
+        void SetMaxPauseInMicroseconds(uint32_t maxPauseInMicroseconds) noexcept override
+        {
+            _maxPauseInMicroseconds.store(maxPauseInMicroseconds);
+            if (maxPauseInMicroseconds != 0)
+            {
+                LogInfo(L"TP: the runtime will be suspended for at most ", maxPauseInMicroseconds, L"us at a time while threads are profiled");
+            }
+        }
+
         //terminate worker thread and free allocated resources.
         void Shutdown() noexcept override
         {
@@ -240,6 +556,15 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
                 ReleaseProfile();
                 ReleaseGetTypeAndMethodNamesResults();
                 _nameCache.clear();
+                _lanes.clear();
+                _activeThreads.clear();
+                _taggedThreadsOnly.store(false);
+                _threadCpuTimes.clear();
+                _samplingInterval = std::chrono::microseconds::zero();
+                _callTree.reset();
+                _marshaledCallTree.clear();
+                _compactProfileWriter.clear();
+                _compactProfileRequested.store(false);
                 _profileCompleted.store(false);
                 _profileRequested.store(false);
                 _shuttingDown.store(false);
@@ -249,12 +574,16 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
             }
         }
 
-        //called by the Profiler when a thread is on its way out...  We receive this notification because we called SetEventMask(COR_PRF_MONITOR_THREADS...) during Initialize.
-        HRESULT ThreadDestroyed(ThreadID /*threadId*/) noexcept override
+        //called by the Profiler when a thread is on its way out...  We receive this notification once the Profiler has set COR_PRF_MONITOR_THREADS for the first profile request.
+        //  Waiting for a snapshot in progress keeps the thread from being snapshot after it has been destroyed, and once it's out of
+        //  the registry no later pause will snapshot it.
+        HRESULT ThreadDestroyed(ThreadID threadId) noexcept override
         {
             try
             {
                 std::lock_guard<std::mutex> l(_mtx_snapshotInProgress);
+                _threadRegistry.Remove(threadId);
+                _threadTags.Remove(threadId);
             }
             catch (const std::exception& e)
             {
@@ -263,6 +592,90 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
             return S_OK;
         }
 
+        //called by the Profiler when the runtime creates a thread, once COR_PRF_MONITOR_THREADS is set.  It isn't snapshot until it starts.
+        HRESULT ThreadCreated(ThreadID threadId) noexcept override
+        {
+            try
+            {
+                _threadRegistry.Add(threadId);
+            }
+            catch (const std::exception& e)
+            {
+                LogWarn(L"Exception caught in ThreadCreated:", e.what());
+            }
+            return S_OK;
+        }
+
+        //called by the Profiler when a thread starts running on an OS thread, once COR_PRF_MONITOR_THREADS is set
+        HRESULT ThreadAssignedToOSThread(ThreadID threadId, DWORD osThreadId) noexcept override
+        {
+            try
+            {
+                _threadRegistry.AssignOSThread(threadId, osThreadId);
+            }
+            catch (const std::exception& e)
+            {
+                LogWarn(L"Exception caught in ThreadAssignedToOSThread:", e.what());
+            }
+            return S_OK;
+        }
+
+        //Tag the calling thread, such as with the id of the transaction it's working on, zero clears the tag.  Continuous samples are
+        //  grouped by tag, and with SetTaggedThreadsOnly only tagged threads are snapshot.  Doesn't allocate, and only locks the first time
+        //  a thread is tagged.  The thread callbacks have to be on so the tag is dropped when the thread is destroyed.
+        HRESULT SetCurrentThreadTag(uint64_t tag) noexcept override
+        {
+            if (!_corProfilerInfo)
+            {
+                return E_UNEXPECTED;
+            }
+
+            ThreadID threadId{};
+            const auto result = _corProfilerInfo->GetCurrentThreadID(&threadId);
+            if (FAILED(result))
+            {
+                return result;
+            }
+            return _threadTags.Set(threadId, tag) ? S_OK : E_OUTOFMEMORY;
+        }
+
+        //snapshot only tagged threads, or every thread, from the next pause on.  Snapshots then cost in proportion to the tagged threads,
+        //  so continuous profiling can sample them at a higher rate.
+        void SetTaggedThreadsOnly(bool taggedThreadsOnly) noexcept override
+        {
+            _taggedThreadsOnly.store(taggedThreadsOnly);
+            LogInfo(L"TP: ", taggedThreadsOnly ? L"only tagged threads" : L"every thread", L" will be profiled");
+        }
+
+        //called by the Profiler when a module starts unloading.  The name cache is only touched by the worker thread while
+        //  a profile is taken and by GetTypeAndMethodNames afterwards, so the module's names are dropped by the worker
+        //  thread before it takes the next profile.
+        void ModuleUnloaded(ModuleID moduleId) noexcept override
+        {
+            ++_moduleUnloadCount;
+            try
+            {
+                std::lock_guard<std::mutex> l(_mtx_unloadedModules);
+                if (_forgetAllNames)
+                {
+                    return;
+                }
+
+                //without profiling nothing drains this, so past a point it's cheaper to start the cache over
+                if (_unloadedModules.size() >= MaxUnloadedModulesTracked)
+                {
+                    _unloadedModules.clear();
+                    _forgetAllNames = true;
+                    return;
+                }
+                _unloadedModules.insert(moduleId);
+            }
+            catch (const std::exception& e)
+            {
+                LogWarn(L"Exception caught in ModuleUnloaded:", e.what());
+            }
+        }
+
         ThreadProfiler() = default;
         ~ThreadProfiler() = default;
         ThreadProfiler(const ThreadProfiler&) = delete;
@@ -282,6 +695,21 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
         //a guess at how many threads we will see.  This is used to preallocate containers that are one-per-thread.
         static constexpr size_t ThreadCountForReservation = 100;
 
+        //how many unloaded modules are remembered between profiles before the whole name cache is dropped instead
+        static constexpr size_t MaxUnloadedModulesTracked = 1024;
+
+        //the rates continuous profiling can sample at
+        static constexpr int MinSamplesPerSecond = 1;
+        static constexpr int MaxSamplesPerSecond = 1000;
+
+        //the most call paths the continuous profiling call tree holds between calls to SwapCallTree
+        static constexpr size_t MaxCallTreeNodes = 65536;
+
+        //the most threads that snapshot at once, and how many managed threads each has to have before another one is used.  A lane
+        //  costs a stack walk buffer and a thread that's parked between snapshots.
+        static constexpr size_t MaxSnapshotLanes = 8;
+        static constexpr size_t MinThreadsPerSnapshotLane = 32;
+
 #pragma endregion
 
 #pragma region Types
@@ -290,9 +718,6 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
         struct StackFrame
         {
             FunctionID functionId{};
-            mdTypeDef typeDef{};
-            PreallocTypeName typeName{};
-            PreallocMethodName methodName{};
 
             StackFrame() = default;
             StackFrame(const StackFrame&) = delete;
@@ -301,20 +726,33 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
             StackFrame& operator=(StackFrame&&) = delete;
         };
 
+        //the names are looked up after the snapshot, a frame only needs to hold what the snapshot callback writes
+        static_assert(sizeof(StackFrame) == sizeof(FunctionID), "StackFrame should only hold a FunctionID");
+
         //avoid dynamic memory allocation, create a array for the StackFrames.
         using StackWalk = std::array<StackFrame, MaxStackFramesSupported>;
 
+        //how much of the StackWalks a snapshot used and how it was split across lanes and pauses, reported with each profile
+        struct SnapshotFootprint
+        {
+            size_t threadCount{};
+            size_t laneCount{};
+            size_t frameCount{};
+            size_t deepestStack{};
+            size_t pauseCount{};
+            std::chrono::microseconds totalPause{};
+            std::chrono::microseconds longestPause{};
+        };
+
         //This structure is the unmarshaled version of a thread profile.  It also serves as the context value for the snapshot callback.
         struct ThreadProfile
         {
-            ICorProfilerInfo4* _corProfilerInfo;
-            NameCache& _nameCache;
             StackWalk& _stackwalk;
             StackWalk::iterator _frameNext{};
             HRESULT _errorCode{};
             ThreadID _managedTID;
-            ThreadProfile(ThreadID managedTID, ICorProfilerInfo4* corProfilerInfo, NameCache& nameCache, StackWalk& stackwalk) :
-                _managedTID(managedTID), _corProfilerInfo(corProfilerInfo), _nameCache(nameCache), _stackwalk(stackwalk), _frameNext(std::begin(_stackwalk))
+            ThreadProfile(ThreadID managedTID, StackWalk& stackwalk) :
+                _managedTID(managedTID), _stackwalk(stackwalk), _frameNext(std::begin(_stackwalk))
             {}
             ~ThreadProfile() = default;
             ThreadProfile(ThreadProfile&&) = default;
@@ -391,17 +829,70 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
         using MarshaledProfileCollection = std::vector<MarshaledThreadProfile>;
 #pragma endregion : data structures have been laid out to support marshaling by the managed code.
 
-        //collection of all managed threads (from corProfilerInfo->EnumThreads)
+        //collection of the managed threads to snapshot (from the thread registry)
         using ActiveThreadIDs = std::vector<ThreadID>;
 
-        //collect of ThreadProfiles one is created for each managed thread 
-        using ThreadProfiles = std::vector<ThreadProfile>;
-#pragma endregion 
+        //a thread profiled for RequestCompactProfile, its stack is [first, last) of its lane's profiledFrames
+        struct ProfiledThread
+        {
+            ThreadID threadId;
+            HRESULT hresult;
+            size_t first;
+            size_t last;
+        };
 
-#pragma region Data
-        //
-        //Shutdown
-        //
+        //a thread sampled for continuous profiling, its stack is [first, last) of its lane's sampledFrames.  The CPU time it used since
+        //  it was last sampled, and whether it was running, are filled in once the runtime has been resumed.
+        struct SampledStack
+        {
+            ThreadID threadId;
+            size_t first;
+            size_t last;
+            uint64_t tag;
+            std::chrono::nanoseconds cpuTime;
+            bool running;
+        };
+
+        //a thread's CPU time when it was last sampled
+        struct ThreadCpuTime
+        {
+            DWORD osThreadId;
+            std::chrono::nanoseconds cpuTime;
+            std::chrono::steady_clock::time_point sampledAt;
+        };
+
+        //what one snapshot thread works with.  Each lane has its own stack walk buffer and its own results, which are gathered up
+        //  once the runtime has been resumed.
+        struct SnapshotLane
+        {
+            //allocated the first time the lane is used and kept until Shutdown
+            std::unique_ptr<StackWalk> stackwalk;
+            SnapshotFootprint footprint;
+
+            //this pause's share of the threads, next is the first one the lane hasn't snapshot yet
+            ActiveThreadIDs::const_iterator first{};
+            ActiveThreadIDs::const_iterator next{};
+            ActiveThreadIDs::const_iterator last{};
+
+            //the threads this lane profiled for RequestProfile
+            MarshaledProfileCollection marshaledProfiles;
+
+            //the stacks this lane sampled, root first, and where each thread's stack starts and ends in sampledFrames with the thread's
+            //  tag.  Kept between samples so they stop allocating once they've grown to fit.
+            std::vector<FunctionID> sampledFrames;
+            std::vector<SampledStack> sampledStacks;
+
+            //the threads this lane profiled for RequestCompactProfile, with their stacks in walk order in profiledFrames.  Kept between
+            //  profiles like the samples.
+            std::vector<FunctionID> profiledFrames;
+            std::vector<ProfiledThread> profiledThreads;
+        };
+#pragma endregion 
+
+#pragma region Data
+        //
+        //Shutdown
+        //
         //set during shutdown.  All conditions managed by condition variable check this bool for shutdown.
         std::atomic<bool> _shuttingDown{ false };
 
@@ -420,11 +911,41 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
         std::atomic_bool _profileCompleted{};
 
         //
-        //Snapshot In Progress - manage signaling between the ThreadDestroyed callback and ProfileAllThreads to prevent threads from being 
+        //Snapshot In Progress - manage signaling between the ThreadDestroyed callback and SnapshotAllThreads to prevent threads from being 
         //destroyed during snapshot (prior to suspension)
         //
         mutable std::mutex _mtx_snapshotInProgress;
 
+        //
+        //Unloaded Modules - modules whose names have to be dropped from the name cache before the next profile
+        //
+        std::mutex _mtx_unloadedModules;
+        std::set<ModuleID> _unloadedModules;
+        bool _forgetAllNames{};
+
+        //counts every module unload, names aren't resolved for a profile taken before an unload that hasn't been seen yet
+        std::atomic<uint64_t> _moduleUnloadCount{};
+
+        //
+        //Continuous Profiling - the worker thread samples every _samplingInterval while it isn't zero.  Guarded by _mtx_ProfileRequested.
+        //
+        std::chrono::microseconds _samplingInterval{};
+        std::chrono::steady_clock::time_point _nextSample{};
+
+        //the CPU time of each thread at its last sample, and the buffers used to read them.  Only used by the worker thread.
+        std::unordered_map<ThreadID, ThreadCpuTime> _threadCpuTimes;
+        std::unordered_map<ThreadID, ThreadCpuTime> _nextThreadCpuTimes;
+        ActiveThreadIDs _sampledThreadIds;
+        std::vector<DWORD> _sampledOSThreadIds;
+
+        //stacks sampled since the last SwapCallTree, and the marshal-ready copy of the tree it returned
+        std::mutex _mtx_callTree;
+        std::unique_ptr<CallTree> _callTree;
+        std::vector<MarshaledCallTreeNode> _marshaledCallTree;
+        //the timings of the samples in _callTree, and of the ones in the tree SwapCallTree returned
+        ProfileTimings _callTreeTimings{};
+        ProfileTimings _swappedCallTreeTimings{};
+
                                                             //worker thread that performs profiling of all current, active managed threads
         std::thread _workerThread;
 
@@ -433,12 +954,52 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
         CComPtr<ICorProfilerInfo10> _corProfilerInfo10;
 
         //cache of type and method names.
-        //NEVER update this cache during the snapshot callback as it's memory is dynamically allocated. 
+        //NEVER update this cache during the snapshot callback as it's memory is dynamically allocated.  Lookups don't allocate.
+        //Only the worker thread changes it, and it does so under _mtx_nameCache.
         NameCache _nameCache;
+        std::mutex _mtx_nameCache;
+
+        //the names returned by the last GetTypeAndMethodNames call
+        std::vector<TypeAndMethodNames> _marshaledNames;
+
+        //buffers the metadata calls write names into while new functions are resolved
+        PreallocTypeName _typeNameBuffer{};
+        PreallocMethodName _methodNameBuffer{};
+
+        //threads started by the worker thread that snapshot alongside it, one lane each.  The worker thread is lane 0.
+        SnapshotPool _snapshotPool;
+        std::vector<SnapshotLane> _lanes;
+
+        //the longest the runtime is kept suspended while a snapshot is taken, zero for no limit
+        std::atomic<uint32_t> _maxPauseInMicroseconds{};
+
+        //the managed threads the runtime has reported, seeded from corProfilerInfo->EnumThreads by the first snapshot
+        ThreadRegistry _threadRegistry;
+
+        //the tags threads have set on themselves, and whether to snapshot only the threads with a tag
+        ThreadTags _threadTags;
+        std::atomic_bool _taggedThreadsOnly{};
+
+        //the threads the current pause snapshots, copied from the registry
+        ActiveThreadIDs _activeThreads;
+
+        //the threads snapshot by the earlier pauses of the current snapshot
+        ActiveThreadIDs _snapshottedThreads;
 
         //collection of marshal-ready ThreadProfiles.  AKA a profile.  This is the result of a RequestProfile.
         MarshaledProfileCollection _marshaledProfiles;
 
+        //set by RequestCompactProfile so the worker thread builds _compactProfile rather than _marshaledProfiles
+        std::atomic_bool _compactProfileRequested{};
+        CompactProfileWriter _compactProfileWriter;
+
+        //the result of a RequestCompactProfile
+        std::vector<uint8_t> _compactProfile;
+
+        //the timings of the last profile, written by the worker thread
+        ProfileTimings _profileTimings{};
+        std::mutex _mtx_profileTimings;
+
         //collection of marshal-ready FunctionID, type names and method names. This is the result of the GetTypeAndMethodNames() call
         MarshaledFunctionIDTypeNameMethodNameCollection _marshaledFunctionIDTypeNameMethodNames;
 
@@ -446,10 +1007,10 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
 
 #pragma region Private Methods
 
-        //Return a collection of all active managed threads.
-        ActiveThreadIDs GetThreads() const
+        //Return a collection of all active managed threads, with their OS thread ids.  Only used to seed the thread registry.
+        std::vector<ThreadRegistry::Thread> EnumerateThreads() const
         {
-            ActiveThreadIDs enumeratedThreads;
+            std::vector<ThreadRegistry::Thread> enumeratedThreads;
             CComPtr<ICorProfilerThreadEnum> threadEnum;
             if (SUCCEEDED(_corProfilerInfo->EnumThreads(&threadEnum)))
             {
@@ -467,7 +1028,12 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
                 {
                     for (ULONG idx = 0; idx != celtFetched; ++idx)
                     {
-                        enumeratedThreads.push_back(batchBegin[idx]);
+                        DWORD osThreadId{};
+                        if (FAILED(_corProfilerInfo->GetThreadInfo(batchBegin[idx], &osThreadId)))
+                        {
+                            osThreadId = 0;
+                        }
+                        enumeratedThreads.push_back(ThreadRegistry::Thread{ batchBegin[idx], osThreadId, true });
                     }
 
                     if (S_FALSE == hr)
@@ -541,43 +1107,201 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
             WaitForSignal(_cv_ProfileCompleted, _profileCompleted, _shuttingDown, _mtx_ProfileCompleted);
         }
 
-        //wait until event is fired that indicates we should start profiling
-        void WaitForProfileRequestedOrShutdown()
+        enum class WorkerTask
         {
-            WaitForSignal(_cv_ProfileRequested, _profileRequested, _shuttingDown, _mtx_ProfileRequested);
+            None,
+            Profile,
+            Sample
+        };
+
+        //wait until RequestProfile asks for a profile or the next continuous sample is due
+        WorkerTask WaitForProfileRequestOrSample()
+        {
+            waitlock l(_mtx_ProfileRequested);
+            const auto zero = std::chrono::microseconds::zero();
+            if (_samplingInterval == zero)
+            {
+                _cv_ProfileRequested.wait(l, [&]() noexcept { return _profileRequested.load() || _shuttingDown.load() || _samplingInterval != zero; });
+            }
+            else
+            {
+                _cv_ProfileRequested.wait_until(l, _nextSample, [&]() noexcept { return _profileRequested.load() || _shuttingDown.load() || _samplingInterval == zero; });
+            }
+
+            if (_profileRequested.exchange(false))
+            {
+                return WorkerTask::Profile;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            if (_samplingInterval == zero || now < _nextSample)
+            {
+                return WorkerTask::None;
+            }
+
+            //when sampling falls behind the next sample is pushed back rather than taken straight away
+            _nextSample += _samplingInterval;
+            if (_nextSample < now)
+            {
+                _nextSample = now + _samplingInterval;
+            }
+            return WorkerTask::Sample;
         }
 
         //Release results from a prior call to GetTypeAndMethodNames()
         void ReleaseGetTypeAndMethodNamesResults() noexcept
         {
             _marshaledFunctionIDTypeNameMethodNames.clear();
+            _marshaledNames.clear();
+        }
+
+        //drop the names of modules that unloaded since the last profile.  Called on the worker thread before the runtime is suspended.
+        void ForgetUnloadedModules()
+        {
+            std::set<ModuleID> unloadedModules;
+            bool forgetAllNames{};
+            {
+                std::lock_guard<std::mutex> l(_mtx_unloadedModules);
+                unloadedModules.swap(_unloadedModules);
+                std::swap(forgetAllNames, _forgetAllNames);
+            }
+
+            std::lock_guard<std::mutex> l(_mtx_nameCache);
+            if (forgetAllNames)
+            {
+                _nameCache.clear();
+            }
+            else if (!unloadedModules.empty())
+            {
+                _nameCache.remove_modules(unloadedModules);
+            }
         }
 
-        //Get the list of active managed threads (GetThreads) and call _corProfilerInfo->DoStackSnapshot for each one. Capture the StackWalk 
-        //  (function id, type and method names; observing the name cache for previously captured names) in a preallocated data structure. 
-        //  After a thread's StackWalk has been captured, copy this data into the name cache and copy the data into the marshal-ready collection.
-        void ProfileAllThreads()
+        //Suspend the runtime and snapshot every managed thread.  With a maximum pause set, the runtime is resumed once a pause reaches it
+        //  and suspended again for the threads that are left, until every thread has been snapshot.  Each thread's StackWalk is handed
+        //  to onThreadProfile with its lane to copy it out before the lane's next thread reuses the StackWalk.
+        template <typename OnThreadProfile>
+        SnapshotFootprint SnapshotAllThreads(OnThreadProfile onThreadProfile)
         {
-            ThreadProfiles profiles;
-            profiles.reserve(ThreadCountForReservation);
-            _marshaledProfiles.reserve(ThreadCountForReservation);
+            SeedThreadRegistry();
 
-            auto stackwalk = std::make_unique<StackWalk>();
+            SnapshotFootprint footprint;
+            _snapshottedThreads.clear();
+            for (auto& lane : _lanes)
+            {
+                lane.footprint = SnapshotFootprint();
+            }
+
+            for (auto done = false; !done; )
+            {
+                const auto pauseStart = std::chrono::steady_clock::now();
+                auto deadline = std::chrono::steady_clock::time_point::max();
+#ifdef PAL_STDCPP_COMPAT
+                //without SuspendRuntime, DoStackSnapshot pauses one thread at a time so there's nothing to bound
+                const auto maxPause = std::chrono::microseconds(_maxPauseInMicroseconds.load());
+                if (maxPause != std::chrono::microseconds::zero())
+                {
+                    deadline = pauseStart + maxPause;
+                }
+                _corProfilerInfo10->SuspendRuntime();
+#endif
+                done = SnapshotBatch(deadline, footprint, onThreadProfile);
+#ifdef PAL_STDCPP_COMPAT
+                _corProfilerInfo10->ResumeRuntime();
+#endif
+                const auto pause = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - pauseStart);
+                ++footprint.pauseCount;
+                footprint.totalPause += pause;
+                footprint.longestPause = std::max(footprint.longestPause, pause);
+            }
+
+            footprint.threadCount = _snapshottedThreads.size();
+            for (const auto& lane : _lanes)
+            {
+                footprint.frameCount += lane.footprint.frameCount;
+                footprint.deepestStack = std::max(footprint.deepestStack, lane.footprint.deepestStack);
+            }
+            return footprint;
+        }
+
+        //The thread callbacks only start once the first profile has been requested, so the threads that were already running are added
+        //  from corProfilerInfo->EnumThreads the first time.  Holding _mtx_snapshotInProgress makes a thread destroyed meanwhile wait
+        //  until it's been added before it's removed.
+        void SeedThreadRegistry()
+        {
+            if (_threadRegistry.IsSeeded())
+            {
+                return;
+            }
 
             std::lock_guard<std::mutex> l(_mtx_snapshotInProgress);
+            _threadRegistry.Seed(EnumerateThreads());
+            LogDebug(L"TP: thread registry seeded with ", _threadRegistry.size(), L" threads");
+        }
+
+        //Get the list of active managed threads from the thread registry that haven't been snapshot by an earlier pause and call
+        //  _corProfilerInfo->DoStackSnapshot for each one until the deadline passes, splitting the list across the snapshot lanes when
+        //  there are enough threads to make it worth waking them.  Returns true once no threads are left.  Called while the runtime
+        //  is suspended.  The list is read again every pause since a thread can end while the runtime is running.
+        template <typename OnThreadProfile>
+        bool SnapshotBatch(std::chrono::steady_clock::time_point deadline, SnapshotFootprint& footprint, OnThreadProfile& onThreadProfile)
+        {
+            std::lock_guard<std::mutex> l(_mtx_snapshotInProgress);
+
+            if (_taggedThreadsOnly.load())
+            {
+                _threadTags.GetTaggedThreads(_activeThreads);
+            }
+            else
+            {
+                _threadRegistry.GetThreads(_activeThreads);
+            }
+            if (!_snapshottedThreads.empty())
+            {
+                std::sort(std::begin(_snapshottedThreads), std::end(_snapshottedThreads));
+                _activeThreads.erase(std::remove_if(std::begin(_activeThreads), std::end(_activeThreads), [this](ThreadID threadId) {
+                    return std::binary_search(std::begin(_snapshottedThreads), std::end(_snapshottedThreads), threadId);
+                }), std::end(_activeThreads));
+            }
+
+            const auto threadCount = _activeThreads.size();
+            const auto laneCount = std::max<size_t>(1, std::min(_lanes.size(), threadCount / MinThreadsPerSnapshotLane));
+            footprint.laneCount = std::max(footprint.laneCount, laneCount);
+
+            //each lane takes a contiguous share of the threads
+            for (size_t lane = 0; lane != laneCount; ++lane)
+            {
+                _lanes[lane].first = _activeThreads.cbegin() + threadCount * lane / laneCount;
+                _lanes[lane].next = _lanes[lane].first;
+                _lanes[lane].last = _activeThreads.cbegin() + threadCount * (lane + 1) / laneCount;
+            }
+            auto snapshotLane = [&](size_t lane) { SnapshotThreads(_lanes[lane], deadline, onThreadProfile); };
+            _snapshotPool.Run(laneCount, snapshotLane);
+
+            auto done = true;
+            for (size_t lane = 0; lane != laneCount; ++lane)
+            {
+                _snapshottedThreads.insert(std::end(_snapshottedThreads), _lanes[lane].first, _lanes[lane].next);
+                done = done && _lanes[lane].next == _lanes[lane].last;
+            }
+            return done || HasShutdownBeenRequested();
+        }
 
-            const auto localActiveThreads = GetThreads();
-            for (const auto threadId : localActiveThreads)
+        //snapshot the lane's threads on the calling thread using the lane's StackWalk.  Stops once the deadline has passed, having
+        //  snapshot at least one thread so every pause makes progress.
+        template <typename OnThreadProfile>
+        void SnapshotThreads(SnapshotLane& lane, std::chrono::steady_clock::time_point deadline, OnThreadProfile& onThreadProfile)
+        {
+            while (lane.next != lane.last)
             {
                 if (HasShutdownBeenRequested()) {
                     break;
                 }
 
+                const auto threadId = *lane.next++;
                 try
                 {
-                    // get or create the thread profile for this thread
-                    profiles.emplace_back(threadId, _corProfilerInfo, _nameCache, *stackwalk);
-                    auto& threadProfile = profiles.back();
+                    ThreadProfile threadProfile(threadId, *lane.stackwalk);
 
                     // LEGACY: on 64-bit architecture prefer native stack walking, see: StackWalk64
 
@@ -592,19 +1316,16 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
                         threadProfile._errorCode = result;
 
                         //if the thread terminates between Enum and snapshot we may get CORPROF_E_STACKSNAPSHOT_INVALID_TGT_THREAD
-                        continue;
                     }
-
-                    std::for_each(std::begin(threadProfile._stackwalk), threadProfile._frameNext, [&](const StackFrame& funcdetails)
+                    else
                     {
-                        if (funcdetails.functionId && funcdetails.typeDef != 0)
-                        {
-                            _nameCache.insert(funcdetails.functionId, funcdetails.typeDef, funcdetails.typeName, funcdetails.methodName);
-                        }
-                    });
+                        //a stack too deep for the buffer wrapped around it, so all of it was touched
+                        const size_t depth = threadProfile._errorCode == S_FALSE ? MaxStackFramesSupported : static_cast<size_t>(std::distance(std::begin(threadProfile._stackwalk), threadProfile._frameNext));
+                        lane.footprint.frameCount += depth;
+                        lane.footprint.deepestStack = std::max(lane.footprint.deepestStack, depth);
 
-                    //transform the threadProfile into a snapshot to pass back to caller of RequestProfile
-                    _marshaledProfiles.emplace_back(threadProfile);
+                        onThreadProfile(lane, threadProfile);
+                    }
 
                     // LEGACY: check the result for certain failures and fall back on native stack walking to find the first managed function call and then try again
                 }
@@ -613,12 +1334,419 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
                     // the show must go on! if we fail to profile one thread, continue trying to profile the others
                     LogTrace(L"TP: exception in ", __func__);
                 }
+
+                if (std::chrono::steady_clock::now() >= deadline)
+                {
+                    break;
+                }
             }
         }
 
+        //one lane per core, up to MaxSnapshotLanes
+        static size_t GetSnapshotLaneCount() noexcept
+        {
+            const size_t cores = std::thread::hardware_concurrency();
+            if (cores == 0)
+            {
+                return 1;
+            }
+            return cores < MaxSnapshotLanes ? cores : MaxSnapshotLanes;
+        }
+
+        //snapshot lane thread method.  Like the worker thread, it has to be initialized before it calls the Execution Engine.
+        void InitializeSnapshotLaneThread() noexcept
+        {
+            const auto hr = _corProfilerInfo->InitializeCurrentThread();
+            if (FAILED(hr))
+            {
+                LogError(L"TP: InitializeCurrentThread failed on a snapshot thread: ", std::hex, std::showbase, hr,
+                    std::resetiosflags(std::ios_base::basefield | std::ios_base::showbase));
+            }
+        }
+
+        //give every lane its StackWalk before the runtime is suspended
+        void PrepareSnapshotLanes()
+        {
+            _lanes.resize(_snapshotPool.GetLaneCount());
+            for (auto& lane : _lanes)
+            {
+                if (!lane.stackwalk)
+                {
+                    lane.stackwalk = std::make_unique<StackWalk>();
+                }
+            }
+        }
+
+        //Look up and cache the names of the functions in the profile that aren't in the name cache yet.  Called on the worker thread once
+        //  the runtime has been resumed.  Returns how many functions were added to the cache.
+        size_t ResolveNewFunctionNames(uint64_t moduleUnloadCount)
+        {
+            size_t resolvedCount{};
+            std::unordered_map<FunctionID, HRESULT> failures;
+            for (auto& profile : _marshaledProfiles)
+            {
+                for (int32_t idx = 0; profile.fids && idx != profile.length; ++idx)
+                {
+                    if (!ResolveNameIfNew(profile.fids[idx], moduleUnloadCount, failures, resolvedCount))
+                    {
+                        return resolvedCount;
+                    }
+                }
+            }
+
+            //a thread with a function whose names couldn't be found is reported with that error, but StackTooDeep isn't overwritten
+            for (auto& profile : _marshaledProfiles)
+            {
+                for (int32_t idx = 0; S_OK == profile.hresult && profile.fids && idx != profile.length; ++idx)
+                {
+                    const auto failure = failures.find(profile.fids[idx]);
+                    if (failure != std::end(failures))
+                    {
+                        profile.hresult = failure->second;
+                        profile.fids.reset();
+                    }
+                }
+            }
+            return resolvedCount;
+        }
+
+        //Resolve the names of fid unless they're cached or have already failed.  Returns false, leaving the remaining names for next
+        //  time, once a module has started unloading since the snapshot as the function ids of that module may no longer be valid.
+        bool ResolveNameIfNew(FunctionID fid, uint64_t moduleUnloadCount, std::unordered_map<FunctionID, HRESULT>& failures, size_t& resolvedCount)
+        {
+            if (!fid || _nameCache.has_fid(fid) || failures.count(fid))
+            {
+                return true;
+            }
+
+            if (_moduleUnloadCount.load() != moduleUnloadCount)
+            {
+                LogDebug(L"TP: a module unloaded while names were being resolved, ", resolvedCount, L" names were resolved");
+                return false;
+            }
+
+            const auto hr = ResolveFunctionName(fid);
+            if (FAILED(hr))
+            {
+                failures.emplace(fid, hr);
+            }
+            else
+            {
+                ++resolvedCount;
+            }
+            return true;
+        }
+
+        //ResolveNameIfNew for each of the functions, stopping if a module has started unloading since the snapshot
+        bool ResolveNamesIfNew(const std::vector<FunctionID>& functionIds, uint64_t moduleUnloadCount, std::unordered_map<FunctionID, HRESULT>& failures, size_t& resolvedCount)
+        {
+            for (const auto fid : functionIds)
+            {
+                if (!ResolveNameIfNew(fid, moduleUnloadCount, failures, resolvedCount))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        //Get the type and method names of the function from its metadata and add them to the name cache
+        HRESULT ResolveFunctionName(FunctionID functionId)
+        {
+            ModuleID moduleId{};
+            mdTypeDef typeDef{};
+            CComPtr<IMetaDataImport2> metaDataImport;
+            mdToken mdTokenForFunction{};
+            HRESULT hr{};
+            if (SUCCEEDED(hr = _corProfilerInfo->GetFunctionInfo(functionId, nullptr, &moduleId, nullptr)) &&
+                SUCCEEDED(hr = _corProfilerInfo->GetTokenAndMetaDataFromFunction(functionId, IID_IMetaDataImport2, (IUnknown**)&metaDataImport, &mdTokenForFunction)) &&
+                metaDataImport != nullptr)
+            {
+                //first is buffer, second is actual name length
+                if (SUCCEEDED(hr = metaDataImport->GetMethodProps(mdTokenForFunction, &typeDef,
+                    &_methodNameBuffer.first.front(), (ULONG)_methodNameBuffer.first.size(), &_methodNameBuffer.second,
+                    nullptr, nullptr, nullptr, nullptr, nullptr)))
+                {
+                    //the cache already has the name of a type it has seen, and ignores the type name passed to insert
+                    if (!_nameCache.has_typedef(moduleId, typeDef))
+                    {
+                        hr = metaDataImport->GetTypeDefProps(typeDef, &_typeNameBuffer.first.front(), static_cast<ULONG>(_typeNameBuffer.first.size()), &_typeNameBuffer.second, nullptr, nullptr);
+                    }
+
+                    if (SUCCEEDED(hr) && typeDef != 0)
+                    {
+                        std::lock_guard<std::mutex> l(_mtx_nameCache);
+                        _nameCache.insert(functionId, moduleId, typeDef, _typeNameBuffer, _methodNameBuffer);
+                    }
+                }
+            }
+            return hr;
+        }
+
+        static ProfileTimings MeasureTimings(const SnapshotFootprint& footprint, std::chrono::steady_clock::duration snapshot, size_t resolvedCount,
+            std::chrono::steady_clock::duration resolve)
+        {
+            ProfileTimings timings{};
+            timings.snapshotCount = 1;
+            timings.threadCount = footprint.threadCount;
+            timings.pauseCount = footprint.pauseCount;
+            timings.totalPauseMicroseconds = static_cast<uint64_t>(footprint.totalPause.count());
+            timings.longestPauseMicroseconds = static_cast<uint64_t>(footprint.longestPause.count());
+            timings.snapshotMicroseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(snapshot).count());
+            timings.resolvedFunctionCount = resolvedCount;
+            timings.resolveMicroseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(resolve).count());
+            return timings;
+        }
+
+        void SetProfileTimings(const ProfileTimings& timings)
+        {
+            std::lock_guard<std::mutex> l(_mtx_profileTimings);
+            _profileTimings = timings;
+        }
+
+        //capture a profile of every thread for RequestProfile
+        void TakeProfile()
+        {
+            ForgetUnloadedModules();
+            PrepareSnapshotLanes();
+            for (auto& lane : _lanes)
+            {
+                lane.marshaledProfiles.reserve(ThreadCountForReservation);
+            }
+            const auto moduleUnloadCount = _moduleUnloadCount.load();
+
+            const auto snapshotStart = std::chrono::steady_clock::now();
+            const auto footprint = SnapshotAllThreads([](SnapshotLane& lane, ThreadProfile& threadProfile) {
+                //transform the threadProfile into a snapshot to pass back to caller of RequestProfile
+                lane.marshaledProfiles.emplace_back(threadProfile);
+            });
+            const auto resolveStart = std::chrono::steady_clock::now();
+
+            _marshaledProfiles.reserve(footprint.threadCount);
+            for (auto& lane : _lanes)
+            {
+                std::move(std::begin(lane.marshaledProfiles), std::end(lane.marshaledProfiles), std::back_inserter(_marshaledProfiles));
+                lane.marshaledProfiles.clear();
+            }
+            const auto resolvedCount = ResolveNewFunctionNames(moduleUnloadCount);
+            const auto resolveEnd = std::chrono::steady_clock::now();
+            SetProfileTimings(MeasureTimings(footprint, resolveStart - snapshotStart, resolvedCount, resolveEnd - resolveStart));
+
+            LogDebug(L"TP: profiled ", _marshaledProfiles.size(), L" threads.  Snapshot: ",
+                std::chrono::duration_cast<std::chrono::microseconds>(resolveStart - snapshotStart).count(), L"us, resolving ",
+                resolvedCount, L" new function names: ", std::chrono::duration_cast<std::chrono::microseconds>(resolveEnd - resolveStart).count(), L"us");
+            LogDebug(L"TP: snapshot of ", footprint.threadCount, L" threads split across ", footprint.laneCount, L" lanes paused the runtime for ",
+                footprint.totalPause.count(), L"us");
+            if (footprint.pauseCount > 1)
+            {
+                LogDebug(L"TP: profile was split across ", footprint.pauseCount, L" pauses to stay within ", _maxPauseInMicroseconds.load(),
+                    L"us, the longest was ", footprint.longestPause.count(), L"us");
+            }
+            LogDebug(L"TP: snapshot captured ", footprint.frameCount, L" frames and touched at most ", footprint.deepestStack * sizeof(StackFrame),
+                L" of each ", sizeof(StackWalk), L" byte stack walk buffer");
+            LogTrace(L"TP: name cache holds ", _nameCache.size(), L" functions, load factor ", _nameCache.load_factor(),
+                L", typedef load factor ", _nameCache.typedef_load_factor());
+        }
+
+        //capture a profile of every thread for RequestCompactProfile.  The lanes copy the stacks into buffers they keep between profiles, and
+        //  identical stacks are only written to the compact profile once.
+        void TakeCompactProfile()
+        {
+            ForgetUnloadedModules();
+            PrepareSnapshotLanes();
+            for (auto& lane : _lanes)
+            {
+                lane.profiledFrames.clear();
+                lane.profiledThreads.clear();
+            }
+            const auto moduleUnloadCount = _moduleUnloadCount.load();
+
+            const auto snapshotStart = std::chrono::steady_clock::now();
+            const auto footprint = SnapshotAllThreads([](SnapshotLane& lane, ThreadProfile& threadProfile) { StageProfiledStack(lane, threadProfile); });
+            const auto resolveStart = std::chrono::steady_clock::now();
+
+            size_t resolvedCount{};
+            std::unordered_map<FunctionID, HRESULT> failures;
+            for (const auto& lane : _lanes)
+            {
+                if (!ResolveNamesIfNew(lane.profiledFrames, moduleUnloadCount, failures, resolvedCount))
+                {
+                    break;
+                }
+            }
+            const auto resolveEnd = std::chrono::steady_clock::now();
+            SetProfileTimings(MeasureTimings(footprint, resolveStart - snapshotStart, resolvedCount, resolveEnd - resolveStart));
+
+            _compactProfileWriter.clear();
+            for (const auto& lane : _lanes)
+            {
+                for (const auto& thread : lane.profiledThreads)
+                {
+                    const auto first = std::begin(lane.profiledFrames) + thread.first;
+                    const auto last = std::begin(lane.profiledFrames) + thread.last;
+
+                    //as with RequestProfile, a thread with a function whose names couldn't be found is reported with that error, but
+                    //  StackTooDeep isn't overwritten
+                    auto hresult = thread.hresult;
+                    if (S_OK == hresult && !failures.empty())
+                    {
+                        const auto failed = std::find_if(first, last, [&failures](FunctionID fid) { return failures.count(fid) != 0; });
+                        if (failed != last)
+                        {
+                            hresult = failures[*failed];
+                        }
+                    }
+
+                    if (SUCCEEDED(hresult))
+                    {
+                        _compactProfileWriter.add_thread(thread.threadId, hresult, first, last);
+                    }
+                    else
+                    {
+                        _compactProfileWriter.add_thread(thread.threadId, hresult);
+                    }
+                }
+            }
+            _compactProfileWriter.write(_compactProfile);
+
+            LogDebug(L"TP: profiled ", _compactProfileWriter.thread_count(), L" threads with ", _compactProfileWriter.stack_count(),
+                L" distinct stacks into a ", _compactProfile.size(), L" byte compact profile.  Snapshot: ",
+                std::chrono::duration_cast<std::chrono::microseconds>(resolveStart - snapshotStart).count(), L"us, resolving ",
+                resolvedCount, L" new function names: ", std::chrono::duration_cast<std::chrono::microseconds>(resolveEnd - resolveStart).count(), L"us");
+            LogDebug(L"TP: snapshot of ", footprint.threadCount, L" threads split across ", footprint.laneCount, L" lanes paused the runtime ",
+                footprint.pauseCount, L" times for ", footprint.totalPause.count(), L"us, the longest ", footprint.longestPause.count(), L"us");
+        }
+
+        //sample every thread for continuous profiling and merge the stacks, weighed by CPU time, into the call tree
+        void TakeSample()
+        {
+            ForgetUnloadedModules();
+            PrepareSnapshotLanes();
+            const auto moduleUnloadCount = _moduleUnloadCount.load();
+            for (auto& lane : _lanes)
+            {
+                lane.sampledFrames.clear();
+                lane.sampledStacks.clear();
+            }
+
+            const auto snapshotStart = std::chrono::steady_clock::now();
+            const auto footprint = SnapshotAllThreads([this](SnapshotLane& lane, ThreadProfile& threadProfile) {
+                StageSampledStack(lane, threadProfile, _threadTags.Get(threadProfile._managedTID));
+            });
+            const auto snapshotEnd = std::chrono::steady_clock::now();
+            const auto cpuTime = WeighSampledStacks();
+            const auto resolveStart = std::chrono::steady_clock::now();
+
+            //the call tree only holds function ids, the names are resolved now so GetTypeAndMethodNames has them when it's swapped out
+            size_t resolvedCount{};
+            std::unordered_map<FunctionID, HRESULT> failures;
+            for (const auto& lane : _lanes)
+            {
+                if (!ResolveNamesIfNew(lane.sampledFrames, moduleUnloadCount, failures, resolvedCount))
+                {
+                    break;
+                }
+            }
+            const auto resolveEnd = std::chrono::steady_clock::now();
+
+            {
+                std::lock_guard<std::mutex> l(_mtx_callTree);
+                if (!_callTree)
+                {
+                    _callTree = std::make_unique<CallTree>(size_t{ MaxCallTreeNodes });
+                }
+                _callTreeTimings.add(MeasureTimings(footprint, snapshotEnd - snapshotStart, resolvedCount, resolveEnd - resolveStart));
+                for (const auto& lane : _lanes)
+                {
+                    for (const auto& stack : lane.sampledStacks)
+                    {
+                        _callTree->add_stack(stack.tag, static_cast<uint64_t>(stack.cpuTime.count()), stack.running,
+                            std::begin(lane.sampledFrames) + stack.first, std::begin(lane.sampledFrames) + stack.last);
+                    }
+                }
+            }
+
+            LogTrace(L"TP: sampled ", footprint.threadCount, L" threads, which used ", std::chrono::duration_cast<std::chrono::microseconds>(cpuTime).count(),
+                L"us of CPU time since they were last sampled, across ", footprint.laneCount, L" lanes.  Runtime paused ",
+                footprint.pauseCount, L" times for ", footprint.totalPause.count(), L"us, the longest ", footprint.longestPause.count(), L"us, resolving ",
+                resolvedCount, L" new function names: ", std::chrono::duration_cast<std::chrono::microseconds>(resolveEnd - resolveStart).count(), L"us");
+        }
+
+        //Give each sampled stack the CPU time its thread used since the thread was last sampled, and count the thread as running if it was
+        //  on a CPU for at least half of that time.  A thread's first sample has no CPU time and counts as blocked.  The clocks are read
+        //  once the runtime has been resumed, which only shifts each thread's window a little since every reading is taken the same way.
+        //  Returns the CPU time of all the sampled threads.
+        std::chrono::nanoseconds WeighSampledStacks()
+        {
+            const auto now = std::chrono::steady_clock::now();
+            _sampledThreadIds.clear();
+            for (const auto& lane : _lanes)
+            {
+                for (const auto& stack : lane.sampledStacks)
+                {
+                    _sampledThreadIds.push_back(stack.threadId);
+                }
+            }
+            _threadRegistry.GetOSThreadIds(_sampledThreadIds, _sampledOSThreadIds);
+
+            //threads that weren't sampled this time are dropped, a thread that has ended may have its ThreadID handed on
+            std::chrono::nanoseconds totalCpuTime{};
+            _nextThreadCpuTimes.clear();
+            auto osThreadId = std::begin(_sampledOSThreadIds);
+            for (auto& lane : _lanes)
+            {
+                for (auto& stack : lane.sampledStacks)
+                {
+                    std::chrono::nanoseconds cpuTime{};
+                    if (!TryGetThreadCpuTime(*osThreadId, cpuTime))
+                    {
+                        ++osThreadId;
+                        continue;
+                    }
+
+                    const auto previous = _threadCpuTimes.find(stack.threadId);
+                    if (previous != std::end(_threadCpuTimes) && previous->second.osThreadId == *osThreadId && cpuTime >= previous->second.cpuTime)
+                    {
+                        stack.cpuTime = cpuTime - previous->second.cpuTime;
+                        stack.running = stack.cpuTime * 2 >= now - previous->second.sampledAt;
+                        totalCpuTime += stack.cpuTime;
+                    }
+                    _nextThreadCpuTimes[stack.threadId] = ThreadCpuTime{ *osThreadId, cpuTime, now };
+                    ++osThreadId;
+                }
+            }
+            _threadCpuTimes.swap(_nextThreadCpuTimes);
+            return totalCpuTime;
+        }
+
+        //copy a thread's stack into the lane's profiledFrames in the order it was walked, as MarshaledThreadProfile does
+        static void StageProfiledStack(SnapshotLane& lane, const ThreadProfile& threadProfile)
+        {
+            const auto first = lane.profiledFrames.size();
+            std::for_each(std::begin(threadProfile._stackwalk), threadProfile._frameNext,
+                [&lane](const StackFrame& frame) { lane.profiledFrames.push_back(frame.functionId); });
+            lane.profiledThreads.push_back(ProfiledThread{ threadProfile._managedTID, threadProfile._errorCode, first, lane.profiledFrames.size() });
+        }
+
+        //copy a thread's stack into the lane's sampledFrames root first.  The snapshot walks from the leaf, and a stack too deep for the
+        //  StackWalk wrapped around so its root end is just before _frameNext.
+        static void StageSampledStack(SnapshotLane& lane, const ThreadProfile& threadProfile, uint64_t tag)
+        {
+            auto& sampledFrames = lane.sampledFrames;
+            const auto first = sampledFrames.size();
+            const auto toFunctionId = [&sampledFrames](const StackFrame& frame) { sampledFrames.push_back(frame.functionId); };
+            std::for_each(std::reverse_iterator<StackWalk::iterator>(threadProfile._frameNext), threadProfile._stackwalk.rend(), toFunctionId);
+            if (threadProfile._errorCode == S_FALSE)
+            {
+                std::for_each(threadProfile._stackwalk.rbegin(), std::reverse_iterator<StackWalk::iterator>(threadProfile._frameNext), toFunctionId);
+            }
+            lane.sampledStacks.push_back(SampledStack{ threadProfile._managedTID, first, sampledFrames.size(), tag, {}, false });
+        }
+
         //worker thread method.  Initialize the thread for calling the Execution Engine.  Wait for RequestProfile to signal
-        // a profiling request.  When requested call ProfileAllThreads to capture the profile and signal the blocked thread in 
-        // RequestProfile that profiling is complete.  Terminate when _shuttingDown is true.
+        // a profiling request.  When requested call TakeProfile to capture the profile and signal the blocked thread in 
+        // RequestProfile that profiling is complete.  While continuous profiling is on, call TakeSample at each sampling interval.
+        // Terminate when _shuttingDown is true.
         void ProfilerThreadStart()
         {
             LogTrace(L"TP: profile thread started");
@@ -635,26 +1763,43 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
                     std::resetiosflags(std::ios_base::basefield | std::ios_base::showbase));
             }
 
+            // the snapshot lanes are started now so they're initialized long before the first suspension
+            try
+            {
+                _snapshotPool.Start(GetSnapshotLaneCount(), [this]() { InitializeSnapshotLaneThread(); });
+            }
+            catch (const std::exception&)
+            {
+                LogWarn(L"TP: unable to start the snapshot threads, snapshots will be taken on the profile thread");
+            }
+
             for (;;)
             {
                 try
                 {
-                    WaitForProfileRequestedOrShutdown();
+                    const auto task = WaitForProfileRequestOrSample();
 
                     if (HasShutdownBeenRequested())
                     {
                         break;
                     }
 
-#ifdef PAL_STDCPP_COMPAT
-                    _corProfilerInfo10->SuspendRuntime();
-#endif
-                    ProfileAllThreads();
-#ifdef PAL_STDCPP_COMPAT
-                    _corProfilerInfo10->ResumeRuntime();
-#endif
-
-                    SignalProfileCompleted();
+                    if (task == WorkerTask::Profile)
+                    {
+                        if (_compactProfileRequested.exchange(false))
+                        {
+                            TakeCompactProfile();
+                        }
+                        else
+                        {
+                            TakeProfile();
+                        }
+                        SignalProfileCompleted();
+                    }
+                    else if (task == WorkerTask::Sample)
+                    {
+                        TakeSample();
+                    }
                 }
                 catch (...)
                 {
@@ -662,6 +1807,7 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
                     // an exception here is recoverable, "The thread must go on!"
                 }
             }
+            _snapshotPool.Stop();
             LogTrace(L"TP: profile thread terminating");
         }
 
@@ -682,44 +1828,7 @@ namespace NewRelic { namespace Profiler { namespace ThreadProfiler
                     threadProfile._errorCode = StackTooDeep;
                 }
 
-                auto& thisframe = *threadProfile._frameNext;
-                thisframe.functionId = functionId;
-                const auto& nameCache = threadProfile._nameCache;
-
-                if (functionId && !nameCache.has_fid(functionId))
-                {
-                    // get the interfaces we need and the metadata token
-                    CComPtr<IMetaDataImport2> metaDataImport;
-                    mdToken mdTokenForFunction{};
-                    HRESULT hr{};
-                    if (SUCCEEDED(hr = threadProfile._corProfilerInfo->GetTokenAndMetaDataFromFunction(functionId, IID_IMetaDataImport2, (IUnknown**)&metaDataImport, &mdTokenForFunction)) &&
-                        metaDataImport != nullptr)
-                    {
-                        auto& preallocMethodName = thisframe.methodName;
-                        //first is buffer, second is actual name length
-                        if (SUCCEEDED(hr = metaDataImport->GetMethodProps(mdTokenForFunction, &thisframe.typeDef,
-                            &preallocMethodName.first.front(), (ULONG)preallocMethodName.first.size(), &preallocMethodName.second,
-                            nullptr, nullptr, nullptr, nullptr, nullptr)))
-                        {
-                            auto& preallocTypeName = thisframe.typeName;
-                            auto& typeName = nameCache.typename_for(thisframe.typeDef);
-                            if (typeName == TypeAndMethodNames::GetUnknownTypeName())
-                            {
-                                // get the name of the class from the cache. Make a cache entry if not found.
-                                hr = metaDataImport->GetTypeDefProps(thisframe.typeDef, &preallocTypeName.first.front(), static_cast<ULONG>(preallocTypeName.first.size()), &preallocTypeName.second, nullptr, nullptr);
-                            }
-                            else
-                            {
-                                wcscpy_s(preallocTypeName.first.data(), static_cast<ULONG>(preallocTypeName.first.size()), typeName->c_str());
-                            }
-                        }
-                    }
-                    //don't overwrite StackTooDeep.  
-                    if (FAILED(hr) && StackTooDeep != threadProfile._errorCode)
-                    {
-                        threadProfile._errorCode = hr;
-                    }
-                }
+                threadProfile._frameNext->functionId = functionId;
 
                 //advance the index to the next slot
                 ++threadProfile._frameNext;
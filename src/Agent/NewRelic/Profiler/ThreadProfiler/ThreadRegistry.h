@@ -0,0 +1,149 @@
+/*
+* Copyright 2020 New Relic Corporation. All rights reserved.
+* SPDX-License-Identifier: Apache-2.0
+*/
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <cor.h>
+#include <corprof.h>
+
+namespace NewRelic {
+    namespace Profiler {
+        namespace ThreadProfiler
+        {
+            //The managed threads the runtime has told the profiler about through ThreadCreated, ThreadAssignedToOSThread and
+            //  ThreadDestroyed, so a snapshot can start from a copy of it rather than enumerating the runtime's threads.  The
+            //  callbacks only arrive once COR_PRF_MONITOR_THREADS is set, so the threads that already exist by then are added once
+            //  through Seed.  Thread tags are kept apart, in ThreadTags, since each thread sets its own without locking.
+            //
+            //Thread safe.  The callbacks only hold the lock long enough to change one entry.
+            class ThreadRegistry
+            {
+            public:
+                struct Thread
+                {
+                    ThreadID threadId;
+                    //zero until the thread is assigned to an OS thread
+                    DWORD osThreadId;
+                    //false between ThreadCreated and the thread starting, a thread that hasn't started has no stack to snapshot
+                    bool started;
+                };
+
+                //ThreadCreated
+                void Add(ThreadID threadId)
+                {
+                    std::lock_guard<std::mutex> l(_mtx);
+                    FindOrAdd(threadId);
+                }
+
+                //ThreadAssignedToOSThread, which the runtime calls as the thread starts
+                void AssignOSThread(ThreadID threadId, DWORD osThreadId)
+                {
+                    std::lock_guard<std::mutex> l(_mtx);
+                    auto& thread = FindOrAdd(threadId);
+                    thread.osThreadId = osThreadId;
+                    thread.started = true;
+                }
+
+                //ThreadDestroyed
+                void Remove(ThreadID threadId)
+                {
+                    std::lock_guard<std::mutex> l(_mtx);
+                    const auto found = _index.find(threadId);
+                    if (found == _index.end())
+                    {
+                        return;
+                    }
+
+                    //the last thread takes the removed thread's place
+                    const auto index = found->second;
+                    _index.erase(found);
+                    if (index + 1 != _threads.size())
+                    {
+                        _threads[index] = _threads.back();
+                        _index[_threads[index].threadId] = index;
+                    }
+                    _threads.pop_back();
+                }
+
+                bool IsSeeded() const
+                {
+                    std::lock_guard<std::mutex> l(_mtx);
+                    return _seeded;
+                }
+
+                //add the threads that were running before the callbacks were turned on, keeping what the callbacks have already
+                //  said about any of them
+                void Seed(const std::vector<Thread>& threads)
+                {
+                    std::lock_guard<std::mutex> l(_mtx);
+                    for (const auto& seeded : threads)
+                    {
+                        auto& thread = FindOrAdd(seeded.threadId);
+                        if (!thread.started)
+                        {
+                            thread.osThreadId = seeded.osThreadId;
+                            thread.started = seeded.started;
+                        }
+                    }
+                    _seeded = true;
+                }
+
+                //replace threadIds with the started threads.  Doesn't allocate once threadIds has grown to fit.
+                void GetThreads(std::vector<ThreadID>& threadIds) const
+                {
+                    threadIds.clear();
+                    std::lock_guard<std::mutex> l(_mtx);
+                    threadIds.reserve(_threads.size());
+                    for (const auto& thread : _threads)
+                    {
+                        if (thread.started)
+                        {
+                            threadIds.push_back(thread.threadId);
+                        }
+                    }
+                }
+
+                //replace osThreadIds with the OS thread id of each of threadIds, zero for a thread that isn't registered or hasn't started
+                void GetOSThreadIds(const std::vector<ThreadID>& threadIds, std::vector<DWORD>& osThreadIds) const
+                {
+                    osThreadIds.clear();
+                    std::lock_guard<std::mutex> l(_mtx);
+                    for (const auto threadId : threadIds)
+                    {
+                        const auto found = _index.find(threadId);
+                        osThreadIds.push_back(found == _index.end() ? 0 : _threads[found->second].osThreadId);
+                    }
+                }
+
+                size_t size() const
+                {
+                    std::lock_guard<std::mutex> l(_mtx);
+                    return _threads.size();
+                }
+
+            private:
+                Thread& FindOrAdd(ThreadID threadId)
+                {
+                    const auto found = _index.find(threadId);
+                    if (found != _index.end())
+                    {
+                        return _threads[found->second];
+                    }
+
+                    _index.emplace(threadId, _threads.size());
+                    _threads.push_back(Thread{ threadId, 0, false });
+                    return _threads.back();
+                }
+
+                mutable std::mutex _mtx;
+                std::vector<Thread> _threads;
+                std::unordered_map<ThreadID, size_t> _index;
+                bool _seeded{};
+            };
+        } // namespace ThreadProfiler
+    } // namespace Profiler
+} // namespace NewRelic
@@ -0,0 +1,188 @@
+/*
+* Copyright 2020 New Relic Corporation. All rights reserved.
+* SPDX-License-Identifier: Apache-2.0
+*/
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <cor.h>
+#include <corprof.h>
+
+namespace NewRelic {
+    namespace Profiler {
+        namespace ThreadProfiler
+        {
+            //The tag each managed thread has set on itself, such as the id of the transaction it's working on.  A fixed table of slots
+            //  found by probing from the thread's hash, so setting a tag never allocates, and once a thread has a slot, changing its tag
+            //  and looking it up never lock.
+            //
+            //Only a thread sets its own tag, so no two threads ever add the same ThreadID at once.  Remove is called from ThreadDestroyed.
+            //  A removed slot is left as a tombstone, so lookups probing past it keep going, unless the slot after it is empty, in which
+            //  case nothing probes past it and it's emptied along with the tombstones right before it.  A table that filled up has no empty
+            //  slot to start from, so its tombstones are emptied once its last thread is removed.  Otherwise thread pool churn would leave
+            //  the table full of tombstones and a lookup for an untagged thread would probe every slot.  Taking a slot and removing
+            //  one are done under a lock, so a slot isn't taken right after a tombstone that's being emptied.
+            class ThreadTags
+            {
+            public:
+                static constexpr size_t Capacity = 4096;
+
+                //tag the calling thread, zero clears its tag.  Returns false if the table is full.
+                bool Set(ThreadID threadId, uint64_t tag) noexcept
+                {
+                    const auto existing = Find(threadId);
+                    if (existing != nullptr)
+                    {
+                        existing->tag.store(tag, std::memory_order_release);
+                        return true;
+                    }
+
+                    //a thread clearing a tag it never set has nothing to do
+                    if (tag == 0)
+                    {
+                        return true;
+                    }
+
+                    //the first slot that's free, the thread isn't in the table and nothing else adds it
+                    std::lock_guard<std::mutex> l(_mtx_slots);
+                    auto index = IndexFor(threadId);
+                    for (size_t probe = 0; probe != Capacity; ++probe, index = (index + 1) & (Capacity - 1))
+                    {
+                        auto& slot = _slots[index];
+                        const auto slotThreadId = slot.threadId.load(std::memory_order_relaxed);
+                        if (slotThreadId == Empty || slotThreadId == Tombstone)
+                        {
+                            slot.tag.store(tag, std::memory_order_relaxed);
+                            slot.threadId.store(threadId, std::memory_order_release);
+                            ++_threadCount;
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                //the thread's tag, zero if it has none
+                uint64_t Get(ThreadID threadId) const noexcept
+                {
+                    const auto slot = Find(threadId);
+                    return slot == nullptr ? 0 : slot->tag.load(std::memory_order_acquire);
+                }
+
+                //called as the thread is destroyed, its ThreadID can be handed to another thread afterwards
+                void Remove(ThreadID threadId) noexcept
+                {
+                    std::lock_guard<std::mutex> l(_mtx_slots);
+                    const auto slot = Find(threadId);
+                    if (slot == nullptr)
+                    {
+                        return;
+                    }
+
+                    slot->tag.store(0, std::memory_order_release);
+                    if (--_threadCount == 0)
+                    {
+                        //nothing is left to probe for
+                        for (auto& emptied : _slots)
+                        {
+                            emptied.threadId.store(Empty, std::memory_order_release);
+                        }
+                        return;
+                    }
+
+                    auto index = static_cast<size_t>(slot - _slots.data());
+                    if (_slots[(index + 1) & (Capacity - 1)].threadId.load(std::memory_order_relaxed) != Empty)
+                    {
+                        slot->threadId.store(Tombstone, std::memory_order_release);
+                        return;
+                    }
+
+                    //nothing probes past an empty slot, so this one and the tombstones right before it aren't needed to reach any thread
+                    slot->threadId.store(Empty, std::memory_order_release);
+                    for (index = (index - 1) & (Capacity - 1); _slots[index].threadId.load(std::memory_order_relaxed) == Tombstone; index = (index - 1) & (Capacity - 1))
+                    {
+                        _slots[index].threadId.store(Empty, std::memory_order_release);
+                    }
+                }
+
+                //slots left as tombstones, for tests
+                size_t GetTombstoneCount() const noexcept
+                {
+                    size_t tombstones{};
+                    for (const auto& slot : _slots)
+                    {
+                        if (slot.threadId.load(std::memory_order_acquire) == Tombstone)
+                        {
+                            ++tombstones;
+                        }
+                    }
+                    return tombstones;
+                }
+
+                //replace threadIds with the threads that have a tag.  Doesn't allocate once threadIds has grown to fit.
+                void GetTaggedThreads(std::vector<ThreadID>& threadIds) const
+                {
+                    threadIds.clear();
+                    for (const auto& slot : _slots)
+                    {
+                        const auto threadId = slot.threadId.load(std::memory_order_acquire);
+                        if (threadId != Empty && threadId != Tombstone && slot.tag.load(std::memory_order_acquire) != 0)
+                        {
+                            threadIds.push_back(threadId);
+                        }
+                    }
+                }
+
+            private:
+                //ThreadIDs are pointers, so neither is ever a thread
+                static constexpr ThreadID Empty = 0;
+                static constexpr ThreadID Tombstone = 1;
+
+                struct Slot
+                {
+                    std::atomic<ThreadID> threadId{ Empty };
+                    std::atomic<uint64_t> tag{};
+                };
+
+                static size_t IndexFor(ThreadID threadId) noexcept
+                {
+                    //the low bits of a pointer are mostly zero, so the slot comes from the top bits of the hash multiplied by 2^64 / golden ratio
+                    return static_cast<size_t>((static_cast<uint64_t>(std::hash<ThreadID>()(threadId)) * 0x9E3779B97F4A7C15ull) >> 52);
+                }
+
+                const Slot* Find(ThreadID threadId) const noexcept
+                {
+                    auto index = IndexFor(threadId);
+                    for (size_t probe = 0; probe != Capacity; ++probe, index = (index + 1) & (Capacity - 1))
+                    {
+                        const auto slotThreadId = _slots[index].threadId.load(std::memory_order_acquire);
+                        if (slotThreadId == threadId)
+                        {
+                            return &_slots[index];
+                        }
+                        if (slotThreadId == Empty)
+                        {
+                            break;
+                        }
+                    }
+                    return nullptr;
+                }
+
+                Slot* Find(ThreadID threadId) noexcept
+                {
+                    return const_cast<Slot*>(static_cast<const ThreadTags*>(this)->Find(threadId));
+                }
+
+                static_assert((Capacity & (Capacity - 1)) == 0 && Capacity == size_t(1) << 12, "IndexFor takes the top 12 bits of the hash");
+                std::array<Slot, Capacity> _slots;
+                //held while taking a slot or removing one
+                std::mutex _mtx_slots;
+                //slots with a thread, guarded by _mtx_slots
+                size_t _threadCount{};
+            };
+        } // namespace ThreadProfiler
+    } // namespace Profiler
+} // namespace NewRelic
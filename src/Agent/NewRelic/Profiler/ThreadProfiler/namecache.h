@@ -5,10 +5,12 @@
 #pragma once
 #include <vector>
 #include <array>
+#include <utility>
 #include <iterator>
 #include <memory>
 #include <cor.h>
 #include <corprof.h>
+#include "../Common/OpenAddressingMap.h"
 #include "../Common/xplat.h"
 
 namespace NewRelic {
@@ -57,66 +59,133 @@ namespace NewRelic {
 
             class NameCache
             {
-                //function names cache implementation
-                using FidNameMap = std::vector < std::pair<FunctionID, TypeAndMethodNames>>;
-                using TypedefNameMap = std::vector < std::pair<mdTypeDef, std::shared_ptr<xstring_t>>>;
+                //function names cache implementation.  typedef tokens are only unique within a module, and the module a
+                //function came from is kept so its names can be dropped when the module unloads.
+                //
+                //has_fid is called for every frame of every profile, so lookups are made in open addressing tables that
+                //never allocate.  The tables only grow in insert.
+                using ModuleAndTypeDef = std::pair<ModuleID, mdTypeDef>;
+
+                struct ModuleAndTypeDefHash
+                {
+                    std::size_t operator()(const ModuleAndTypeDef& key) const noexcept
+                    {
+                        return std::hash<ModuleID>()(key.first) * 31 + key.second;
+                    }
+                };
+
+                struct FunctionNames
+                {
+                    FunctionID functionId;
+                    ModuleID moduleId;
+                    TypeAndMethodNames names;
+                };
+
+                //the names live in fidNames, the table holds each function's index into it
+                using FidIndexMap = OpenAddressingMap<FunctionID, std::size_t>;
+                using TypedefNameMap = OpenAddressingMap<ModuleAndTypeDef, std::shared_ptr<xstring_t>, ModuleAndTypeDefHash>;
             public:
+                //room for this many functions and types is made up front so most profiles never grow the tables
+                static constexpr std::size_t InitialCapacity = 8192;
+
+                NameCache() :
+                    fidIndexMap(InitialCapacity),
+                    typedefNameMap(InitialCapacity)
+                {}
 
-                bool has_fid(FunctionID fid) const
+                bool has_fid(FunctionID fid) const noexcept
                 {
-                    return find_fid(fid) != std::end(fidNameMap);
+                    return fidIndexMap.Contains(fid);
                 }
 
-                bool has_typedef(mdTypeDef typeDef) const
+                bool has_typedef(ModuleID moduleId, mdTypeDef typeDef) const noexcept
                 {
-                    return find_typedef(typeDef) != std::end(typedefNameMap);
+                    return typedefNameMap.Contains(ModuleAndTypeDef(moduleId, typeDef));
                 }
 
                 const TypeAndMethodNames& operator[](FunctionID fid) const
                 {
-                    const auto itr = find_fid(fid);
-                    return itr != std::end(fidNameMap) ? itr->second : TypeAndMethodNames::GetUnknownTypeAndMethodNames();
+                    const auto index = fidIndexMap.Find(fid);
+                    return index != nullptr ? fidNames[*index].names : TypeAndMethodNames::GetUnknownTypeAndMethodNames();
                 }
 
-                const std::shared_ptr<xstring_t> typename_for(mdTypeDef typeDef) const
+                const std::shared_ptr<xstring_t> typename_for(ModuleID moduleId, mdTypeDef typeDef) const
                 {
-                    const auto itr = find_typedef(typeDef);
-                    return itr != std::end(typedefNameMap) ? itr->second : TypeAndMethodNames::GetUnknownTypeName();
+                    const auto typeName = typedefNameMap.Find(ModuleAndTypeDef(moduleId, typeDef));
+                    return typeName != nullptr ? *typeName : TypeAndMethodNames::GetUnknownTypeName();
                 }
 
                 void clear() noexcept
                 {
-                    fidNameMap.clear();
-                    typedefNameMap.clear();
+                    fidNames.clear();
+                    fidIndexMap.Clear();
+                    typedefNameMap.Clear();
                 }
 
-                void insert(FunctionID functionId, mdTypeDef typeDef, const PreallocTypeName& typeName, const PreallocMethodName& methodName)
+                void insert(FunctionID functionId, ModuleID moduleId, mdTypeDef typeDef, const PreallocTypeName& typeName, const PreallocMethodName& methodName)
                 {
+                    //a function that shows up on several stacks of the same profile is only resolved once
+                    if (has_fid(functionId))
+                    {
+                        return;
+                    }
+
                     //PreallocTypeName/PreallocMethodName  .second is the actual length of the strings INCLUDING THE NULL terminator.  
                     //   .second-1 to exclude the null from the xstring_t
-                    auto itr = find_typedef(typeDef);
-                    if (std::end(typedefNameMap) == itr)
+                    const ModuleAndTypeDef typeKey(moduleId, typeDef);
+                    auto typeNameEntry = typedefNameMap.Find(typeKey);
+                    if (nullptr == typeNameEntry)
                     {
-                        itr = typedefNameMap.emplace(std::end(typedefNameMap), std::piecewise_construct, std::forward_as_tuple(typeDef), std::forward_as_tuple(std::make_shared<xstring_t>(typeName.first.data(), typeName.second - 1)));
+                        typedefNameMap.Insert(typeKey, std::make_shared<xstring_t>(typeName.first.data(), typeName.second - 1));
+                        typeNameEntry = typedefNameMap.Find(typeKey);
                     }
-                    fidNameMap.emplace_back(std::piecewise_construct, std::forward_as_tuple(functionId), std::forward_as_tuple(itr->second, xstring_t(methodName.first.data(), methodName.second - 1)));
+                    fidNames.push_back(FunctionNames{ functionId, moduleId, TypeAndMethodNames(*typeNameEntry, xstring_t(methodName.first.data(), methodName.second - 1)) });
+                    fidIndexMap.Insert(functionId, fidNames.size() - 1);
                 }
 
-            private:
+                //function ids and typedef tokens can be reused once their module has unloaded
+                template <typename ModuleSet>
+                void remove_modules(const ModuleSet& moduleIds)
+                {
+                    //TypeAndMethodNames can't be assigned, so the kept entries are copied into a new list and indexed again
+                    std::vector<FunctionNames> keptNames;
+                    for (const auto& entry : fidNames)
+                    {
+                        if (moduleIds.find(entry.moduleId) == std::end(moduleIds))
+                        {
+                            keptNames.push_back(entry);
+                        }
+                    }
+                    fidNames.swap(keptNames);
+
+                    fidIndexMap.Clear();
+                    for (std::size_t index = 0; index != fidNames.size(); ++index)
+                    {
+                        fidIndexMap.Insert(fidNames[index].functionId, index);
+                    }
 
-                FidNameMap::const_iterator find_fid(FunctionID fid) const
+                    typedefNameMap.EraseIf([&](const ModuleAndTypeDef& key, const std::shared_ptr<xstring_t>&) { return moduleIds.find(key.first) != std::end(moduleIds); });
+                }
+
+                std::size_t size() const noexcept
                 {
-                    return std::find_if(std::begin(fidNameMap), std::end(fidNameMap),
-                        [=](const FidNameMap::value_type& pr) noexcept { return pr.first == fid; });
+                    return fidNames.size();
                 }
 
-                TypedefNameMap::const_iterator find_typedef(mdTypeDef typeDef) const
+                //how full the function table is, lookups slow down as this approaches the table's maximum
+                double load_factor() const noexcept
                 {
-                    return std::find_if(std::begin(typedefNameMap), std::end(typedefNameMap),
-                        [=](const TypedefNameMap::value_type& pr) noexcept { return pr.first == typeDef; });
+                    return fidIndexMap.GetLoadFactor();
                 }
 
-                FidNameMap fidNameMap;
+                double typedef_load_factor() const noexcept
+                {
+                    return typedefNameMap.GetLoadFactor();
+                }
+
+            private:
+                std::vector<FunctionNames> fidNames;
+                FidIndexMap fidIndexMap;
                 TypedefNameMap typedefNameMap;
             };
         } // namespace ThreadProfiler
@@ -4,6 +4,7 @@
 
 using System;
 using System.Collections.Generic;
+using System.Diagnostics;
 using System.IO;
 using System.Reflection;
 using System.Runtime.CompilerServices;
@@ -72,4 +73,15 @@ public class CollectibleController : Controller
         Console.WriteLine($"{nameof(CollectAndFinalize)} was called {collectCount} time(s).");
         return hostAlcWeakRef.IsAlive ? StatusCode(500) : Ok();
     }
+
+    // Private bytes include the profiler's native allocations, which is where state kept for unloaded modules would pile up.
+    public string PrivateMemoryAfterCollect()
+    {
+        GC.Collect();
+        GC.WaitForPendingFinalizers();
+        GC.Collect();
+
+        using var process = Process.GetCurrentProcess();
+        return process.PrivateMemorySize64.ToString();
+    }
 }
@@ -0,0 +1,91 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using NewRelic.Agent.IntegrationTestHelpers;
+using Xunit;
+
+namespace NewRelic.Agent.IntegrationTests.AspNetCore;
+
+// Loads and unloads an instrumented collectible assembly over and over, as a plugin host would.  The profiler
+// drops what it kept for each module once the module unloads, so memory should level off after the warm-up.  Rather
+// than hold memory under a fixed size, which depends on the runtime and the machine, the soak runs as two windows of
+// the same number of loads: a leak grows memory by about as much in the second window as in the first, while memory
+// that has leveled off grows by much less.
+public class AspNetCoreCollectibleAssemblyContextSoakTests : NewRelicIntegrationTest<RemoteServiceFixtures.AspNetCoreFeaturesFixture>
+{
+    private readonly RemoteServiceFixtures.AspNetCoreFeaturesFixture _fixture;
+
+    private const int WarmUpCount = 20;
+    private const int WindowCount = 150;
+
+    // the second window may grow by half as much as the first, and by a small share of the steady-state memory
+    // whatever the first did, because collecting doesn't bring memory back to the same byte
+    private const double MaxSecondWindowGrowthRatio = 0.5;
+    private const double NoiseRatio = 0.02;
+
+    private long _privateMemoryAfterWarmUp;
+    private long _privateMemoryAfterFirstWindow;
+    private long _privateMemoryAfterSecondWindow;
+
+    public AspNetCoreCollectibleAssemblyContextSoakTests(RemoteServiceFixtures.AspNetCoreFeaturesFixture fixture, ITestOutputHelper output)
+        : base(fixture)
+    {
+        _fixture = fixture;
+        _fixture.TestLogger = output;
+        _fixture.Actions
+        (
+            setupConfiguration: () =>
+            {
+                var configPath = fixture.DestinationNewRelicConfigFilePath;
+                var configModifier = new NewRelicConfigModifier(configPath);
+                configModifier.SetLogLevel("info");
+            },
+            exerciseApplication: () =>
+            {
+                for (var i = 0; i < WarmUpCount; i++)
+                    _fixture.AccessCollectible();
+                _privateMemoryAfterWarmUp = _fixture.GetPrivateMemoryAfterCollect();
+
+                for (var i = 0; i < WindowCount; i++)
+                    _fixture.AccessCollectible();
+                _privateMemoryAfterFirstWindow = _fixture.GetPrivateMemoryAfterCollect();
+
+                for (var i = 0; i < WindowCount; i++)
+                    _fixture.AccessCollectible();
+                _privateMemoryAfterSecondWindow = _fixture.GetPrivateMemoryAfterCollect();
+
+                _fixture.TestLogger?.WriteLine($"Private bytes after warm-up: {_privateMemoryAfterWarmUp}, after each window of {WindowCount} loads and unloads: {_privateMemoryAfterFirstWindow}, {_privateMemoryAfterSecondWindow}");
+            }
+        );
+        _fixture.Initialize();
+    }
+
+    [Fact]
+    public void MemoryLevelsOff()
+    {
+        var firstWindowGrowth = _privateMemoryAfterFirstWindow - _privateMemoryAfterWarmUp;
+        var secondWindowGrowth = _privateMemoryAfterSecondWindow - _privateMemoryAfterFirstWindow;
+        var allowedGrowth = Math.Max(firstWindowGrowth * MaxSecondWindowGrowthRatio, _privateMemoryAfterFirstWindow * NoiseRatio);
+
+        Assert.True(secondWindowGrowth <= allowedGrowth,
+            $"Private bytes grew by {firstWindowGrowth} and then by {secondWindowGrowth} over two windows of {WindowCount} collectible assembly loads and unloads, more than the {allowedGrowth:F0} allowed for the second.");
+    }
+
+    [Fact]
+    public void EveryLoadWasInstrumented()
+    {
+        var metrics = _fixture.AgentLog.GetMetrics().ToList();
+
+        // the collectible assembly calls the agent api from its instrumented method, so each load shows up here
+        var expectedMetrics = new List<Assertions.ExpectedMetric>
+        {
+            new Assertions.ExpectedMetric { metricName = @"DotNet/CollectibleController/AccessCollectible", CallCountAllHarvests = WarmUpCount + 2 * WindowCount },
+            new Assertions.ExpectedMetric { metricName = @"Supportability/ApiInvocation/InsertDistributedTraceHeaders", CallCountAllHarvests = WarmUpCount + 2 * WindowCount },
+        };
+        Assertions.MetricsExist(expectedMetrics, metrics);
+    }
+}
@@ -41,6 +41,12 @@ public class AspNetCoreFeaturesFixture : RemoteApplicationFixture
         _httpClient.GetStringAsync(address).Wait();
     }
 
+    public long GetPrivateMemoryAfterCollect()
+    {
+        var address = $"http://{DestinationServerName}:{Port}/Collectible/PrivateMemoryAfterCollect";
+        return long.Parse(GetStringAndAssertIsNotNull(address));
+    }
+
     public void AsyncStream()
     {
         var address = $"http://{DestinationServerName}:{Port}/api/AsyncStream";
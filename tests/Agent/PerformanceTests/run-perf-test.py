@@ -196,6 +196,34 @@ def get_agent_log_error_lines(content: str) -> list[str]:
     return [line.rstrip() for line in content.splitlines() if error_pattern.search(line)]
 
 
+def _parse_docker_timestamp(value):
+    """Parse a Docker RFC 3339 timestamp, which carries nanoseconds that datetime can't hold."""
+    value = value.strip().rstrip("Z")
+    if "." in value:
+        seconds, fraction = value.split(".", 1)
+        value = f"{seconds}.{fraction[:6]}"
+    return datetime.fromisoformat(value).replace(tzinfo=timezone.utc)
+
+
+def measure_startup_seconds(timeout_seconds=60):
+    """Poll /health from inside the test app container and return the seconds between the container
+    starting and the first successful response, or None if it never answered.
+
+    Docker's own health check only runs every few seconds, which is too coarse to compare startup
+    times, so this polls directly."""
+    deadline = time.monotonic() + timeout_seconds
+    while time.monotonic() < deadline:
+        _, returncode = run_output(
+            ["docker", "exec", "perf-testapp", "curl", "-sf", "-o", "/dev/null", "http://localhost:8080/health"]
+        )
+        if returncode == 0:
+            answered_at = datetime.now(timezone.utc)
+            started_at, _ = run_output(["docker", "inspect", "perf-testapp", "--format", "{{.State.StartedAt}}"])
+            return (answered_at - _parse_docker_timestamp(started_at)).total_seconds()
+        time.sleep(0.25)
+    return None
+
+
 # ---------------------------------------------------------------------------
 # Docker stats background thread
 # ---------------------------------------------------------------------------
@@ -315,6 +343,16 @@ def main():
         print(logs_proc.stderr)
         sys.exit(1)
 
+    # --- Measure startup time ---
+    startup_seconds = measure_startup_seconds()
+    if startup_seconds is None:
+        print("WARNING: Unable to measure test app startup time.")
+    else:
+        print(f"Test app answered /health {startup_seconds:.2f}s after its container started.")
+        with open("results/startup.csv", "w", encoding="utf-8") as f:
+            f.write("startup_seconds\n")
+            f.write(f"{startup_seconds:.3f}\n")
+
     # --- Wait for test app to become healthy ---
     print("Waiting for test app to become healthy...")
     deadline = time.monotonic() + 60
@@ -402,6 +440,9 @@ def main():
         if docker_table:
             summary_lines += ["", f"### Docker Stats ({stats_samples} samples)", "", docker_table]
 
+    if startup_seconds is not None:
+        summary_lines += ["", f"**Startup:** first /health response {startup_seconds:.2f}s after container start"]
+
     summary_lines += [
         "",
         "**Run configuration:**",
@@ -0,0 +1,98 @@
+// Copyright 2020 New Relic, Inc. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+using System;
+using NUnit.Framework;
+using Telerik.JustMock;
+
+namespace NewRelic.Agent.Core.Instrumentation;
+
+[TestFixture]
+public class InstrumentationServiceTests
+{
+    private const int E_FAIL = unchecked((int)0x80004005);
+
+    private INativeMethods _nativeMethods;
+    private InstrumentationService _instrumentationService;
+
+    [SetUp]
+    public void SetUp()
+    {
+        _nativeMethods = Mock.Create<INativeMethods>();
+        _instrumentationService = new InstrumentationService(_nativeMethods);
+    }
+
+    [Test]
+    public void WaitForInstrumentationRefresh_ReturnsTrue_WhenEveryRequestedRefreshHasCompleted()
+    {
+        ulong requested = 3;
+        ulong completed = 3;
+        Mock.Arrange(() => _nativeMethods.GetInstrumentationRefreshStatus(out requested, out completed)).Returns(0);
+
+        var finished = _instrumentationService.WaitForInstrumentationRefresh(TimeSpan.FromMinutes(1), out var result);
+
+        Assert.Multiple(() =>
+        {
+            Assert.That(finished, Is.True);
+            Assert.That(result, Is.EqualTo(0));
+        });
+        Mock.Assert(() => _nativeMethods.GetInstrumentationRefreshStatus(out requested, out completed), Occurs.Once());
+    }
+
+    [Test]
+    public void WaitForInstrumentationRefresh_ReturnsTheResultOfTheLastRefresh()
+    {
+        ulong requested = 1;
+        ulong completed = 1;
+        Mock.Arrange(() => _nativeMethods.GetInstrumentationRefreshStatus(out requested, out completed)).Returns(1);
+
+        var finished = _instrumentationService.WaitForInstrumentationRefresh(TimeSpan.FromMinutes(1), out var result);
+
+        Assert.Multiple(() =>
+        {
+            Assert.That(finished, Is.True);
+            Assert.That(result, Is.EqualTo(1));
+        });
+    }
+
+    [Test]
+    public void WaitForInstrumentationRefresh_ReturnsFalse_WhenTheRefreshDoesNotFinishBeforeTheTimeout()
+    {
+        ulong requested = 2;
+        ulong completed = 1;
+        Mock.Arrange(() => _nativeMethods.GetInstrumentationRefreshStatus(out requested, out completed)).Returns(0);
+
+        var finished = _instrumentationService.WaitForInstrumentationRefresh(TimeSpan.FromMilliseconds(300), out _);
+
+        Assert.That(finished, Is.False);
+        Mock.Assert(() => _nativeMethods.GetInstrumentationRefreshStatus(out requested, out completed), Occurs.AtLeast(2));
+    }
+
+    [Test]
+    public void WaitForInstrumentationRefresh_ReturnsFalse_WithAZeroTimeout_WhenARefreshIsPending()
+    {
+        ulong requested = 2;
+        ulong completed = 1;
+        Mock.Arrange(() => _nativeMethods.GetInstrumentationRefreshStatus(out requested, out completed)).Returns(0);
+
+        var finished = _instrumentationService.WaitForInstrumentationRefresh(TimeSpan.Zero, out _);
+
+        Assert.That(finished, Is.False);
+    }
+
+    [Test]
+    public void WaitForInstrumentationRefresh_StopsWaiting_WhenTheStatusCannotBeRead()
+    {
+        ulong requested = 0;
+        ulong completed = 0;
+        Mock.Arrange(() => _nativeMethods.GetInstrumentationRefreshStatus(out requested, out completed)).Returns(E_FAIL);
+
+        var finished = _instrumentationService.WaitForInstrumentationRefresh(TimeSpan.FromMinutes(1), out var result);
+
+        Assert.Multiple(() =>
+        {
+            Assert.That(finished, Is.True);
+            Assert.That(result, Is.EqualTo(E_FAIL));
+        });
+    }
+}
@@ -107,6 +107,114 @@ public class ThreadProfilingSamplerTests
     }
 
 
+    [Test]
+    public async Task EachProfile_LogsItsTimings()
+    {
+        // Arrange
+        uint frequencyInMsec = 100;
+        uint durationInMsec = 1000;
+
+        int length = 0;
+        IntPtr snapshots = IntPtr.Zero;
+        Mock.Arrange(() => _nativeMethods.RequestProfile(out snapshots, out length)).Returns(0);
+
+        var timings = new ProfileTimings
+        {
+            SnapshotCount = 1,
+            ThreadCount = 12,
+            PauseCount = 2,
+            TotalPauseMicroseconds = 900,
+            LongestPauseMicroseconds = 500,
+            SnapshotMicroseconds = 1100,
+            ResolvedFunctionCount = 40,
+            ResolveMicroseconds = 3000
+        };
+        Mock.Arrange(() => _nativeMethods.GetProfileTimings(out timings)).Returns(0).OccursAtLeast(1);
+
+        // Act
+        using (var logging = new TestUtilities.Logging())
+        {
+            _threadProfiler.Start(frequencyInMsec, durationInMsec, _sampleSink, _nativeMethods);
+            await Task.Delay(1500);
+            _threadProfiler.Stop();
+
+            // Assert
+            Mock.Assert(_nativeMethods);
+            Assert.That(logging.HasMessageBeginningWith("Thread profile of 12 threads paused the runtime 2 times for 900us, the longest 500us."), Is.True);
+        }
+    }
+
+    [Test]
+    public void SwapCallTree_ReadsEveryNode()
+    {
+        // Arrange
+        int length = 2;
+        var nodes = Marshal.AllocHGlobal(CallTreeNode.NativeSize * length);
+
+        // the root
+        Marshal.WriteInt64(nodes, 0); // function id
+        Marshal.WriteInt64(nodes, 8, 0); // tag
+        Marshal.WriteInt64(nodes, 16, 3000); // cpu time
+        Marshal.WriteInt64(nodes, 24, 0); // self cpu time
+        Marshal.WriteInt32(nodes, 32, -1); // parent index
+        Marshal.WriteInt32(nodes, 36, 3); // hit count
+        Marshal.WriteInt32(nodes, 40, 0); // self hit count
+        Marshal.WriteInt32(nodes, 44, 2); // running hit count
+
+        // a tag under the root
+        var tagNode = nodes + CallTreeNode.NativeSize;
+        Marshal.WriteInt64(tagNode, 0);
+        Marshal.WriteInt64(tagNode, 8, unchecked((long)0xFEDCBA9876543210));
+        Marshal.WriteInt64(tagNode, 16, 2000);
+        Marshal.WriteInt64(tagNode, 24, 500);
+        Marshal.WriteInt32(tagNode, 32, 0);
+        Marshal.WriteInt32(tagNode, 36, 2);
+        Marshal.WriteInt32(tagNode, 40, 1);
+        Marshal.WriteInt32(tagNode, 44, 1);
+
+        Mock.Arrange(() => _nativeMethods.SwapCallTree(out nodes, out length)).Returns(0);
+
+        // Act
+        var callTree = _threadProfiler.SwapCallTree(out var hresult);
+
+        // Assert
+        Assert.That(hresult, Is.EqualTo(0));
+        Assert.That(callTree, Has.Length.EqualTo(2));
+        Assert.Multiple(() =>
+        {
+            Assert.That(callTree[0].FunctionId, Is.EqualTo(UIntPtr.Zero));
+            Assert.That(callTree[0].ParentIndex, Is.EqualTo(-1));
+            Assert.That(callTree[0].HitCount, Is.EqualTo(3));
+            Assert.That(callTree[0].RunningHitCount, Is.EqualTo(2));
+            Assert.That(callTree[0].CpuTimeNanoseconds, Is.EqualTo(3000));
+            Assert.That(callTree[1].Tag, Is.EqualTo(0xFEDCBA9876543210));
+            Assert.That(callTree[1].CpuTimeNanoseconds, Is.EqualTo(2000));
+            Assert.That(callTree[1].SelfCpuTimeNanoseconds, Is.EqualTo(500));
+            Assert.That(callTree[1].ParentIndex, Is.EqualTo(0));
+            Assert.That(callTree[1].HitCount, Is.EqualTo(2));
+            Assert.That(callTree[1].SelfHitCount, Is.EqualTo(1));
+            Assert.That(callTree[1].RunningHitCount, Is.EqualTo(1));
+        });
+
+        Marshal.FreeHGlobal(nodes);
+    }
+
+    [Test]
+    public void SwapCallTree_WhenTheProfilerFails_ReturnsNoNodes()
+    {
+        // Arrange
+        int length = 5;
+        IntPtr nodes = IntPtr.Zero;
+        Mock.Arrange(() => _nativeMethods.SwapCallTree(out nodes, out length)).Returns(unchecked((int)0x8000FFFF));
+
+        // Act
+        var callTree = _threadProfiler.SwapCallTree(out var hresult);
+
+        // Assert
+        Assert.That(hresult, Is.LessThan(0));
+        Assert.That(callTree, Is.Empty);
+    }
+
     [Test]
     public void Start_WhenWorkerIsAlreadyRunning_ShouldNotStartAnotherWorker()
     {